@@ -17,33 +17,181 @@ const static char ascii_table[] = ASCII_TABLE;
 
 const static size_t ascii_table_length = CPYMO_ARR_COUNT(ascii_table) - 1;
 
+// Escapes written for the frame.
 static char *framebuffer_ascii = NULL;
 
-static error_t cpymo_backend_ascii_write_string(const char *str)
+// Cells shown on the terminal, only cells that differ are written again.
+typedef struct {
+    uint8_t r, g, b;
+    char ascii;
+} cpymo_backend_ascii_cell;
+
+static cpymo_backend_ascii_cell *cells = NULL;
+static size_t cells_w = 0, cells_h = 0;
+
+// When false the terminal does not show the cells anymore,
+// the next frame clears it and writes every cell.
+static bool cells_valid = false;
+
+// When true messages were printed over the cells,
+// the next frame writes every cell without clearing the terminal.
+static bool cells_covered = false;
+
+static size_t term_w = 0, term_h = 0;
+
+static void cpymo_backend_ascii_write(const char *str, size_t len)
 {
-    while (*str) {
-        arrput(framebuffer_ascii, *str);
-        str++;
-    }
+    size_t old_len = arrlenu(framebuffer_ascii);
+    arrsetlen(framebuffer_ascii, old_len + len);
+    memcpy(framebuffer_ascii + old_len, str, len);
+}
+
+static void cpymo_backend_ascii_write_string(const char *str)
+{
+    cpymo_backend_ascii_write(str, strlen(str));
+}
+
+static void cpymo_backend_ascii_write_uint(unsigned x)
+{
+    char buf[16];
+    char *p = buf + sizeof(buf);
 
-	return CPYMO_ERR_SUCC;
+    do {
+        *--p = (char)('0' + x % 10);
+        x /= 10;
+    } while (x);
+
+    cpymo_backend_ascii_write(p, buf + sizeof(buf) - p);
 }
 
 void cpymo_backend_ascii_clean(void)
 {
     arrfree(framebuffer_ascii);
+    if (cells) free(cells);
+    cells = NULL;
+    cells_w = cells_h = 0;
+    cells_valid = false;
+    cells_covered = false;
+}
+
+// True when the whole screen has to be drawn again,
+// after Ctrl+L is pressed or the terminal is resized.
+bool cpymo_backend_ascii_take_redraw_request(void)
+{
+    extern void get_winsize(size_t *w, size_t *h);
+    extern bool cpymo_backend_input_redraw_requested;
+
+    bool redraw = cpymo_backend_input_redraw_requested;
+    cpymo_backend_input_redraw_requested = false;
+
+    size_t w, h;
+    get_winsize(&w, &h);
+    if (w != term_w || h != term_h) {
+        term_w = w;
+        term_h = h;
+        redraw = true;
+    }
+
+    if (redraw) cells_valid = false;
+    return redraw;
 }
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#include <errno.h>
 #endif
 
+#ifdef __linux__
+#include <stdio_ext.h>
+#endif
+
+// stdout is fully buffered by main(), so messages printed by the engine
+// since the last frame are still pending here.
+// Where the pending bytes can not be seen, messages are assumed every frame.
+static bool cpymo_backend_ascii_stdout_pending(void)
+{
+#if defined __linux__
+    return __fpending(stdout) > 0;
+#elif defined __APPLE__ || defined __FreeBSD__
+    return stdout->_p > stdout->_bf._base;
+#else
+    return true;
+#endif
+}
+
+static void cpymo_backend_ascii_flush(bool messages)
+{
+    #ifdef _WIN32
+    WriteConsoleA(
+        GetStdHandle(STD_OUTPUT_HANDLE), 
+        framebuffer_ascii, 
+        (DWORD)arrlenu(framebuffer_ascii), 
+        NULL, 
+        NULL);
+
+    #else
+    const char *p = framebuffer_ascii;
+    size_t remain = arrlenu(framebuffer_ascii);
+    while (remain) {
+        ssize_t written = write(STDOUT_FILENO, p, remain);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        p += written;
+        remain -= (size_t)written;
+    }
+    #endif
+
+    if (messages) fflush(stdout);
+}
+
 void cpymo_backend_ascii_submit_framebuffer(
     const cpymo_backend_software_image *framebuffer)
 {
     arrsetlen(framebuffer_ascii, 0);
-    
-    char buf[32];
+
+    if (cells_w != framebuffer->w || cells_h != framebuffer->h) {
+        if (cells) free(cells);
+        cells_w = cells_h = 0;
+        cells_valid = false;
+
+        cells = (cpymo_backend_ascii_cell *)malloc(
+            sizeof(cpymo_backend_ascii_cell) * framebuffer->w * framebuffer->h);
+        if (cells == NULL) return;
+
+        cells_w = framebuffer->w;
+        cells_h = framebuffer->h;
+    }
+
+    bool messages = false;
+    if (!cells_valid) {
+        // Anything pending, such as the reset written by main(),
+        // goes before the terminal is cleared.
+        fflush(stdout);
+
+        // No character is '\0', so every cell is written.
+        memset(cells, 0, sizeof(cpymo_backend_ascii_cell) * cells_w * cells_h);
+        cpymo_backend_ascii_write_string("\033[0m\033[2J");
+        cells_valid = true;
+        cells_covered = false;
+    }
+    else {
+        if (cells_covered) {
+            memset(cells, 0, sizeof(cpymo_backend_ascii_cell) * cells_w * cells_h);
+            cells_covered = false;
+        }
+
+        messages = cpymo_backend_ascii_stdout_pending();
+    }
+
+    // Escapes only when the cursor or color changes.
+    size_t cursor_x = 0, cursor_y = 0;
+    bool cursor_known = false, color_known = false;
+    cpymo_color cur_col = { 0, 0, 0 };
 
     for (size_t y = 0; y < framebuffer->h; ++y) {
         for (size_t x = 0; x < framebuffer->w; ++x) {
@@ -61,32 +209,58 @@ void cpymo_backend_ascii_submit_framebuffer(
             char ascii = 
                 ascii_table[(size_t)(brightness * (ascii_table_length - 1))];
 
-            sprintf(buf, "\033[38;2;%u;%u;%um%c\033[0m", 
-                col.r, col.g, col.b, ascii);
-            cpymo_backend_ascii_write_string(buf);
-        }
+            cpymo_backend_ascii_cell *cell = &cells[y * cells_w + x];
+            if (cell->ascii == ascii && 
+                cell->r == col.r && cell->g == col.g && cell->b == col.b)
+                continue;
 
-        if (y != framebuffer->h - 1)
-            cpymo_backend_ascii_write_string("\n");
-    }
+            cell->r = col.r;
+            cell->g = col.g;
+            cell->b = col.b;
+            cell->ascii = ascii;
 
-    sprintf(buf, "\033[%dA\033[%dD", 
-        (int)framebuffer->w,
-        (int)framebuffer->h);
-    cpymo_backend_ascii_write_string(buf);
+            if (!cursor_known || cursor_x != x || cursor_y != y) {
+                cpymo_backend_ascii_write_string("\033[");
+                cpymo_backend_ascii_write_uint((unsigned)y + 1);
+                cpymo_backend_ascii_write_string(";");
+                cpymo_backend_ascii_write_uint((unsigned)x + 1);
+                cpymo_backend_ascii_write_string("H");
+                cursor_known = true;
+            }
 
-    arrput(framebuffer_ascii, '\0');
+            if (!color_known || 
+                cur_col.r != col.r || cur_col.g != col.g || cur_col.b != col.b) {
+                cpymo_backend_ascii_write_string("\033[38;2;");
+                cpymo_backend_ascii_write_uint(col.r);
+                cpymo_backend_ascii_write_string(";");
+                cpymo_backend_ascii_write_uint(col.g);
+                cpymo_backend_ascii_write_string(";");
+                cpymo_backend_ascii_write_uint(col.b);
+                cpymo_backend_ascii_write_string("m");
+                cur_col = col;
+                color_known = true;
+            }
 
-    #ifdef _WIN32
-    WriteConsoleA(
-        GetStdHandle(STD_OUTPUT_HANDLE), 
-        framebuffer_ascii, 
-        arrlenu(framebuffer_ascii) - 1, 
-        NULL, 
-        NULL);
+            cpymo_backend_ascii_write(&ascii, 1);
 
-    #else
-    printf("%s", framebuffer_ascii);
-    #endif
-}
+            // The cursor stays on the last column instead of wrapping.
+            cursor_x = x + 1;
+            cursor_y = y;
+            if (cursor_x >= framebuffer->w) cursor_known = false;
+        }
+    }
+
+    if (messages) {
+        // Messages are printed from the bottom row after the frame,
+        // they may scroll the terminal and stay until the next frame
+        // writes every cell over them.
+        cpymo_backend_ascii_write_string("\033[0m\033[");
+        cpymo_backend_ascii_write_uint((unsigned)framebuffer->h);
+        cpymo_backend_ascii_write_string(";1H");
+        cells_covered = true;
+    }
+    else if (arrlenu(framebuffer_ascii) == 0) return;
+    else cpymo_backend_ascii_write_string("\033[0m");
 
+    cpymo_backend_ascii_flush(messages);
+}
@@ -46,6 +46,9 @@ static char getch(void)
 
 #endif
 
+// Set by Ctrl+L, the ascii-art backend draws the whole screen again.
+bool cpymo_backend_input_redraw_requested = false;
+
 cpymo_input cpymo_input_snapshot() 
 { 
     cpymo_input ret;
@@ -64,6 +67,7 @@ cpymo_input cpymo_input_snapshot()
         case 'J': ret.ok = true; break;
         case 'K': ret.cancel = true; break;
         case 'L': ret.skip = true; break;
+        case 12: cpymo_backend_input_redraw_requested = true; break;   // Ctrl+L
         };
     }
 
@@ -36,6 +36,12 @@ static cpymo_engine engine;
 static cpymo_backend_software_image render_target;
 static cpymo_backend_software_context context;
 
+// With -c, every frame is painted again in full into check_target
+// and compared with the damaged repaint of render_target.
+static cpymo_backend_software_image check_target;
+static bool check_damage = false;
+static unsigned check_frames = 0, check_mismatches = 0;
+
 static error_t init_context(void)
 {
     extern void get_winsize(size_t *w, size_t *h);
@@ -51,6 +57,16 @@ static error_t init_context(void)
         (uint8_t *)malloc(render_target.line_stride * render_target.h);
     
     if (render_target.pixels == NULL) return CPYMO_ERR_OUT_OF_MEM;
+
+    if (check_damage) {
+        check_target = render_target;
+        check_target.pixels = 
+            (uint8_t *)malloc(render_target.line_stride * render_target.h);
+        if (check_target.pixels == NULL) {
+            free(render_target.pixels);
+            return CPYMO_ERR_OUT_OF_MEM;
+        }
+    }
     
     context.logical_screen_w = (float)engine.gameconfig.imagesize_w;
     context.logical_screen_h = (float)engine.gameconfig.imagesize_h;
@@ -61,6 +77,8 @@ static error_t init_context(void)
     context.scale_on_load_image_h_ratio = 
         (float)render_target.h / context.logical_screen_h;
     context.render_target = &render_target;
+    cpymo_backend_software_clip(
+        &context, 0, 0, context.logical_screen_w, context.logical_screen_h);
 
     extern stbtt_fontinfo font;
     context.font = &font;
@@ -72,10 +90,33 @@ static error_t init_context(void)
 
 static void free_context(void)
 {
+    cpymo_backend_software_deferred_free(&context);
     free(render_target.pixels);
+    if (check_target.pixels) free(check_target.pixels);
     cpymo_backend_software_set_context(NULL);
 }
 
+static void check_damaged_repaint(void)
+{
+    context.render_target = &check_target;
+    cpymo_backend_software_clip(
+        &context, 0, 0, context.logical_screen_w, context.logical_screen_h);
+    cpymo_backend_software_clear_clip(&context);
+    cpymo_engine_draw(&engine);
+    cpymo_backend_software_flush(&context);
+    context.render_target = &render_target;
+
+    const size_t size = render_target.line_stride * render_target.h;
+    check_frames++;
+    if (memcmp(render_target.pixels, check_target.pixels, size) != 0) {
+        printf("[Error] Frame %u differs from a full repaint.\n", check_frames);
+        check_mismatches++;
+
+        // Keep showing the right frame.
+        memcpy(render_target.pixels, check_target.pixels, size);
+    }
+}
+
 #ifdef _WIN32
 #include <direct.h>
 #define mkdir(x, y) _mkdir(x)
@@ -90,13 +131,33 @@ static void ensure_save_dir(const char *gamedir)
 	mkdir(save_dir, 0777);
 }
 
+static void print_usage(void)
+{
+    puts("Usage: cpymo-ascii-art [-t <threads>] [-c] [gamedir]");
+    puts("    -t    Draw frames in bands on this many threads, 0 for one per CPU core.");
+    puts("    -c    Check every damaged repaint against a full repaint.");
+}
+
 int main(int argc, char **argv)
 {
     srand((unsigned)time(NULL));
 
     const char *gamedir = ".";
-    if (argc == 2) 
-        gamedir = argv[1];
+    int threads = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 0)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0)
+            check_damage = true;
+        else if (argv[i][0] == '-') {
+            print_usage();
+            return -1;
+        }
+        else gamedir = argv[i];
+    }
+
+    // Keep messages until the next frame, which draws over them.
+    setvbuf(stdout, NULL, _IOFBF, BUFSIZ);
     
     error_t err = cpymo_engine_init(&engine, gamedir);
     if (err != CPYMO_ERR_SUCC) {
@@ -127,6 +188,18 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    if (threads >= 0) {
+        err = cpymo_backend_software_deferred_init(&context, (unsigned)threads);
+        if (err != CPYMO_ERR_SUCC) {
+            cpymo_engine_free(&engine);
+            free_context();
+            cpymo_backend_font_free();
+            printf("[Error] cpymo_backend_software_deferred_init: %s.\n", 
+                cpymo_error_message(err));
+            return -1;
+        }
+    }
+
     int ret = 0;
 
     printf("\033c");
@@ -145,13 +218,22 @@ int main(int argc, char **argv)
             break;
         }
 
-        if (redraw) {
-            memset(
-                render_target.pixels, 
-                0, 
-                render_target.line_stride * render_target.h);
+        extern bool cpymo_backend_ascii_take_redraw_request(void);
+        if (cpymo_backend_ascii_take_redraw_request()) {
+            cpymo_engine_request_redraw(&engine);
+            redraw = true;
+        }
+
+        float x, y, w, h;
+        if (redraw && cpymo_engine_take_redraw_rect(&engine, &x, &y, &w, &h)) {
+            // render_target keeps the last frame, only repaint what changed.
+            cpymo_backend_software_clip(&context, x, y, w, h);
+            cpymo_backend_software_clear_clip(&context);
 
             cpymo_engine_draw(&engine);
+            cpymo_backend_software_flush(&context);
+
+            if (check_damage) check_damaged_repaint();
 
             extern void cpymo_backend_ascii_submit_framebuffer(
                 const cpymo_backend_software_image *framebuffer);
@@ -170,6 +252,12 @@ int main(int argc, char **argv)
     extern void cpymo_backend_ascii_clean(void);
     cpymo_backend_ascii_clean();
 
+    if (check_damage) {
+        printf("[Info] %u of %u frames differed from a full repaint.\n", 
+            check_mismatches, check_frames);
+        if (check_mismatches) ret = -1;
+    }
+
     #ifdef LEAKCHECK
     stb_leakcheck_dumpmem();
     #endif
@@ -0,0 +1,27 @@
+#ifndef INCLUDE_CPYMO_BACKEND_FONT
+#define INCLUDE_CPYMO_BACKEND_FONT
+
+#include "../../cpymo/cpymo_error.h"
+#include "../../cpymo/cpymo_str.h"
+#include <stb_truetype.h>
+
+// stb_truetype text rendering shared by backends,
+// implemented in sdl2/cpymo_backend_font.c.
+
+error_t cpymo_backend_font_init(const char *gamedir);
+void cpymo_backend_font_free(void);
+
+// Renders text as coverage into out_or_null, a buffer *w pixels wide,
+// and returns size of the text in *w and *h.
+// Pass NULL to only measure the text.
+void cpymo_backend_font_render(
+    void *out_or_null, int *w, int *h,
+    cpymo_str text, float scale, float baseline);
+
+// Same as cpymo_backend_font_render() but with another font.
+void cpymo_backend_font_render_ex(
+    const stbtt_fontinfo *font,
+    void *out_or_null, int *w, int *h,
+    cpymo_str text, float scale, float baseline);
+
+#endif
@@ -28,20 +28,7 @@ const cpymo_backend_audio_info *cpymo_backend_audio_get_info(void)
 
 static void cpymo_backend_audio_callback(void *userdata, Uint8 *stream, int len)
 {
-    memset(stream, 0, (size_t)len);
-	
-	for (size_t cid = 0; cid < CPYMO_AUDIO_MAX_CHANNELS; ++cid) {
-		void *samples = NULL;
-		size_t szlen = (size_t)len;
-		size_t written = 0;
-		float volume = cpymo_audio_get_channel_volume(cid, &engine.audio);
-
-		while (cpymo_audio_channel_get_samples(&samples, &szlen, cid, &engine.audio) && szlen) {
-			SDL_MixAudio(stream + written, (Uint8 *)samples, (Uint32)szlen, (int)(volume * SDL_MIX_MAXVOLUME));
-			written += szlen;
-			szlen = (size_t)len - written;
-		}
-	}
+    cpymo_audio_copy_mixed_samples(stream, (size_t)len, &engine.audio);
 }
 
 static inline bool cpymo_backend_audio_supported(const SDL_AudioSpec *spec)
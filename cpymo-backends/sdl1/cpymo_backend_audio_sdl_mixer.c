@@ -41,6 +41,12 @@ void cpymo_audio_free(cpymo_audio_system *s)
     Mix_Quit();
 }
 
+// SDL_mixer decodes and mixes by itself.
+void cpymo_audio_get_stats(cpymo_audio_stats *out, const cpymo_audio_system *s)
+{
+    memset(out, 0, sizeof(*out));
+}
+
 float cpymo_audio_get_channel_volume(size_t cid, const cpymo_audio_system *s)
 {
     if (!enabled)
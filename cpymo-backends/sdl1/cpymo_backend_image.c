@@ -423,6 +423,7 @@ static error_t cpymo_assetloader_load_image_surface(
 		error_t err = cpymo_package_stream_reader_find_create(&r, pkg, name);
 		CPYMO_THROW(err);
 
+		fseek(r.stream, (long)r.file_offset, SEEK_SET);
 		SDL_RWops *rwops = SDL_RWFromFP(r.stream, 0);
 		if (rwops == NULL) {
 			cpymo_package_stream_reader_close(&r);
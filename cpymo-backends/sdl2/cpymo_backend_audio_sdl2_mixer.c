@@ -25,8 +25,8 @@ static Mix_Music *bgm = NULL;
 static Mix_Chunk *se = NULL;
 static Mix_Chunk *vo = NULL;
 
-static void *se_data = NULL;
-static void *vo_data = NULL;
+static cpymo_package_view se_data = { NULL, 0, NULL };
+static cpymo_package_view vo_data = { NULL, 0, NULL };
 static SDL_RWops *se_rwops = NULL;
 static SDL_RWops *vo_rwops = NULL;
 
@@ -51,9 +51,9 @@ void cpymo_audio_init(cpymo_audio_system *s)
 	bgm = NULL;
 	se = NULL;
 	vo = NULL;
-	se_data = NULL;
+	cpymo_package_view_free(&se_data);
 	se_rwops = NULL;
-	vo_data = NULL;
+	cpymo_package_view_free(&vo_data);
 	vo_rwops = NULL;
 	
 	for (size_t i = 0; i < CPYMO_AUDIO_MAX_CHANNELS; ++i) {
@@ -95,6 +95,12 @@ void cpymo_audio_free(cpymo_audio_system *s)
 	}
 }
 
+// SDL2_mixer decodes and mixes by itself.
+void cpymo_audio_get_stats(cpymo_audio_stats *out, const cpymo_audio_system *s)
+{
+	memset(out, 0, sizeof(*out));
+}
+
 float cpymo_audio_get_channel_volume(size_t cid, const cpymo_audio_system *s)
 {
 	return volumes[cid];
@@ -201,21 +207,13 @@ error_t cpymo_audio_se_play(struct cpymo_engine *e, cpymo_str sename, bool loop)
 		error_t err = cpymo_package_find(&index, &e->assetloader.pkg_se, sename);
 		CPYMO_THROW(err);
 
-		se_data = malloc(index.file_length);
-		if (se_data == NULL) return CPYMO_ERR_OUT_OF_MEM;
-
-		err = cpymo_package_read_file_from_index(
-			(char *)se_data, &e->assetloader.pkg_se, &index);
-		if (err != CPYMO_ERR_SUCC) {
-			free(se_data);
-			se_data = NULL;
-			return err;
-		}
+		err = cpymo_package_view_from_index(
+			&se_data, &e->assetloader.pkg_se, &index);
+		CPYMO_THROW(err);
 
-		se_rwops = SDL_RWFromConstMem(se_data, index.file_length);
+		se_rwops = SDL_RWFromConstMem(se_data.data, index.file_length);
 		if (se_rwops == NULL) {
-			free(se_data);
-			se_data = NULL;
+			cpymo_package_view_free(&se_data);
 			return CPYMO_ERR_UNKNOWN;
 		}
 	}
@@ -236,8 +234,7 @@ error_t cpymo_audio_se_play(struct cpymo_engine *e, cpymo_str sename, bool loop)
 	if (se == NULL) {
 		SDL_RWclose(se_rwops);
 		se_rwops = NULL;
-		if (se_data) free(se_data);
-		se_data = NULL;
+		cpymo_package_view_free(&se_data);
 		SDL_Log("[Error] Can not load SE: %s\n", Mix_GetError());
 		return CPYMO_ERR_BAD_FILE_FORMAT;
 	}
@@ -266,8 +263,7 @@ void cpymo_audio_se_stop(struct cpymo_engine *e)
 	se_name = NULL;
 	if (se_rwops) SDL_RWclose(se_rwops);
 	se_rwops = NULL;
-	if (se_data) free(se_data);
-	se_data = NULL;
+	cpymo_package_view_free(&se_data);
 }
 
 error_t cpymo_audio_vo_play(struct cpymo_engine *e, cpymo_str voname)
@@ -281,22 +277,13 @@ error_t cpymo_audio_vo_play(struct cpymo_engine *e, cpymo_str voname)
 		error_t err = cpymo_package_find(&index, &e->assetloader.pkg_voice, voname);
 		CPYMO_THROW(err);
 
-		vo_data = malloc(index.file_length);
-		if (vo_data == NULL) return CPYMO_ERR_OUT_OF_MEM;
-		
-		err = cpymo_package_read_file_from_index(
-			(char *)vo_data, &e->assetloader.pkg_voice, &index);
-		
-		if (err != CPYMO_ERR_SUCC) {
-			free(vo_data);
-			vo_data = NULL;
-			return err;
-		}
-		
-		vo_rwops = SDL_RWFromConstMem(vo_data, (int)index.file_length);
+		err = cpymo_package_view_from_index(
+			&vo_data, &e->assetloader.pkg_voice, &index);
+		CPYMO_THROW(err);
+
+		vo_rwops = SDL_RWFromConstMem(vo_data.data, (int)index.file_length);
 		if (vo_rwops == NULL) {
-			free(vo_data);
-			vo_data = NULL;
+			cpymo_package_view_free(&vo_data);
 			return CPYMO_ERR_UNKNOWN;
 		}
 	}
@@ -318,8 +305,7 @@ error_t cpymo_audio_vo_play(struct cpymo_engine *e, cpymo_str voname)
 		SDL_Log("[Error] Can not load vo chunk: %s\n", Mix_GetError());
 		SDL_RWclose(vo_rwops);
 		vo_rwops = NULL;
-		if (vo_data) free(vo_data);
-		vo_data = NULL;
+		cpymo_package_view_free(&vo_data);
 		return CPYMO_ERR_BAD_FILE_FORMAT;
 	}
 	
@@ -336,8 +322,7 @@ void cpymo_audio_vo_stop(struct cpymo_engine *e)
 	vo = NULL;
 	if (vo_rwops) SDL_RWclose(vo_rwops);
 	vo_rwops = NULL;
-	if (vo_data) free(vo_data);
-	vo_data = NULL;
+	cpymo_package_view_free(&vo_data);
 }
 
 const char *cpymo_audio_get_bgm_name(struct cpymo_engine *e)
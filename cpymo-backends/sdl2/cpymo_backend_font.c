@@ -4,7 +4,11 @@
 #include <cpymo_error.h>
 #include <cpymo_utils.h>
 #include <cpymo_parser.h>
+#include <cpymo_backend_font.h>
+#include <cpymo_profiler.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 #ifdef __ANDROID__
 #include "cpymo_import_sdl2.h"
@@ -12,6 +16,7 @@
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb_truetype.h>
+#include <stb_ds.h>
 
 #ifdef __UWP__
 #include <malloc.h>
@@ -44,8 +49,11 @@ static error_t cpymo_backend_font_try_load_font(const char *path)
 	return CPYMO_ERR_SUCC;
 }
 
+static void cpymo_backend_font_glyph_cache_free(void);
+
 void cpymo_backend_font_free()
 {
+	cpymo_backend_font_glyph_cache_free();
 	if (ttf_buffer) free(ttf_buffer);
 	ttf_buffer = NULL;
 }
@@ -188,54 +196,282 @@ error_t cpymo_backend_font_init(const char *gamedir)
 #define TEXT_LINE_Y_OFFSET 0
 #endif
 
+// Rasterized glyphs are kept until the cache grows beyond this many bytes.
+// With ENABLE_PROFILER, its hits, misses, evictions and bytes are recorded 
+// as profiler counters whenever text is rendered.
+#ifndef CPYMO_BACKEND_FONT_GLYPH_CACHE_SIZE
+#define CPYMO_BACKEND_FONT_GLYPH_CACHE_SIZE (4 * 1024 * 1024)
+#endif
 
-void cpymo_backend_font_render(void *out_or_null, int *w, int *h, cpymo_str text, float scale, float baseline) 
+// Glyphs are rasterized at this many positions between two pixels.
+#ifndef CPYMO_BACKEND_FONT_SUBPIXEL_STEPS
+#define CPYMO_BACKEND_FONT_SUBPIXEL_STEPS 4
+#endif
+
+// Glyph indices and kerning pairs are looked up once,
+// both tables are emptied when they grow beyond this many entries.
+#ifndef CPYMO_BACKEND_FONT_KERN_CACHE_SIZE
+#define CPYMO_BACKEND_FONT_KERN_CACHE_SIZE 16384
+#endif
+
+// A codepoint and 0 for glyph indices, two glyph indices for kerning.
+typedef struct {
+	const stbtt_fontinfo *font;
+	int first, second;
+} cpymo_backend_font_lookup_key;
+
+typedef struct {
+	cpymo_backend_font_lookup_key key;
+	int value;
+} cpymo_backend_font_lookup;
+
+static cpymo_backend_font_lookup *glyph_index_cache = NULL, *kern_cache = NULL;
+
+static int cpymo_backend_font_cached_lookup(
+	cpymo_backend_font_lookup **cache, 
+	const stbtt_fontinfo *font, int first, int second, bool kern)
+{
+	cpymo_backend_font_lookup_key key;
+	key.font = font;
+	key.first = first;
+	key.second = second;
+
+	ptrdiff_t i = hmgeti(*cache, key);
+	if (i >= 0) return (*cache)[i].value;
+
+	int value = kern ? 
+		stbtt_GetGlyphKernAdvance(font, first, second) :
+		stbtt_FindGlyphIndex(font, first);
+
+	if (hmlen(*cache) >= CPYMO_BACKEND_FONT_KERN_CACHE_SIZE) hmfree(*cache);
+	hmput(*cache, key, value);
+	return value;
+}
+
+typedef struct {
+	const stbtt_fontinfo *font;
+	uint32_t codepoint;
+	float scale;
+	int subpixel;
+} cpymo_backend_font_glyph_key;
+
+typedef struct cpymo_backend_font_glyph {
+	cpymo_backend_font_glyph_key key;
+	int glyph, advance_width;
+	int x0, y0, x1, y1;
+
+	// (x1 - x0) * (y1 - y0) coverage, after rasterized is set.
+	bool rasterized;
+	unsigned char *bitmap;
+	size_t bytes;
+
+	// Least recently used glyphs are evicted first.
+	struct cpymo_backend_font_glyph *newer, *older;
+} cpymo_backend_font_glyph;
+
+static struct {
+	cpymo_backend_font_glyph_key key;
+	cpymo_backend_font_glyph *value;
+} *glyph_cache = NULL;
+
+static cpymo_backend_font_glyph *glyph_newest = NULL, *glyph_oldest = NULL;
+
+static struct {
+	unsigned hits, misses, evictions;
+	size_t glyphs, bytes;
+} glyph_stats;
+
+static void cpymo_backend_font_glyph_unlink(cpymo_backend_font_glyph *g)
+{
+	if (g->newer) g->newer->older = g->older;
+	else glyph_newest = g->older;
+
+	if (g->older) g->older->newer = g->newer;
+	else glyph_oldest = g->newer;
+}
+
+static void cpymo_backend_font_glyph_link_newest(cpymo_backend_font_glyph *g)
+{
+	g->newer = NULL;
+	g->older = glyph_newest;
+	if (glyph_newest) glyph_newest->newer = g;
+	else glyph_oldest = g;
+	glyph_newest = g;
+}
+
+// Evicts glyphs other than keep until the cache fits in budget bytes.
+static void cpymo_backend_font_glyph_evict(
+	size_t budget, const cpymo_backend_font_glyph *keep)
+{
+	while (glyph_stats.bytes > budget && glyph_oldest && glyph_oldest != keep) {
+		cpymo_backend_font_glyph *g = glyph_oldest;
+		cpymo_backend_font_glyph_unlink(g);
+		hmdel(glyph_cache, g->key);
+
+		glyph_stats.bytes -= g->bytes;
+		glyph_stats.glyphs--;
+		glyph_stats.evictions++;
+		if (g->bitmap) free(g->bitmap);
+		free(g);
+	}
+}
+
+static void cpymo_backend_font_glyph_cache_free(void)
+{
+	cpymo_backend_font_glyph_evict(0, NULL);
+	hmfree(glyph_cache);
+	hmfree(glyph_index_cache);
+	hmfree(kern_cache);
+}
+
+// Returned glyph is valid until the next call,
+// its bitmap is NULL if it can not be rasterized.
+static const cpymo_backend_font_glyph *cpymo_backend_font_get_glyph(
+	const stbtt_fontinfo *font, uint32_t codepoint, int glyph,
+	float scale, float x_shift, bool rasterize)
+{
+	static cpymo_backend_font_glyph uncached;
+
+	cpymo_backend_font_glyph_key key;
+	memset(&key, 0, sizeof(key));
+	key.font = font;
+	key.codepoint = codepoint;
+	key.scale = scale;
+	key.subpixel = (int)(x_shift * CPYMO_BACKEND_FONT_SUBPIXEL_STEPS);
+
+	float shift = (float)key.subpixel / CPYMO_BACKEND_FONT_SUBPIXEL_STEPS;
+
+	cpymo_backend_font_glyph *g = hmget(glyph_cache, key);
+	if (g) {
+		glyph_stats.hits++;
+		cpymo_backend_font_glyph_unlink(g);
+		cpymo_backend_font_glyph_link_newest(g);
+	}
+	else {
+		glyph_stats.misses++;
+		g = (cpymo_backend_font_glyph *)malloc(sizeof(*g));
+		if (g == NULL) {
+			g = &uncached;
+			if (g->bitmap) free(g->bitmap);
+		}
+
+		memset(g, 0, sizeof(*g));
+		g->key = key;
+		g->glyph = glyph;
+
+		int lsb;
+		stbtt_GetGlyphHMetrics(font, g->glyph, &g->advance_width, &lsb);
+		stbtt_GetGlyphBitmapBoxSubpixel(
+			font, g->glyph, scale, scale, shift, 0, &g->x0, &g->y0, &g->x1, &g->y1);
+
+		if (g != &uncached) {
+			g->bytes = sizeof(*g);
+			cpymo_backend_font_glyph_evict(
+				CPYMO_BACKEND_FONT_GLYPH_CACHE_SIZE - g->bytes, NULL);
+
+			hmput(glyph_cache, key, g);
+			cpymo_backend_font_glyph_link_newest(g);
+			glyph_stats.bytes += g->bytes;
+			glyph_stats.glyphs++;
+		}
+	}
+
+	if (rasterize && !g->rasterized) {
+		int w = g->x1 - g->x0, h = g->y1 - g->y0;
+		g->rasterized = true;
+
+		if (w > 0 && h > 0) {
+			size_t bitmap_bytes = (size_t)(w * h);
+			if (g != &uncached)
+				cpymo_backend_font_glyph_evict(
+					bitmap_bytes < CPYMO_BACKEND_FONT_GLYPH_CACHE_SIZE ?
+						CPYMO_BACKEND_FONT_GLYPH_CACHE_SIZE - bitmap_bytes : 0, g);
+
+			g->bitmap = (unsigned char *)malloc(bitmap_bytes);
+			if (g->bitmap) {
+				stbtt_MakeGlyphBitmapSubpixel(
+					font, g->bitmap, w, h, w, scale, scale, shift, 0, g->glyph);
+
+				if (g != &uncached) {
+					g->bytes += bitmap_bytes;
+					glyph_stats.bytes += bitmap_bytes;
+				}
+			}
+		}
+	}
+
+	return g;
+}
+
+void cpymo_backend_font_render_ex(
+	const stbtt_fontinfo *font,
+	void *out_or_null, int *w, int *h, 
+	cpymo_str text, float scale, float baseline) 
 {
 	float xpos = 0;
 
 	int width = 0, height = 0;
 	float y_base = 0;
+	int prev_glyph = -1;
 	while (text.len > 0) {
 		uint32_t codepoint = cpymo_str_utf8_try_head_to_utf32(&text);
-		int x0, y0, x1, y1;
-
-		int advance_width, lsb;
-		float x_shift = xpos - (float)floor(xpos);
-		stbtt_GetCodepointHMetrics(&font, (int)codepoint, &advance_width, &lsb);
 
 		if (codepoint == '\n') {
 			xpos = 0;
+			prev_glyph = -1;
 
 			y_base += baseline + TEXT_LINE_Y_OFFSET;
 
 			continue;
 		}
 
-		stbtt_GetCodepointBitmapBoxSubpixel(&font, (int)codepoint, scale, scale, x_shift, 0, &x0, &y0, &x1, &y1);
-		if (out_or_null) {
-			stbtt_MakeCodepointBitmapSubpixel(
-				&font,
-				(unsigned char *)out_or_null + (int)xpos + x0 + (int)(baseline + y0 + y_base) * *w,
-				x1 - x0, y1 - y0, *w, scale, scale, x_shift, 0, (int)codepoint);
-		}
+		const int glyph = cpymo_backend_font_cached_lookup(
+			&glyph_index_cache, font, (int)codepoint, 0, false);
+
+		// Kerning with previous character moves the subpixel position,
+		// so it is applied before the glyph is looked up.
+		if (prev_glyph >= 0)
+			xpos += scale * cpymo_backend_font_cached_lookup(
+				&kern_cache, font, prev_glyph, glyph, true);
+
+		const cpymo_backend_font_glyph *g = cpymo_backend_font_get_glyph(
+			font, codepoint, glyph, scale, xpos - (float)floor(xpos), out_or_null != NULL);
 
-		xpos += (advance_width * scale);
+		if (out_or_null && g->bitmap) {
+			int bw = g->x1 - g->x0;
+			unsigned char *dst = (unsigned char *)out_or_null 
+				+ (int)xpos + g->x0 + (int)(baseline + g->y0 + y_base) * *w;
 
-		cpymo_str text2 = text;
-		uint32_t next_char = cpymo_str_utf8_try_head_to_utf32(&text2);
-		if (next_char) {
-			xpos += scale * stbtt_GetCodepointKernAdvance(&font, codepoint, next_char);
+			for (int y = 0; y < g->y1 - g->y0; ++y)
+				memcpy(dst + y * *w, g->bitmap + y * bw, (size_t)bw);
 		}
 
+		xpos += (g->advance_width * scale);
+		prev_glyph = g->glyph;
+
 		int new_width = (int)ceil(xpos);
 		if (new_width > width) width = new_width;
 
-		int new_height = (int)((y1 - y0) + baseline + y_base);
+		int new_height = (int)((g->y1 - g->y0) + baseline + y_base);
 		if (new_height > height) height = new_height;
 	}
 
 	*w = width;
 	*h = height;
+
+#ifdef ENABLE_PROFILER
+	if (out_or_null) {
+		cpymo_profiler_counter("glyph_cache", "hits", glyph_stats.hits);
+		cpymo_profiler_counter("glyph_cache", "misses", glyph_stats.misses);
+		cpymo_profiler_counter("glyph_cache", "evictions", glyph_stats.evictions);
+		cpymo_profiler_counter("glyph_cache", "bytes", glyph_stats.bytes);
+	}
+#endif
+}
+
+void cpymo_backend_font_render(void *out_or_null, int *w, int *h, cpymo_str text, float scale, float baseline) 
+{
+	cpymo_backend_font_render_ex(&font, out_or_null, w, h, text, scale, baseline);
 }
 
 #endif
@@ -67,8 +67,6 @@ void cpymo_backend_masktrans_draw(cpymo_backend_masktrans mt, float t, bool is_f
 	if (SDL_LockTexture(m->tex, NULL, &pixels, &pitch) != 0)
 		return;
 
-	memset(pixels, 255, pitch * m->h);
-
 	const float radius = 0.25f;
 	t = t * (1.0f + 2 * radius) - radius;
 
@@ -76,26 +74,32 @@ void cpymo_backend_masktrans_draw(cpymo_backend_masktrans mt, float t, bool is_f
 	float t_top = t + radius;
 	float t_bottom = t - radius;
 #endif
-	
-	for (int y = 0; y < m->h; ++y) {
-		for (int x = 0; x < m->w; ++x) {
-			float mask =
-				(float)(((unsigned char*)m->mask)[y * m->w + x]) / 255;
-			mask = 1.0f - mask;
 
-			if (is_fade_in) mask = 1 - mask;
-			Uint32 *px = (Uint32 *)&((Uint8 *)pixels)[y * pitch + x * 4];
+	// Pixel for every value of mask at this t,
+	// black with the alpha of transition.
+	Uint32 lut[256];
+	for (int i = 0; i < 256; ++i) {
+		float mask = (float)i / 255;
+		mask = 1.0f - mask;
+
+		if (is_fade_in) mask = 1 - mask;
 
 #ifdef LOW_QUALITY_MASKTRANS
-			*px = mask > t ? 255 : 0;
+		lut[i] = mask > t ? 255 : 0;
 #else
-			if (mask > t_top) mask = 1.0f;
-			else if (mask < t_bottom) mask = 0.0f;
-			else mask = (mask - t_bottom) / (2 * radius);
+		if (mask > t_top) mask = 1.0f;
+		else if (mask < t_bottom) mask = 0.0f;
+		else mask = (mask - t_bottom) / (2 * radius);
 
-			*px = (Uint32)(mask * 255.0f);
+		lut[i] = (Uint32)(mask * 255.0f);
 #endif
-		}
+	}
+	
+	for (int y = 0; y < m->h; ++y) {
+		const unsigned char *mask = (unsigned char *)m->mask + y * m->w;
+		Uint32 *px = (Uint32 *)((Uint8 *)pixels + y * pitch);
+		for (int x = 0; x < m->w; ++x)
+			px[x] = lut[mask[x]];
 	}
 
 	SDL_UnlockTexture(m->tex);
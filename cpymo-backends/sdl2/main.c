@@ -15,6 +15,7 @@
 #include <cpymo_localization.h>
 #include <cpymo_msgbox_ui.h>
 #include <cpymo_interpreter.h>
+#include <cpymo_profiler.h>
 #include <string.h>
 #include <cpymo_backend_text.h>
 #include <time.h>
@@ -631,6 +632,11 @@ int main(int argc, char **argv)
 				#endif
 			}
 #endif
+#ifdef ENABLE_PROFILER
+			else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F9) {
+				cpymo_profiler_dump(CPYMO_PROFILER_TRACE_FILE);
+			}
+#endif
 #ifdef ENABLE_ALT_ENTER_FULLSCREEN
 			else if (event.type == SDL_KEYDOWN) {
 				if (event.key.keysym.sym == SDLK_RETURN && (event.key.keysym.mod & KMOD_ALT)) {
@@ -648,10 +654,10 @@ int main(int argc, char **argv)
 		bool need_to_redraw = false;
 
 		Uint32 ticks = SDL_GetTicks();
-		err = cpymo_engine_update(
+		CPYMO_PROFILE("engine_update", err = cpymo_engine_update(
 			&engine, 
 			(float)(ticks - prev_ticks) * 0.001f, 
-			&need_to_redraw);
+			&need_to_redraw));
 
 		switch (err) {
 		case CPYMO_ERR_SUCC: break;
@@ -676,7 +682,7 @@ int main(int argc, char **argv)
 			SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
 			SDL_RenderClear(renderer);
 
-			cpymo_engine_draw(&engine);
+			CPYMO_PROFILE("engine_draw", cpymo_engine_draw(&engine));
 
 #ifdef ENABLE_SCREEN_FORCE_CENTERED
 			const float game_w = engine.gameconfig.imagesize_w;
@@ -696,7 +702,7 @@ int main(int argc, char **argv)
 				cpymo_backend_image_draw_type_bg);
 #endif
 
-			SDL_RenderPresent(renderer);
+			CPYMO_PROFILE("present", SDL_RenderPresent(renderer));
 			if (redraw_by_event) redraw_by_event--;
 			//fps_counter++;
 		}
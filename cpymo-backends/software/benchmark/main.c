@@ -0,0 +1,449 @@
+#include <cpymo_prelude.h>
+#include <cpymo_backend_image.h>
+#include <cpymo_backend_masktrans.h>
+#include "../cpymo_backend_software.h"
+#include <cpymo_thread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize.h>
+
+#define STB_DS_IMPLEMENTATION
+#include <stb_ds.h>
+
+// Measures how fast the software backend fills the render target
+// for the draws a game does most: backgrounds, charas, fades and masktrans,
+// then how deferred drawing of a 1080p frame scales with threads.
+// With -c it checks the vectorized row kernels against the scalar ones,
+// and deferred drawing against immediate drawing.
+
+#define SCREEN_W 540
+#define SCREEN_H 360
+
+#define LARGE_SCREEN_W 1920
+#define LARGE_SCREEN_H 1080
+
+static cpymo_backend_software_image render_target;
+static cpymo_backend_software_context context;
+
+#ifdef _WIN32
+#include <windows.h>
+static uint64_t micros()
+{
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / (double)freq.QuadPart * 1000000.0);
+}
+#else
+static uint64_t micros()
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return ((uint64_t) now.tv_sec) * 1000000 + ((uint64_t) now.tv_nsec) / 1000;
+}
+#endif
+
+static cpymo_backend_image create_image(int w, int h, bool alpha)
+{
+    const size_t channels = alpha ? 4 : 3;
+    uint8_t *px = (uint8_t *)malloc((size_t)w * h * channels);
+    if (px == NULL) {
+        printf("[Error] Out of memory.\n");
+        exit(-1);
+    }
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            uint8_t *p = px + ((size_t)y * w + x) * channels;
+            p[0] = (uint8_t)(x + y);
+            p[1] = (uint8_t)(x * 3);
+            p[2] = (uint8_t)(y * 5);
+
+            // Like a chara: transparent around, opaque body, soft edges.
+            if (alpha) {
+                int edge = x < w / 2 ? x : w - 1 - x;
+                p[3] = edge < w / 8 ? 0 : (edge < w / 8 + 16 ? (uint8_t)((edge - w / 8) * 16) : 255);
+            }
+        }
+    }
+
+    cpymo_backend_image img;
+    error_t err = cpymo_backend_image_load(
+        &img, px, w, h, 
+        alpha ? cpymo_backend_image_format_rgba : cpymo_backend_image_format_rgb);
+    if (err != CPYMO_ERR_SUCC) {
+        printf("[Error] cpymo_backend_image_load: %s.\n", cpymo_error_message(err));
+        exit(-1);
+    }
+
+    return img;
+}
+
+static cpymo_backend_masktrans create_masktrans(int w, int h)
+{
+    uint8_t *mask = (uint8_t *)malloc((size_t)w * h);
+    if (mask == NULL) {
+        printf("[Error] Out of memory.\n");
+        exit(-1);
+    }
+
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            mask[y * w + x] = (uint8_t)((x + y) * 255 / (w + h));
+
+    cpymo_backend_masktrans m;
+    error_t err = cpymo_backend_masktrans_create(&m, mask, w, h);
+    if (err != CPYMO_ERR_SUCC) {
+        printf("[Error] cpymo_backend_masktrans_create: %s.\n", cpymo_error_message(err));
+        exit(-1);
+    }
+
+    return m;
+}
+
+static void report(const char *name, uint64_t us, double pixels, int times)
+{
+    if (us == 0) us = 1;
+    printf("%-28s %10.1f Mpx/s %10.3f ms/draw\n", 
+        name, pixels / us, us / 1000.0 / times);
+}
+
+static void run(
+    const char *name, cpymo_backend_image img, int w, int h,
+    float dstx, float dsty, float dstw, float dsth, float alpha, 
+    enum cpymo_backend_image_draw_type type, int times)
+{
+    uint64_t begin = micros();
+    for (int i = 0; i < times; ++i)
+        cpymo_backend_image_draw(
+            dstx, dsty, dstw, dsth, img, 0, 0, w, h, alpha, type);
+    report(name, micros() - begin, (double)dstw * dsth * times, times);
+}
+
+static void run_fill(const char *name, float alpha, int times)
+{
+    const float xywh[] = { 0, 0, SCREEN_W, SCREEN_H };
+    uint64_t begin = micros();
+    for (int i = 0; i < times; ++i)
+        cpymo_backend_image_fill_rects(
+            xywh, 1, cpymo_color_white, alpha, cpymo_backend_image_draw_type_bg);
+    report(name, micros() - begin, (double)SCREEN_W * SCREEN_H * times, times);
+}
+
+static void run_masktrans(
+    const char *name, cpymo_backend_masktrans m, int times)
+{
+    uint64_t begin = micros();
+    for (int i = 0; i < times; ++i)
+        cpymo_backend_masktrans_draw(m, (float)i / (float)times, true);
+    report(name, micros() - begin, (double)SCREEN_W * SCREEN_H * times, times);
+}
+
+// A frame of a game at 1080p: clear, bg, two charas, 
+// a masktrans if given, a textbox-like fill.
+static void draw_frame(
+    cpymo_backend_software_context *c, 
+    cpymo_backend_image bg, cpymo_backend_image chara,
+    cpymo_backend_masktrans masktrans)
+{
+    const float textbox[] = { 0, SCREEN_H * 0.7f, SCREEN_W, SCREEN_H * 0.3f };
+    cpymo_backend_software_clear_clip(c);
+    cpymo_backend_image_draw(
+        0, 0, SCREEN_W, SCREEN_H, bg, 0, 0, SCREEN_W, SCREEN_H, 1.0f,
+        cpymo_backend_image_draw_type_bg);
+    cpymo_backend_image_draw(
+        20, 0, 300, 360, chara, 0, 0, 300, 360, 1.0f,
+        cpymo_backend_image_draw_type_chara);
+    cpymo_backend_image_draw(
+        220, 0, 300, 360, chara, 0, 0, 300, 360, 0.5f,
+        cpymo_backend_image_draw_type_chara);
+    if (masktrans) cpymo_backend_masktrans_draw(masktrans, 0.4f, true);
+    cpymo_backend_image_fill_rects(
+        textbox, 1, cpymo_color_black, 0.5f, cpymo_backend_image_draw_type_ui_bg);
+    cpymo_backend_software_flush(c);
+}
+
+static void run_threads(
+    unsigned max_threads, cpymo_backend_image bg, cpymo_backend_image chara, int times)
+{
+    cpymo_backend_software_image rt = render_target;
+    rt.w = LARGE_SCREEN_W;
+    rt.h = LARGE_SCREEN_H;
+    rt.line_stride = rt.w * 3;
+    rt.pixels = (uint8_t *)calloc(rt.line_stride, rt.h);
+    if (rt.pixels == NULL) return;
+
+    cpymo_backend_software_context c = context;
+    c.render_target = &rt;
+    cpymo_backend_software_set_context(&c);
+    cpymo_backend_software_clip(&c, 0, 0, SCREEN_W, SCREEN_H);
+
+    // 1, 2, 4... threads, up to and including max_threads.
+    uint64_t one_thread_us = 0;
+    for (unsigned threads = 1; ; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        error_t err = cpymo_backend_software_deferred_init(&c, threads);
+        if (err != CPYMO_ERR_SUCC) {
+            printf("[Error] cpymo_backend_software_deferred_init: %s.\n", cpymo_error_message(err));
+            break;
+        }
+
+        draw_frame(&c, bg, chara, NULL);
+        uint64_t begin = micros();
+        for (int i = 0; i < times; ++i)
+            draw_frame(&c, bg, chara, NULL);
+        uint64_t us = micros() - begin;
+        if (us == 0) us = 1;
+        if (threads == 1) one_thread_us = us;
+
+        printf("1080p frame, %2u thread(s) %10.3f ms/frame %10.2fx\n",
+            threads, us / 1000.0 / times, (double)one_thread_us / us);
+
+        cpymo_backend_software_deferred_free(&c);
+        if (threads >= max_threads) break;
+    }
+
+    cpymo_backend_software_set_context(&context);
+    free(rt.pixels);
+}
+
+// Deferred drawing must write the same bytes as immediate drawing
+// with any thread count, for the whole screen and for a damage rect,
+// pixels outside the clip rect must be kept.
+static int check_deferred(
+    unsigned max_threads, cpymo_backend_image bg, cpymo_backend_image chara, 
+    cpymo_backend_masktrans masktrans)
+{
+    static const float clips[][4] = {
+        { 0, 0, SCREEN_W, SCREEN_H },
+        { 37, 51, 201, 123 },
+        { 0, SCREEN_H - 9, SCREEN_W, 9 },
+    };
+
+    cpymo_backend_software_image rt = render_target;
+    rt.w = LARGE_SCREEN_W;
+    rt.h = LARGE_SCREEN_H;
+    rt.line_stride = rt.w * 3;
+    const size_t size = rt.line_stride * rt.h;
+    rt.pixels = (uint8_t *)malloc(size);
+    uint8_t *expect = (uint8_t *)malloc(size);
+    if (rt.pixels == NULL || expect == NULL) {
+        free(rt.pixels);
+        free(expect);
+        printf("[Error] Out of memory.\n");
+        return -1;
+    }
+
+    cpymo_backend_software_context c = context;
+    c.render_target = &rt;
+    cpymo_backend_software_set_context(&c);
+
+    int ret = 0;
+    for (size_t i = 0; i < sizeof(clips) / sizeof(clips[0]); ++i) {
+        // threads == 0 draws at once and gives the expected frame.
+        for (unsigned threads = 0; threads <= max_threads; ++threads) {
+            if (threads) {
+                error_t err = cpymo_backend_software_deferred_init(&c, threads);
+                if (err != CPYMO_ERR_SUCC) {
+                    printf("[Error] cpymo_backend_software_deferred_init: %s.\n", 
+                        cpymo_error_message(err));
+                    ret = -1;
+                    break;
+                }
+            }
+
+            for (size_t j = 0; j < size; ++j) rt.pixels[j] = (uint8_t)(j * 7);
+            cpymo_backend_software_clip(&c, clips[i][0], clips[i][1], clips[i][2], clips[i][3]);
+            draw_frame(&c, bg, chara, masktrans);
+            cpymo_backend_software_deferred_free(&c);
+
+            if (threads == 0) memcpy(expect, rt.pixels, size);
+            else if (memcmp(expect, rt.pixels, size) != 0) {
+                printf("[Error] Deferred drawing on %u thread(s) differs from immediate, clip %zu.\n",
+                    threads, i);
+                ret = -1;
+            }
+        }
+    }
+
+    printf("[Info] Deferred drawing on 1 ~ %u thread(s): %s.\n", 
+        max_threads, ret ? "FAILED" : "same as immediate");
+
+    cpymo_backend_software_set_context(&context);
+    free(expect);
+    free(rt.pixels);
+    return ret;
+}
+
+// Every kernel set must write the same bytes as the scalar one,
+// rows of random length, alignment and alpha are compared.
+static int check_kernels(void)
+{
+    const cpymo_backend_software_kernels *scalar = NULL, *k;
+    for (size_t i = 0; (k = cpymo_backend_software_kernels_get(i)) != NULL; ++i)
+        scalar = k;
+
+    enum { MAX_N = 300, PAD = 32 };
+    static uint8_t src[MAX_N * 4 + PAD], mask[MAX_N + PAD];
+    static uint8_t expect[MAX_N * 3 + PAD], got[MAX_N * 3 + PAD];
+
+    int ret = 0;
+    srand(0);
+    for (size_t i = 0; (k = cpymo_backend_software_kernels_get(i)) != scalar; ++i) {
+        int failed = 0;
+        for (int round = 0; round < 20000; ++round) {
+            size_t n = (size_t)(rand() % MAX_N);
+            unsigned alpha = round < 256 ? (unsigned)round : (unsigned)(rand() % 256);
+            if (round % 7 == 0) alpha = 255;
+            uint8_t r = (uint8_t)rand(), g = (uint8_t)rand(), b = (uint8_t)rand();
+            size_t src_off = (size_t)(rand() % 16), dst_off = (size_t)(rand() % 16);
+
+            for (size_t j = 0; j < sizeof(src); ++j) src[j] = (uint8_t)rand();
+            for (size_t j = 0; j < sizeof(mask); ++j) mask[j] = (uint8_t)rand();
+            for (size_t j = 0; j < sizeof(expect); ++j) 
+                expect[j] = (uint8_t)(j % 5 == 0 ? 0 : j % 5 == 1 ? 255 : rand());
+
+            for (int kernel = 0; kernel < 4; ++kernel) {
+                uint8_t *e = expect + dst_off, *o = got + dst_off;
+                memcpy(got, expect, sizeof(got));
+
+                switch (kernel) {
+                case 0:
+                    scalar->blend_rgba(e, src + src_off, n, alpha);
+                    k->blend_rgba(o, src + src_off, n, alpha);
+                    break;
+                case 1:
+                    scalar->blend_rgb(e, src + src_off, n, alpha);
+                    k->blend_rgb(o, src + src_off, n, alpha);
+                    break;
+                case 2:
+                    scalar->fill(e, n, r, g, b, alpha);
+                    k->fill(o, n, r, g, b, alpha);
+                    break;
+                case 3:
+                    scalar->blend_mask(e, mask + src_off, n, r, g, b);
+                    k->blend_mask(o, mask + src_off, n, r, g, b);
+                    break;
+                }
+
+                if (memcmp(expect, got, sizeof(got)) != 0 && failed++ < 10) {
+                    static const char *names[] = 
+                        { "blend_rgba", "blend_rgb", "fill", "blend_mask" };
+                    printf("[Error] %s %s differs from scalar, n = %zu, alpha = %u.\n",
+                        k->name, names[kernel], n, alpha);
+                }
+            }
+        }
+
+        printf("[Info] %s: %s.\n", k->name, failed ? "FAILED" : "same as scalar");
+        if (failed) ret = -1;
+    }
+
+    return ret;
+}
+
+static void print_usage(void)
+{
+    puts("Usage: cpymo-software-benchmark [-c] [-k <kernels>] [-t <threads>] [times]");
+    puts("    -c    Check that every kernel set gives the same result as scalar,");
+    puts("          and deferred drawing on 1 ~ threads the same as immediate.");
+    puts("    -k    Use the kernel set with this name instead of the fastest.");
+    puts("    -t    Most threads to draw 1080p frames with, one per CPU core by default.");
+}
+
+int main(int argc, char **argv)
+{
+    int times = 200;
+    const char *kernels = NULL;
+    bool check = false;
+    unsigned max_threads = cpymo_thread_hardware_concurrency();
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-c") == 0) check = true;
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) kernels = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) 
+            max_threads = (unsigned)atoi(argv[++i]);
+        else if (argv[i][0] != '-' && atoi(argv[i]) > 0) times = atoi(argv[i]);
+        else {
+            print_usage();
+            return -1;
+        }
+    }
+
+    render_target.w = SCREEN_W;
+    render_target.h = SCREEN_H;
+    render_target.line_stride = render_target.w * 3;
+    render_target.pixel_stride = 3;
+    render_target.r_offset = 0;
+    render_target.g_offset = 1;
+    render_target.b_offset = 2;
+    render_target.has_alpha_channel = false;
+    render_target.pixels = (uint8_t *)calloc(render_target.line_stride, render_target.h);
+    if (render_target.pixels == NULL) return -1;
+
+    context.logical_screen_w = SCREEN_W;
+    context.logical_screen_h = SCREEN_H;
+    context.scale_on_load_image = false;
+    context.render_target = &render_target;
+    cpymo_backend_software_set_context(&context);
+    cpymo_backend_software_clip(&context, 0, 0, SCREEN_W, SCREEN_H);
+
+    if (kernels) {
+        const cpymo_backend_software_kernels *k;
+        for (size_t i = 0; (k = cpymo_backend_software_kernels_get(i)) != NULL; ++i)
+            if (strcmp(k->name, kernels) == 0) break;
+
+        if (k == NULL) {
+            printf("[Error] Kernel set %s is not available.\n", kernels);
+            return -1;
+        }
+
+        cpymo_backend_software_cur_kernels = k;
+    }
+
+    printf("[Info] Kernels: %s.\n", cpymo_backend_software_cur_kernels->name);
+
+    cpymo_backend_image bg = create_image(SCREEN_W, SCREEN_H, false);
+    cpymo_backend_image bg_large = create_image(800, 600, false);
+    cpymo_backend_image chara = create_image(300, 360, true);
+    cpymo_backend_masktrans masktrans = create_masktrans(SCREEN_W, SCREEN_H);
+
+    if (check) {
+        int ret = check_kernels();
+        if (check_deferred(max_threads < 8 ? 8 : max_threads, bg, chara, masktrans) != 0) 
+            ret = -1;
+
+        cpymo_backend_image_free(bg);
+        cpymo_backend_image_free(bg_large);
+        cpymo_backend_image_free(chara);
+        cpymo_backend_masktrans_free(masktrans);
+        free(render_target.pixels);
+        return ret;
+    }
+
+    run("bg", bg, SCREEN_W, SCREEN_H, 0, 0, SCREEN_W, SCREEN_H, 1.0f, 
+        cpymo_backend_image_draw_type_bg, times);
+    run("bg scaled", bg_large, 800, 600, 0, 0, SCREEN_W, SCREEN_H, 1.0f, 
+        cpymo_backend_image_draw_type_bg, times);
+    run("bg fading", bg, SCREEN_W, SCREEN_H, 0, 0, SCREEN_W, SCREEN_H, 0.5f, 
+        cpymo_backend_image_draw_type_bg, times);
+    run("chara", chara, 300, 360, 120, 0, 300, 360, 1.0f, 
+        cpymo_backend_image_draw_type_chara, times);
+    run("chara scaled", chara, 300, 360, 150, 60, 240, 288, 1.0f, 
+        cpymo_backend_image_draw_type_chara, times);
+    run("chara fading", chara, 300, 360, 120, 0, 300, 360, 0.5f, 
+        cpymo_backend_image_draw_type_chara, times);
+    run_fill("flash", 1.0f, times);
+    run_fill("fade", 0.5f, times);
+    run_masktrans("masktrans", masktrans, times);
+    run_threads(max_threads, bg, chara, times / 4 > 0 ? times / 4 : 1);
+
+    cpymo_backend_image_free(bg);
+    cpymo_backend_image_free(bg_large);
+    cpymo_backend_image_free(chara);
+    cpymo_backend_masktrans_free(masktrans);
+    free(render_target.pixels);
+    return 0;
+}
@@ -1,10 +1,13 @@
 #include <cpymo_prelude.h>
 #include "cpymo_backend_software.h"
+#include "cpymo_backend_software_deferred.h"
 #include <cpymo_backend_image.h>
 #include <cpymo_utils.h>
+#include <cpymo_profiler.h>
 #include <stb_image_resize.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 extern cpymo_backend_software_context 
     *cpymo_backend_software_cur_context;
@@ -103,32 +106,40 @@ void cpymo_backend_image_free(cpymo_backend_image image)
     free(p);
 }
 
-static inline void cpymo_backend_image_trans_pos(float *x, float *y)
+static inline void cpymo_backend_image_trans_pos(
+    const cpymo_backend_software_context *c, float *x, float *y)
 {
-    float game_w = cpymo_backend_software_cur_context->logical_screen_w;
-	float game_h = cpymo_backend_software_cur_context->logical_screen_h;
+    float game_w = c->logical_screen_w;
+	float game_h = c->logical_screen_h;
 
-	float scr_w = (float)cpymo_backend_software_cur_context->render_target->w;
-	float scr_h = (float)cpymo_backend_software_cur_context->render_target->h;
+	float scr_w = (float)c->render_target->w;
+	float scr_h = (float)c->render_target->h;
 
 	*x = *x / game_w * scr_w;
 	*y = *y / game_h * scr_h;
 }
 
-void cpymo_backend_image_draw(
+// Columns of destination whose source texels are looked up at once.
+#define CPYMO_BACKEND_IMAGE_BLIT_SPAN 512
+
+// Texel index for the i-th destination pixel of a draw,
+// rounds like cpymo_backend_software_image_sample_nearest().
+static inline size_t cpymo_backend_image_sample_index(
+    float offset, float scale, int i, float dst_size, size_t src_size)
+{
+    float u = offset + scale * (float)i / dst_size;
+    u = cpymo_utils_clampf(u, 0.0f, 1.0f);
+    return (size_t)(u * ((float)src_size - 1));
+}
+
+void cpymo_backend_software_raster_image(
+    const cpymo_backend_software_context *c,
 	float dstx, float dsty, float dstw, float dsth,
 	cpymo_backend_image src,
-	int srcx, int srcy, int srcw, int srch, float alpha,
-	enum cpymo_backend_image_draw_type draw_type)
+	int srcx, int srcy, int srcw, int srch, float alpha)
 { 
-    cpymo_backend_image_trans_pos(&dstx, &dsty);
-    cpymo_backend_image_trans_pos(&dstw, &dsth);
-
-    int render_target_w = 
-        (int)cpymo_backend_software_cur_context->render_target->w;
-
-    int render_target_h = 
-        (int)cpymo_backend_software_cur_context->render_target->h;
+    cpymo_backend_image_trans_pos(c, &dstx, &dsty);
+    cpymo_backend_image_trans_pos(c, &dstw, &dsth);
 
     int x1 = (int)dstx;
     int y1 = (int)dsty;
@@ -141,12 +152,9 @@ void cpymo_backend_image_draw(
     float scalex = 1.0f;
     float scaley = 1.0f;
 
-    if (cpymo_backend_software_cur_context->scale_on_load_image) {
-        scalex = 
-            cpymo_backend_software_cur_context->scale_on_load_image_w_ratio;
-            
-        scaley =
-            cpymo_backend_software_cur_context->scale_on_load_image_h_ratio;
+    if (c->scale_on_load_image) {
+        scalex = c->scale_on_load_image_w_ratio;
+        scaley = c->scale_on_load_image_h_ratio;
     }
 
     float fsrcx = scalex * (float)srcx;
@@ -160,48 +168,117 @@ void cpymo_backend_image_draw(
     float u_scale = fsrcw / (float)srci->w;
     float v_scale = fsrch / (float)srci->h;
 
-    for (int draw_y = y1; draw_y < y2; ++draw_y) {
-        for (int draw_x = x1; draw_x < x2; ++draw_x) {
-            if (draw_x < 0) continue;
-            if (draw_x >= render_target_w) break;
-            if (draw_y < 0) break;
-            if (draw_y >= render_target_h) return;
-
-            float u = u_offset + u_scale * (float)(draw_x - x1) / dstw;
-            float v = v_offset + v_scale * (float)(draw_y - y1) / dsth;
-
-            u = cpymo_utils_clampf(u, 0.0f, 1.0f);
-            v = cpymo_utils_clampf(v, 0.0f, 1.0f);
-
-            float r, g, b, a;
-            cpymo_backend_software_image_sample_nearest(
-                srci, u, v, &r, &g, &b, &a);
-
-            a *= alpha;
-            
-            cpymo_backend_software_image_write_blend(
-                cpymo_backend_software_cur_context->render_target,
-                (size_t)draw_x, (size_t)draw_y,
-                r, g, b, a);
+    int from_x = x1 > (int)c->clip_x1 ? x1 : (int)c->clip_x1;
+    int from_y = y1 > (int)c->clip_y1 ? y1 : (int)c->clip_y1;
+    int to_x = x2 < (int)c->clip_x2 ? x2 : (int)c->clip_x2;
+    int to_y = y2 < (int)c->clip_y2 ? y2 : (int)c->clip_y2;
+
+    if (from_x >= to_x || from_y >= to_y) return;
+
+    unsigned alpha8 = 
+        (unsigned)(cpymo_utils_clampf(alpha, 0.0f, 1.0f) * 255.0f + 0.5f);
+    if (alpha8 == 0) return;
+
+    cpymo_backend_software_image *rt = c->render_target;
+    const size_t src_ps = srci->pixel_stride, dst_ps = rt->pixel_stride;
+    const size_t sr = srci->r_offset, sg = srci->g_offset;
+    const size_t sb = srci->b_offset, sa = srci->a_offset;
+    const size_t dr = rt->r_offset, dg = rt->g_offset, db = rt->b_offset;
+
+    // Rows can be copied as is when both images are RGB24,
+    // other blends of RGB24 / RGBA32 go to the row kernels.
+    const bool opaque = !srci->has_alpha_channel && alpha8 == 255;
+    const bool dst_rgb24 = cpymo_backend_software_image_is_rgb24(rt);
+    const bool same_layout = 
+        dst_rgb24 && cpymo_backend_software_image_is_rgb24(srci);
+
+    void (*blend_row)(uint8_t *, const uint8_t *, size_t, unsigned) = NULL;
+    if (same_layout) 
+        blend_row = cpymo_backend_software_cur_kernels->blend_rgb;
+    else if (dst_rgb24 && cpymo_backend_software_image_is_rgba32(srci))
+        blend_row = cpymo_backend_software_cur_kernels->blend_rgba;
+
+    size_t cols[CPYMO_BACKEND_IMAGE_BLIT_SPAN];
+    int runs[CPYMO_BACKEND_IMAGE_BLIT_SPAN];
+    const int span = CPYMO_BACKEND_IMAGE_BLIT_SPAN;
+
+    for (int span_x = from_x; span_x < to_x; span_x += span) {
+        int n = to_x - span_x < span ? to_x - span_x : span;
+
+        for (int i = 0; i < n; ++i)
+            cols[i] = src_ps * cpymo_backend_image_sample_index(
+                u_offset, u_scale, span_x + i - x1, dstw, srci->w);
+
+        // runs[i] is how many pixels from i on take consecutive texels,
+        // nearly unscaled draws are copied run by run.
+        int run_count = 1;
+        runs[n - 1] = 1;
+        for (int i = n - 2; i >= 0; --i) {
+            if (cols[i + 1] == cols[i] + src_ps) runs[i] = runs[i + 1] + 1;
+            else { runs[i] = 1; run_count++; }
+        }
+
+        const bool long_runs = n >= 8 * run_count;
+
+        for (int draw_y = from_y; draw_y < to_y; ++draw_y) {
+            const uint8_t *src_row = srci->pixels + srci->line_stride *
+                cpymo_backend_image_sample_index(
+                    v_offset, v_scale, draw_y - y1, dsth, srci->h);
+
+            uint8_t *dst = 
+                rt->pixels + (size_t)draw_y * rt->line_stride 
+                + (size_t)span_x * dst_ps;
+
+            if (opaque && same_layout && long_runs) {
+                for (int i = 0; i < n; i += runs[i])
+                    memcpy(dst + (size_t)i * 3, src_row + cols[i], (size_t)runs[i] * 3);
+            }
+            else if (opaque) {
+                for (int i = 0; i < n; ++i, dst += dst_ps) {
+                    const uint8_t *s = src_row + cols[i];
+                    dst[dr] = s[sr];
+                    dst[dg] = s[sg];
+                    dst[db] = s[sb];
+                }
+            }
+            else if (blend_row && long_runs) {
+                for (int i = 0; i < n; i += runs[i])
+                    blend_row(dst + (size_t)i * 3, src_row + cols[i], (size_t)runs[i], alpha8);
+            }
+            else {
+                for (int i = 0; i < n; ++i, dst += dst_ps) {
+                    const uint8_t *s = src_row + cols[i];
+                    unsigned a = srci->has_alpha_channel ? s[sa] : 255;
+                    if (alpha8 != 255) a = cpymo_backend_software_div255(a * alpha8);
+
+                    if (a == 255) {
+                        dst[dr] = s[sr];
+                        dst[dg] = s[sg];
+                        dst[db] = s[sb];
+                    }
+                    else if (a) {
+                        unsigned inv_a = 255 - a;
+                        dst[dr] = cpymo_backend_software_div255(s[sr] * a + dst[dr] * inv_a);
+                        dst[dg] = cpymo_backend_software_div255(s[sg] * a + dst[dg] * inv_a);
+                        dst[db] = cpymo_backend_software_div255(s[sb] * a + dst[db] * inv_a);
+                    }
+                }
+            }
         }
     }
 }
 
-void cpymo_backend_image_fill_rects(
+void cpymo_backend_software_raster_fill_rects(
+    const cpymo_backend_software_context *c,
 	const float *xywh, size_t count,
-	cpymo_color color, float alpha,
-	enum cpymo_backend_image_draw_type draw_type)
+	cpymo_color color, float alpha)
 { 
-    float r = cpymo_utils_clampf((float)color.r / 255.0f, 0.0f, 1.0f);
-    float g = cpymo_utils_clampf((float)color.g / 255.0f, 0.0f, 1.0f);
-    float b = cpymo_utils_clampf((float)color.b / 255.0f, 0.0f, 1.0f);
-    alpha = cpymo_utils_clampf(alpha, 0.0f, 1.0f);
+    unsigned alpha8 = 
+        (unsigned)(cpymo_utils_clampf(alpha, 0.0f, 1.0f) * 255.0f + 0.5f);
+    if (alpha8 == 0) return;
 
-    int render_target_w = 
-        (int)cpymo_backend_software_cur_context->render_target->w;
-
-    int render_target_h = 
-        (int)cpymo_backend_software_cur_context->render_target->h;
+    cpymo_backend_software_image *rt = c->render_target;
+    const bool dst_rgb24 = cpymo_backend_software_image_is_rgb24(rt);
 
     for (size_t i = 0; i < count; ++i) {
         const float *rect = xywh + 4 * i;
@@ -209,31 +286,92 @@ void cpymo_backend_image_fill_rects(
         float y = rect[1];
         float w = rect[2];
         float h = rect[3];
-        cpymo_backend_image_trans_pos(&x, &y);
-        cpymo_backend_image_trans_pos(&w, &h);
+        cpymo_backend_image_trans_pos(c, &x, &y);
+        cpymo_backend_image_trans_pos(c, &w, &h);
 
         int x1 = (int)x;
         int y1 = (int)y;
         int x2 = (int)(x + w);
         int y2 = (int)(y + h);
 
+        if (x1 < (int)c->clip_x1) x1 = (int)c->clip_x1;
+        if (y1 < (int)c->clip_y1) y1 = (int)c->clip_y1;
+        if (x2 > (int)c->clip_x2) x2 = (int)c->clip_x2;
+        if (y2 > (int)c->clip_y2) y2 = (int)c->clip_y2;
+
+        if (x1 >= x2) continue;
+
         for (int draw_y = y1; draw_y < y2; ++draw_y) {
-            for (int draw_x = x1; draw_x < x2; ++draw_x) {
-                if (draw_x < 0) continue;
-                if (draw_y < 0) break;
-                if (draw_x >= render_target_w) break;
-                if (draw_y >= render_target_h) break;
-
-                cpymo_backend_software_image_write_blend(
-                    cpymo_backend_software_cur_context->render_target,
-                    (size_t)draw_x,
-                    (size_t)draw_y,
-                    r, g, b, alpha);
+            uint8_t *dst = 
+                rt->pixels + (size_t)draw_y * rt->line_stride 
+                + (size_t)x1 * rt->pixel_stride;
+
+            if (dst_rgb24) {
+                cpymo_backend_software_cur_kernels->fill(
+                    dst, (size_t)(x2 - x1), color.r, color.g, color.b, alpha8);
+                continue;
+            }
+
+            for (int draw_x = x1; draw_x < x2; ++draw_x, dst += rt->pixel_stride) {
+                uint8_t *dr = dst + rt->r_offset;
+                uint8_t *dg = dst + rt->g_offset;
+                uint8_t *db = dst + rt->b_offset;
+                *dr = cpymo_backend_software_div255(color.r * alpha8 + *dr * (255 - alpha8));
+                *dg = cpymo_backend_software_div255(color.g * alpha8 + *dg * (255 - alpha8));
+                *db = cpymo_backend_software_div255(color.b * alpha8 + *db * (255 - alpha8));
             }
         }
     }
 }
 
+void cpymo_backend_image_draw(
+	float dstx, float dsty, float dstw, float dsth,
+	cpymo_backend_image src,
+	int srcx, int srcy, int srcw, int srch, float alpha,
+	enum cpymo_backend_image_draw_type draw_type)
+{
+    cpymo_backend_software_context *c = cpymo_backend_software_cur_context;
+    if (c->deferred) {
+        cpymo_backend_software_command cmd;
+        cmd.type = cpymo_backend_software_command_image;
+        cmd.u.image.dstx = dstx;
+        cmd.u.image.dsty = dsty;
+        cmd.u.image.dstw = dstw;
+        cmd.u.image.dsth = dsth;
+        cmd.u.image.src = src;
+        cmd.u.image.srcx = srcx;
+        cmd.u.image.srcy = srcy;
+        cmd.u.image.srcw = srcw;
+        cmd.u.image.srch = srch;
+        cmd.u.image.alpha = alpha;
+        cpymo_backend_software_record(c, &cmd, NULL);
+        return;
+    }
+
+    CPYMO_PROFILE("backend_image_draw", cpymo_backend_software_raster_image(
+        c, dstx, dsty, dstw, dsth, src, srcx, srcy, srcw, srch, alpha));
+}
+
+void cpymo_backend_image_fill_rects(
+	const float *xywh, size_t count,
+	cpymo_color color, float alpha,
+	enum cpymo_backend_image_draw_type draw_type)
+{
+    cpymo_backend_software_context *c = cpymo_backend_software_cur_context;
+    if (c->deferred) {
+        cpymo_backend_software_command cmd;
+        cmd.type = cpymo_backend_software_command_fill_rects;
+        cmd.u.fill_rects.count = count;
+        cmd.u.fill_rects.color = color;
+        cmd.u.fill_rects.alpha = alpha;
+        cpymo_backend_software_record(c, &cmd, xywh);
+        return;
+    }
+
+    CPYMO_PROFILE("backend_fill_rects", 
+        cpymo_backend_software_raster_fill_rects(c, xywh, count, color, alpha));
+}
+
 bool cpymo_backend_image_album_ui_writable()
 { 
     #ifdef ENABLE_ALBUM_UI_WRITEABLE
@@ -1,12 +1,59 @@
 #include <cpymo_prelude.h>
 #include <cpymo_backend_software.h>
+#include "cpymo_backend_software_deferred.h"
 #include <cpymo_backend_masktrans.h>
+#include <cpymo_profiler.h>
 #include <stddef.h>
 #include <stdlib.h>
 
 extern void cpymo_backend_image_scale_on_load(
     void **pixels, int *width, int *height, size_t channels);
 
+extern cpymo_backend_software_context 
+    *cpymo_backend_software_cur_context;
+
+typedef struct {
+    cpymo_backend_software_image mask;
+
+    // Mask sampled at every pixel of render target,
+    // so drawing a frame only looks up and blends.
+    uint8_t *resampled;
+    size_t resampled_w, resampled_h;
+} cpymo_backend_masktrans_impl;
+
+// Samples like cpymo_backend_software_image_sample_nearest() did per frame.
+static error_t cpymo_backend_masktrans_resample(
+    cpymo_backend_masktrans_impl *m, size_t w, size_t h)
+{
+    uint8_t *resampled = (uint8_t *)malloc(w * h);
+    size_t *cols = (size_t *)malloc(sizeof(size_t) * w);
+    if (resampled == NULL || cols == NULL) {
+        free(resampled);
+        free(cols);
+        return CPYMO_ERR_OUT_OF_MEM;
+    }
+
+    const float tex_w = (float)m->mask.w, tex_h = (float)m->mask.h;
+    for (size_t x = 0; x < w; ++x)
+        cols[x] = (size_t)((float)x / (float)w * (tex_w - 1));
+
+    for (size_t y = 0; y < h; ++y) {
+        const uint8_t *src = m->mask.pixels + m->mask.line_stride * 
+            (size_t)((float)y / (float)h * (tex_h - 1));
+
+        uint8_t *dst = resampled + y * w;
+        for (size_t x = 0; x < w; ++x)
+            dst[x] = src[cols[x]];
+    }
+
+    free(cols);
+    free(m->resampled);
+    m->resampled = resampled;
+    m->resampled_w = w;
+    m->resampled_h = h;
+    return CPYMO_ERR_SUCC;
+}
+
 error_t cpymo_backend_masktrans_create(
     cpymo_backend_masktrans *out,
     void *mask_singlechannel_moveinto,
@@ -16,10 +63,11 @@ error_t cpymo_backend_masktrans_create(
         &mask_singlechannel_moveinto,
         &w, &h, 1);
     
-    cpymo_backend_software_image *img =
-        (cpymo_backend_software_image *)malloc(sizeof(*img));
-    if (img == NULL) return CPYMO_ERR_OUT_OF_MEM;
+    cpymo_backend_masktrans_impl *m =
+        (cpymo_backend_masktrans_impl *)malloc(sizeof(*m));
+    if (m == NULL) return CPYMO_ERR_OUT_OF_MEM;
 
+    cpymo_backend_software_image *img = &m->mask;
     img->r_offset = 0;
     img->g_offset = 0;
     img->b_offset = 0;
@@ -30,28 +78,36 @@ error_t cpymo_backend_masktrans_create(
     img->line_stride = w;
     img->pixel_stride = 1;
     img->pixels = (uint8_t *)mask_singlechannel_moveinto;
+
+    m->resampled = NULL;
+    const cpymo_backend_software_image *rt = 
+        cpymo_backend_software_cur_context->render_target;
+    error_t err = cpymo_backend_masktrans_resample(m, rt->w, rt->h);
+    if (err != CPYMO_ERR_SUCC) {
+        free(m);
+        return err;
+    }
     
-    *out = img;
+    *out = m;
     return CPYMO_ERR_SUCC;
 }
 
-void cpymo_backend_masktrans_free(cpymo_backend_masktrans m) 
+void cpymo_backend_masktrans_free(cpymo_backend_masktrans m_) 
 {
-    cpymo_backend_software_image *img =
-        (cpymo_backend_software_image *)m;
-    free(img->pixels);
-    free(img);
+    cpymo_backend_masktrans_impl *m = (cpymo_backend_masktrans_impl *)m_;
+    free(m->mask.pixels);
+    free(m->resampled);
+    free(m);
 }
 
-void cpymo_backend_masktrans_draw(
-    cpymo_backend_masktrans m, 
+void cpymo_backend_software_raster_masktrans(
+    const cpymo_backend_software_context *c,
+    cpymo_backend_masktrans m_, 
     float t, bool is_fade_in)
 {
-    extern cpymo_backend_software_context 
-        *cpymo_backend_software_cur_context;
-    
-    cpymo_backend_software_image *render_target =
-        cpymo_backend_software_cur_context->render_target;
+    const cpymo_backend_masktrans_impl *m = 
+        (const cpymo_backend_masktrans_impl *)m_;
+    cpymo_backend_software_image *render_target = c->render_target;
 
     if (!is_fade_in) t = 1.0f - t;
 
@@ -59,24 +115,81 @@ void cpymo_backend_masktrans_draw(
     float t_top = t + radius;
 	float t_bottom = t - radius;
 
-    for (size_t y = 0; y < render_target->h; ++y) {
-        for (size_t x = 0; x < render_target->w; ++x) {
-            float mask;
-            float dummy;
-            cpymo_backend_software_image_sample_nearest(
-                (cpymo_backend_software_image *)m,
-                (float)x / (float)render_target->w,
-                (float)y / (float)render_target->h,
-                &mask, &dummy, &dummy, &dummy);
+    // Alpha for every value of mask at this t.
+    uint8_t lut[256];
+    for (int i = 0; i < 256; ++i) {
+        float mask = (float)i / 255.0f;
+        if (!is_fade_in) mask = 1.0f - mask;
+
+        if (mask > t_top) mask = 1.0f;
+        else if (mask < t_bottom) mask = 0.0f;
+        else mask = (mask - t_bottom) / (2 * radius);
+
+        lut[i] = (uint8_t)(mask * 255.0f + 0.5f);
+    }
+
+    const bool dst_rgb24 = 
+        cpymo_backend_software_image_is_rgb24(render_target);
 
-            if (!is_fade_in) mask = 1.0f - mask;
+    // Alpha of a span of row is looked up first, then blended to black.
+    uint8_t alpha[512];
+    for (size_t span_x = c->clip_x1; span_x < c->clip_x2; span_x += sizeof(alpha)) {
+        size_t n = c->clip_x2 - span_x;
+        if (n > sizeof(alpha)) n = sizeof(alpha);
 
-            if (mask > t_top) mask = 1.0f;
-			else if (mask < t_bottom) mask = 0.0f;
-			else mask = (mask - t_bottom) / (2 * radius);
+        for (size_t y = c->clip_y1; y < c->clip_y2; ++y) {
+            const uint8_t *mask = m->resampled + y * m->resampled_w + span_x;
+            for (size_t i = 0; i < n; ++i)
+                alpha[i] = lut[mask[i]];
 
-            cpymo_backend_software_image_write_blend(
-                render_target, x, y, 0, 0, 0, mask);
+            uint8_t *dst = 
+                render_target->pixels + y * render_target->line_stride 
+                + span_x * render_target->pixel_stride;
+
+            if (dst_rgb24) {
+                cpymo_backend_software_cur_kernels->blend_mask(
+                    dst, alpha, n, 0, 0, 0);
+                continue;
+            }
+
+            for (size_t i = 0; i < n; ++i, dst += render_target->pixel_stride) {
+                uint8_t *dr = dst + render_target->r_offset;
+                uint8_t *dg = dst + render_target->g_offset;
+                uint8_t *db = dst + render_target->b_offset;
+                *dr = cpymo_backend_software_div255(*dr * (255 - alpha[i]));
+                *dg = cpymo_backend_software_div255(*dg * (255 - alpha[i]));
+                *db = cpymo_backend_software_div255(*db * (255 - alpha[i]));
+            }
         }
     }
 }
+
+void cpymo_backend_masktrans_draw(
+    cpymo_backend_masktrans m_, 
+    float t, bool is_fade_in)
+{
+    cpymo_backend_software_context *c = cpymo_backend_software_cur_context;
+    cpymo_backend_masktrans_impl *m = (cpymo_backend_masktrans_impl *)m_;
+
+    // Render target has been resized since the mask was sampled.
+    if (m->resampled_w != c->render_target->w 
+        || m->resampled_h != c->render_target->h)
+    {
+        error_t err = cpymo_backend_masktrans_resample(
+            m, c->render_target->w, c->render_target->h);
+        if (err != CPYMO_ERR_SUCC) return;
+    }
+
+    if (c->deferred) {
+        cpymo_backend_software_command cmd;
+        cmd.type = cpymo_backend_software_command_masktrans;
+        cmd.u.masktrans.m = m;
+        cmd.u.masktrans.t = t;
+        cmd.u.masktrans.is_fade_in = is_fade_in;
+        cpymo_backend_software_record(c, &cmd, NULL);
+        return;
+    }
+
+    CPYMO_PROFILE("backend_masktrans_draw", 
+        cpymo_backend_software_raster_masktrans(c, m, t, is_fade_in));
+}
@@ -1,10 +1,63 @@
 #include <cpymo_prelude.h>
 #include "cpymo_backend_software.h"
+#include "cpymo_backend_software_deferred.h"
+#include <string.h>
 
 cpymo_backend_software_context 
     *cpymo_backend_software_cur_context = NULL;
 
 void cpymo_backend_software_set_context(
     cpymo_backend_software_context *context)
-{ cpymo_backend_software_cur_context = context; }
+{ 
+    cpymo_backend_software_cur_context = context; 
+    if (cpymo_backend_software_cur_kernels == NULL)
+        cpymo_backend_software_cur_kernels = 
+            cpymo_backend_software_kernels_get(0);
+}
 
+void cpymo_backend_software_clip(
+    cpymo_backend_software_context *c,
+    float x, float y, float w, float h)
+{
+    float scale_x = (float)c->render_target->w / c->logical_screen_w;
+    float scale_y = (float)c->render_target->h / c->logical_screen_h;
+
+    // Widened by a pixel, draw calls truncate their coordinates.
+    float x1 = x * scale_x - 1, x2 = (x + w) * scale_x + 2;
+    float y1 = y * scale_y - 1, y2 = (y + h) * scale_y + 2;
+
+    float max_x = (float)c->render_target->w;
+    float max_y = (float)c->render_target->h;
+
+    c->clip_x1 = x1 <= 0 ? 0 : (x1 >= max_x ? c->render_target->w : (size_t)x1);
+    c->clip_y1 = y1 <= 0 ? 0 : (y1 >= max_y ? c->render_target->h : (size_t)y1);
+    c->clip_x2 = x2 <= 0 ? 0 : (x2 >= max_x ? c->render_target->w : (size_t)x2);
+    c->clip_y2 = y2 <= 0 ? 0 : (y2 >= max_y ? c->render_target->h : (size_t)y2);
+}
+
+void cpymo_backend_software_raster_clear(
+    const cpymo_backend_software_context *c)
+{
+    cpymo_backend_software_image *rt = c->render_target;
+    if (c->clip_x2 <= c->clip_x1) return;
+
+    for (size_t y = c->clip_y1; y < c->clip_y2; ++y) {
+        memset(
+            rt->pixels + y * rt->line_stride + c->clip_x1 * rt->pixel_stride,
+            0,
+            (c->clip_x2 - c->clip_x1) * rt->pixel_stride);
+    }
+}
+
+void cpymo_backend_software_clear_clip(
+    cpymo_backend_software_context *c)
+{
+    if (c->deferred) {
+        cpymo_backend_software_command cmd;
+        cmd.type = cpymo_backend_software_command_clear;
+        cpymo_backend_software_record(c, &cmd, NULL);
+        return;
+    }
+
+    cpymo_backend_software_raster_clear(c);
+}
@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stb_truetype.h>
+#include <cpymo_error.h>
 
 typedef struct {
     size_t w, h, line_stride, pixel_stride;
@@ -26,12 +27,101 @@ typedef struct {
     cpymo_backend_software_image *render_target;
     // render target will not write to alpha channel.
 
+    // Drawing only writes pixels in [clip_x1, clip_x2) * [clip_y1, clip_y2)
+    // of render target.
+    size_t clip_x1, clip_y1, clip_x2, clip_y2;
+
     stbtt_fontinfo *font;
+
+    // NULL to draw at once, see cpymo_backend_software_deferred_init().
+    struct cpymo_backend_software_deferred *deferred;
 } cpymo_backend_software_context;
 
 void cpymo_backend_software_set_context(
     cpymo_backend_software_context *context);
 
+// Limits drawing to a rect in logical screen coordinates,
+// pass the whole logical screen to draw everywhere.
+void cpymo_backend_software_clip(
+    cpymo_backend_software_context *context,
+    float x, float y, float w, float h);
+
+// Fills clip rect of render target with black.
+void cpymo_backend_software_clear_clip(
+    cpymo_backend_software_context *context);
+
+// Deferred drawing, for big render targets.
+// After init, draw calls on this context are only recorded,
+// cpymo_backend_software_flush() splits the clip rect into horizontal bands
+// and rasterizes them on `threads` threads (0 for one per CPU core),
+// every band replays the recorded calls in order.
+// Images, texts and masktranses drawn must stay alive until the flush,
+// and the clip rect must not change in between.
+error_t cpymo_backend_software_deferred_init(
+    cpymo_backend_software_context *context, unsigned threads);
+
+void cpymo_backend_software_deferred_free(
+    cpymo_backend_software_context *context);
+
+// Draws what has been recorded, does nothing without deferred drawing.
+void cpymo_backend_software_flush(
+    cpymo_backend_software_context *context);
+
+// Rounded x / 255 for x in [0, 65535].
+static inline uint8_t cpymo_backend_software_div255(unsigned x)
+{
+    x += 128;
+    return (uint8_t)((x + (x >> 8)) >> 8);
+}
+
+// Row kernels, dst is always RGB24 in r, g, b order and alpha is 0 ~ 255,
+// each pixel becomes (src * a + dst * (255 - a)) / 255 rounded.
+// Every kernel set writes exactly the same bytes as the scalar one.
+typedef struct {
+    const char *name;
+
+    // src is RGBA32, its alpha is multiplied by alpha.
+    void (*blend_rgba)(
+        uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha);
+
+    // src is RGB24.
+    void (*blend_rgb)(
+        uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha);
+
+    void (*fill)(
+        uint8_t *dst, size_t n, 
+        uint8_t r, uint8_t g, uint8_t b, unsigned alpha);
+
+    // Alpha of each pixel is taken from mask.
+    void (*blend_mask)(
+        uint8_t *dst, const uint8_t *mask, size_t n, 
+        uint8_t r, uint8_t g, uint8_t b);
+} cpymo_backend_software_kernels;
+
+// Kernel sets this CPU can run, fastest first, the last one is scalar.
+// Returns NULL when i is out of range.
+const cpymo_backend_software_kernels *cpymo_backend_software_kernels_get(
+    size_t i);
+
+// Used by drawing, cpymo_backend_software_set_context() picks the fastest.
+extern const cpymo_backend_software_kernels 
+    *cpymo_backend_software_cur_kernels;
+
+static inline bool cpymo_backend_software_image_is_rgb24(
+    const cpymo_backend_software_image *img)
+{
+    return img->pixel_stride == 3 && !img->has_alpha_channel
+        && img->r_offset == 0 && img->g_offset == 1 && img->b_offset == 2;
+}
+
+static inline bool cpymo_backend_software_image_is_rgba32(
+    const cpymo_backend_software_image *img)
+{
+    return img->pixel_stride == 4 && img->has_alpha_channel
+        && img->r_offset == 0 && img->g_offset == 1 && img->b_offset == 2
+        && img->a_offset == 3;
+}
+
 static inline void cpymo_backend_software_image_write_blend(
     cpymo_backend_software_image *render_target,
     size_t x, size_t y,
@@ -0,0 +1,273 @@
+#include <cpymo_prelude.h>
+#include "cpymo_backend_software_deferred.h"
+#include <cpymo_thread.h>
+#include <cpymo_profiler.h>
+#include <stb_ds.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bands per thread, more bands than threads keep threads busy
+// when some bands have more to draw (like the textbox at the bottom).
+#define CPYMO_BACKEND_SOFTWARE_BANDS_PER_THREAD 4
+
+// Bands are not made thinner than this many rows.
+#define CPYMO_BACKEND_SOFTWARE_MIN_BAND_ROWS 8
+
+struct cpymo_backend_software_deferred {
+    cpymo_backend_software_command *commands;
+    float *rects;
+    size_t threads;
+
+    // Frame being flushed, with deferred set to NULL.
+    cpymo_backend_software_context frame;
+
+#ifndef CPYMO_NO_THREADS
+    cpymo_mutex mutex;
+    cpymo_cond work_cond, done_cond;
+    bool quit;
+
+    cpymo_thread *workers;
+    size_t worker_count;
+
+    // Bumped for each flush, so workers know there is a new frame.
+    unsigned generation;
+    size_t bands, next_band, bands_done;
+#endif
+};
+
+static void cpymo_backend_software_deferred_band(
+    struct cpymo_backend_software_deferred *d, size_t band, size_t bands)
+{
+    cpymo_backend_software_context c = d->frame;
+    size_t rows = d->frame.clip_y2 - d->frame.clip_y1;
+    c.clip_y1 = d->frame.clip_y1 + rows * band / bands;
+    c.clip_y2 = d->frame.clip_y1 + rows * (band + 1) / bands;
+
+    for (size_t i = 0; i < (size_t)arrlen(d->commands); ++i) {
+        const cpymo_backend_software_command *cmd = d->commands + i;
+        switch (cmd->type) {
+        case cpymo_backend_software_command_clear:
+            cpymo_backend_software_raster_clear(&c);
+            break;
+        case cpymo_backend_software_command_image:
+            cpymo_backend_software_raster_image(
+                &c,
+                cmd->u.image.dstx, cmd->u.image.dsty,
+                cmd->u.image.dstw, cmd->u.image.dsth,
+                cmd->u.image.src,
+                cmd->u.image.srcx, cmd->u.image.srcy,
+                cmd->u.image.srcw, cmd->u.image.srch,
+                cmd->u.image.alpha);
+            break;
+        case cpymo_backend_software_command_fill_rects:
+            cpymo_backend_software_raster_fill_rects(
+                &c,
+                d->rects + 4 * cmd->u.fill_rects.first_rect,
+                cmd->u.fill_rects.count,
+                cmd->u.fill_rects.color,
+                cmd->u.fill_rects.alpha);
+            break;
+        case cpymo_backend_software_command_masktrans:
+            cpymo_backend_software_raster_masktrans(
+                &c,
+                cmd->u.masktrans.m,
+                cmd->u.masktrans.t,
+                cmd->u.masktrans.is_fade_in);
+            break;
+        case cpymo_backend_software_command_text:
+            cpymo_backend_software_raster_text(
+                &c,
+                cmd->u.text.t,
+                cmd->u.text.x, cmd->u.text.y_baseline,
+                cmd->u.text.col, cmd->u.text.alpha);
+            break;
+        }
+    }
+}
+
+#ifndef CPYMO_NO_THREADS
+// Draws bands until none is left, called with the mutex locked.
+static void cpymo_backend_software_deferred_work(
+    struct cpymo_backend_software_deferred *d)
+{
+    while (d->next_band < d->bands) {
+        size_t band = d->next_band++, bands = d->bands;
+        cpymo_mutex_unlock(&d->mutex);
+
+        cpymo_backend_software_deferred_band(d, band, bands);
+
+        cpymo_mutex_lock(&d->mutex);
+        if (++d->bands_done == d->bands)
+            cpymo_cond_signal(&d->done_cond);
+    }
+}
+
+static void cpymo_backend_software_deferred_worker(void *param)
+{
+    struct cpymo_backend_software_deferred *d =
+        (struct cpymo_backend_software_deferred *)param;
+
+    cpymo_mutex_lock(&d->mutex);
+    unsigned generation = d->generation;
+    while (true) {
+        while (!d->quit && d->generation == generation)
+            cpymo_cond_wait(&d->work_cond, &d->mutex);
+
+        if (d->quit) break;
+
+        generation = d->generation;
+        cpymo_backend_software_deferred_work(d);
+    }
+    cpymo_mutex_unlock(&d->mutex);
+}
+#endif
+
+error_t cpymo_backend_software_deferred_init(
+    cpymo_backend_software_context *context, unsigned threads)
+{
+    struct cpymo_backend_software_deferred *d =
+        (struct cpymo_backend_software_deferred *)malloc(sizeof(*d));
+    if (d == NULL) return CPYMO_ERR_OUT_OF_MEM;
+
+    memset(d, 0, sizeof(*d));
+    if (threads == 0) threads = cpymo_thread_hardware_concurrency();
+    d->threads = 1;
+
+#ifndef CPYMO_NO_THREADS
+    if (threads > 1) {
+        // The thread calling flush draws too.
+        d->workers = (cpymo_thread *)malloc(sizeof(cpymo_thread) * (threads - 1));
+        if (d->workers == NULL) {
+            free(d);
+            return CPYMO_ERR_OUT_OF_MEM;
+        }
+
+        error_t err = cpymo_mutex_init(&d->mutex);
+        if (err != CPYMO_ERR_SUCC) {
+            free(d->workers);
+            free(d);
+            return err;
+        }
+
+        err = cpymo_cond_init(&d->work_cond);
+        if (err != CPYMO_ERR_SUCC) {
+            cpymo_mutex_free(&d->mutex);
+            free(d->workers);
+            free(d);
+            return err;
+        }
+
+        err = cpymo_cond_init(&d->done_cond);
+        if (err != CPYMO_ERR_SUCC) {
+            cpymo_cond_free(&d->work_cond);
+            cpymo_mutex_free(&d->mutex);
+            free(d->workers);
+            free(d);
+            return err;
+        }
+
+        for (d->worker_count = 0; d->worker_count < threads - 1; d->worker_count++) {
+            err = cpymo_thread_create(
+                &d->workers[d->worker_count],
+                &cpymo_backend_software_deferred_worker, d);
+            if (err != CPYMO_ERR_SUCC) break;
+        }
+
+        d->threads = d->worker_count + 1;
+    }
+#endif
+
+    context->deferred = d;
+    return CPYMO_ERR_SUCC;
+}
+
+void cpymo_backend_software_deferred_free(
+    cpymo_backend_software_context *context)
+{
+    struct cpymo_backend_software_deferred *d = context->deferred;
+    if (d == NULL) return;
+
+    context->deferred = NULL;
+
+#ifndef CPYMO_NO_THREADS
+    if (d->workers) {
+        cpymo_mutex_lock(&d->mutex);
+        d->quit = true;
+        cpymo_cond_broadcast(&d->work_cond);
+        cpymo_mutex_unlock(&d->mutex);
+
+        for (size_t i = 0; i < d->worker_count; ++i)
+            cpymo_thread_join(d->workers[i]);
+
+        free(d->workers);
+        cpymo_cond_free(&d->done_cond);
+        cpymo_cond_free(&d->work_cond);
+        cpymo_mutex_free(&d->mutex);
+    }
+#endif
+
+    arrfree(d->commands);
+    arrfree(d->rects);
+    free(d);
+}
+
+void cpymo_backend_software_record(
+    cpymo_backend_software_context *c,
+    cpymo_backend_software_command *cmd,
+    const float *xywh)
+{
+    struct cpymo_backend_software_deferred *d = c->deferred;
+
+    if (cmd->type == cpymo_backend_software_command_fill_rects) {
+        size_t first = (size_t)arrlen(d->rects);
+        arrsetlen(d->rects, first + 4 * cmd->u.fill_rects.count);
+        memcpy(d->rects + first, xywh, sizeof(float) * 4 * cmd->u.fill_rects.count);
+        cmd->u.fill_rects.first_rect = first / 4;
+    }
+
+    arrput(d->commands, *cmd);
+}
+
+static void cpymo_backend_software_flush_internal(
+    struct cpymo_backend_software_deferred *d)
+{
+    size_t rows = d->frame.clip_y2 - d->frame.clip_y1;
+    size_t max_bands = rows / CPYMO_BACKEND_SOFTWARE_MIN_BAND_ROWS;
+    size_t bands = d->threads * CPYMO_BACKEND_SOFTWARE_BANDS_PER_THREAD;
+    if (bands > max_bands) bands = max_bands;
+    if (d->threads == 1 || bands <= 1) {
+        cpymo_backend_software_deferred_band(d, 0, 1);
+        return;
+    }
+
+#ifndef CPYMO_NO_THREADS
+    cpymo_mutex_lock(&d->mutex);
+    d->bands = bands;
+    d->next_band = 0;
+    d->bands_done = 0;
+    d->generation++;
+    cpymo_cond_broadcast(&d->work_cond);
+
+    cpymo_backend_software_deferred_work(d);
+    while (d->bands_done < d->bands)
+        cpymo_cond_wait(&d->done_cond, &d->mutex);
+    cpymo_mutex_unlock(&d->mutex);
+#endif
+}
+
+void cpymo_backend_software_flush(
+    cpymo_backend_software_context *context)
+{
+    struct cpymo_backend_software_deferred *d = context->deferred;
+    if (d == NULL || arrlen(d->commands) == 0) return;
+
+    d->frame = *context;
+    d->frame.deferred = NULL;
+
+    if (d->frame.clip_x1 < d->frame.clip_x2 && d->frame.clip_y1 < d->frame.clip_y2)
+        CPYMO_PROFILE("backend_software_flush",
+            cpymo_backend_software_flush_internal(d));
+
+    arrsetlen(d->commands, 0);
+    arrsetlen(d->rects, 0);
+}
@@ -0,0 +1,81 @@
+#ifndef INCLUDE_CPYMO_BACKEND_SOFTWARE_DEFERRED
+#define INCLUDE_CPYMO_BACKEND_SOFTWARE_DEFERRED
+
+#include "cpymo_backend_software.h"
+#include <cpymo_color.h>
+#include <cpymo_backend_image.h>
+#include <cpymo_backend_masktrans.h>
+#include <cpymo_backend_text.h>
+
+// Draw calls recorded by deferred drawing.
+
+enum cpymo_backend_software_command_type {
+    cpymo_backend_software_command_clear,
+    cpymo_backend_software_command_image,
+    cpymo_backend_software_command_fill_rects,
+    cpymo_backend_software_command_masktrans,
+    cpymo_backend_software_command_text
+};
+
+typedef struct {
+    enum cpymo_backend_software_command_type type;
+    union {
+        struct {
+            float dstx, dsty, dstw, dsth;
+            cpymo_backend_image src;
+            int srcx, srcy, srcw, srch;
+            float alpha;
+        } image;
+
+        struct {
+            size_t first_rect, count;
+            cpymo_color color;
+            float alpha;
+        } fill_rects;
+
+        struct {
+            cpymo_backend_masktrans m;
+            float t;
+            bool is_fade_in;
+        } masktrans;
+
+        struct {
+            cpymo_backend_text t;
+            float x, y_baseline;
+            cpymo_color col;
+            float alpha;
+        } text;
+    } u;
+} cpymo_backend_software_command;
+
+// xywh is only used by fill_rects, whose first_rect is filled in.
+void cpymo_backend_software_record(
+    cpymo_backend_software_context *context,
+    cpymo_backend_software_command *command,
+    const float *xywh);
+
+// Rasterizers, they only write inside clip rect of context.
+void cpymo_backend_software_raster_clear(
+    const cpymo_backend_software_context *context);
+
+void cpymo_backend_software_raster_image(
+    const cpymo_backend_software_context *context,
+    float dstx, float dsty, float dstw, float dsth,
+    cpymo_backend_image src,
+    int srcx, int srcy, int srcw, int srch, float alpha);
+
+void cpymo_backend_software_raster_fill_rects(
+    const cpymo_backend_software_context *context,
+    const float *xywh, size_t count,
+    cpymo_color color, float alpha);
+
+void cpymo_backend_software_raster_masktrans(
+    const cpymo_backend_software_context *context,
+    cpymo_backend_masktrans m, float t, bool is_fade_in);
+
+void cpymo_backend_software_raster_text(
+    const cpymo_backend_software_context *context,
+    cpymo_backend_text t, float x, float y_baseline,
+    cpymo_color col, float alpha);
+
+#endif
@@ -0,0 +1,612 @@
+#include <cpymo_prelude.h>
+#include "cpymo_backend_software.h"
+
+#ifndef DISABLE_SOFTWARE_SIMD
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    (defined(__i386__) && defined(__SSE2__)) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPYMO_BACKEND_SOFTWARE_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is only picked at runtime, so it needs the GCC/Clang target attribute.
+#if defined(CPYMO_BACKEND_SOFTWARE_SSE2) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define CPYMO_BACKEND_SOFTWARE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CPYMO_BACKEND_SOFTWARE_NEON
+#include <arm_neon.h>
+#endif
+
+#endif
+
+const cpymo_backend_software_kernels
+    *cpymo_backend_software_cur_kernels = NULL;
+
+#define BLEND(S, D, A) \
+    cpymo_backend_software_div255((S) * (A) + (D) * (255 - (A)))
+
+static void cpymo_backend_software_blend_rgba_scalar(
+    uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha)
+{
+    for (size_t i = 0; i < n; ++i, dst += 3, src += 4) {
+        unsigned a = src[3];
+        if (alpha != 255) a = cpymo_backend_software_div255(a * alpha);
+
+        dst[0] = BLEND(src[0], dst[0], a);
+        dst[1] = BLEND(src[1], dst[1], a);
+        dst[2] = BLEND(src[2], dst[2], a);
+    }
+}
+
+static void cpymo_backend_software_blend_rgb_scalar(
+    uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha)
+{
+    for (size_t i = 0; i < n * 3; ++i)
+        dst[i] = BLEND(src[i], dst[i], alpha);
+}
+
+static void cpymo_backend_software_fill_scalar(
+    uint8_t *dst, size_t n, uint8_t r, uint8_t g, uint8_t b, unsigned alpha)
+{
+    for (size_t i = 0; i < n; ++i, dst += 3) {
+        dst[0] = BLEND(r, dst[0], alpha);
+        dst[1] = BLEND(g, dst[1], alpha);
+        dst[2] = BLEND(b, dst[2], alpha);
+    }
+}
+
+static void cpymo_backend_software_blend_mask_scalar(
+    uint8_t *dst, const uint8_t *mask, size_t n,
+    uint8_t r, uint8_t g, uint8_t b)
+{
+    for (size_t i = 0; i < n; ++i, dst += 3) {
+        unsigned a = mask[i];
+        dst[0] = BLEND(r, dst[0], a);
+        dst[1] = BLEND(g, dst[1], a);
+        dst[2] = BLEND(b, dst[2], a);
+    }
+}
+
+static const cpymo_backend_software_kernels
+    cpymo_backend_software_kernels_scalar = {
+    "scalar",
+    &cpymo_backend_software_blend_rgba_scalar,
+    &cpymo_backend_software_blend_rgb_scalar,
+    &cpymo_backend_software_fill_scalar,
+    &cpymo_backend_software_blend_mask_scalar
+};
+
+#ifdef CPYMO_BACKEND_SOFTWARE_SSE2
+
+static inline __m128i cpymo_backend_software_div255_sse2(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Blends 16 bytes, every byte has its own alpha.
+static inline __m128i cpymo_backend_software_blend_sse2(
+    __m128i d, __m128i s, __m128i a)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+
+    __m128i a_lo = _mm_unpacklo_epi8(a, zero);
+    __m128i a_hi = _mm_unpackhi_epi8(a, zero);
+
+    __m128i lo = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), a_lo),
+        _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, a_lo)));
+
+    __m128i hi = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), a_hi),
+        _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, a_hi)));
+
+    return _mm_packus_epi16(
+        cpymo_backend_software_div255_sse2(lo),
+        cpymo_backend_software_div255_sse2(hi));
+}
+
+// v holds 4 pixels in the low 3 bytes of each 32 bits (top bytes are 0),
+// they are packed to the low 12 bytes.
+static inline __m128i cpymo_backend_software_pack12_sse2(__m128i v)
+{
+    const __m128i m0 = _mm_setr_epi32(0x00ffffff, 0, 0, 0);
+    const __m128i m1 = _mm_setr_epi32((int)0xff000000, 0x0000ffff, 0, 0);
+    const __m128i m2 = _mm_setr_epi32(0, (int)0xffff0000, 0x000000ff, 0);
+    const __m128i m3 = _mm_setr_epi32(0, 0, (int)0xffffff00, 0);
+
+    return _mm_or_si128(
+        _mm_or_si128(
+            _mm_and_si128(v, m0), 
+            _mm_and_si128(_mm_srli_si128(v, 1), m1)),
+        _mm_or_si128(
+            _mm_and_si128(_mm_srli_si128(v, 2), m2), 
+            _mm_and_si128(_mm_srli_si128(v, 3), m3)));
+}
+
+// Each 32 bits x < 256 becomes x in its low 3 bytes.
+static inline __m128i cpymo_backend_software_spread3_sse2(__m128i x)
+{
+    return _mm_or_si128(
+        x, _mm_or_si128(_mm_slli_epi32(x, 8), _mm_slli_epi32(x, 16)));
+}
+
+// Four 12 bytes groups of 4 pixels to 3 registers (16 pixels).
+static inline void cpymo_backend_software_merge12_sse2(
+    const __m128i *c, __m128i *out)
+{
+    out[0] = _mm_or_si128(c[0], _mm_slli_si128(c[1], 12));
+    out[1] = _mm_or_si128(_mm_srli_si128(c[1], 4), _mm_slli_si128(c[2], 8));
+    out[2] = _mm_or_si128(_mm_srli_si128(c[2], 8), _mm_slli_si128(c[3], 4));
+}
+
+static inline void cpymo_backend_software_blend48_sse2(
+    uint8_t *dst, const __m128i *s, const __m128i *a)
+{
+    for (int k = 0; k < 3; ++k) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + 16 * k));
+        _mm_storeu_si128(
+            (__m128i *)(dst + 16 * k), 
+            cpymo_backend_software_blend_sse2(d, s[k], a[k]));
+    }
+}
+
+static void cpymo_backend_software_blend_rgba_sse2(
+    uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+    const __m128i global_alpha = _mm_set1_epi16((short)alpha);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, dst += 48, src += 64) {
+        __m128i rgb[4], aaa[4], s[3], a[3];
+        for (int q = 0; q < 4; ++q) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + 16 * q));
+            rgb[q] = cpymo_backend_software_pack12_sse2(_mm_and_si128(v, rgb_mask));
+            aaa[q] = cpymo_backend_software_pack12_sse2(
+                cpymo_backend_software_spread3_sse2(_mm_srli_epi32(v, 24)));
+        }
+
+        cpymo_backend_software_merge12_sse2(rgb, s);
+        cpymo_backend_software_merge12_sse2(aaa, a);
+
+        if (alpha != 255) {
+            for (int k = 0; k < 3; ++k) {
+                __m128i lo = cpymo_backend_software_div255_sse2(
+                    _mm_mullo_epi16(_mm_unpacklo_epi8(a[k], zero), global_alpha));
+                __m128i hi = cpymo_backend_software_div255_sse2(
+                    _mm_mullo_epi16(_mm_unpackhi_epi8(a[k], zero), global_alpha));
+                a[k] = _mm_packus_epi16(lo, hi);
+            }
+        }
+
+        cpymo_backend_software_blend48_sse2(dst, s, a);
+    }
+
+    cpymo_backend_software_blend_rgba_scalar(dst, src, n - i, alpha);
+}
+
+static void cpymo_backend_software_blend_rgb_sse2(
+    uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha)
+{
+    const __m128i a = _mm_set1_epi8((char)alpha);
+    size_t i = 0;
+    for (; i + 16 <= n * 3; i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128(
+            (__m128i *)(dst + i), cpymo_backend_software_blend_sse2(d, s, a));
+    }
+
+    for (; i < n * 3; ++i)
+        dst[i] = BLEND(src[i], dst[i], alpha);
+}
+
+static void cpymo_backend_software_fill_sse2(
+    uint8_t *dst, size_t n, uint8_t r, uint8_t g, uint8_t b, unsigned alpha)
+{
+    // 16 pixels are 3 registers, the color repeats every 48 bytes.
+    uint8_t color[48];
+    for (size_t k = 0; k < 48; k += 3) {
+        color[k] = r;
+        color[k + 1] = g;
+        color[k + 2] = b;
+    }
+
+    const __m128i c0 = _mm_loadu_si128((const __m128i *)color);
+    const __m128i c1 = _mm_loadu_si128((const __m128i *)(color + 16));
+    const __m128i c2 = _mm_loadu_si128((const __m128i *)(color + 32));
+    const __m128i a = _mm_set1_epi8((char)alpha);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, dst += 48) {
+        __m128i d0 = _mm_loadu_si128((const __m128i *)dst);
+        __m128i d1 = _mm_loadu_si128((const __m128i *)(dst + 16));
+        __m128i d2 = _mm_loadu_si128((const __m128i *)(dst + 32));
+        _mm_storeu_si128(
+            (__m128i *)dst, cpymo_backend_software_blend_sse2(d0, c0, a));
+        _mm_storeu_si128(
+            (__m128i *)(dst + 16), cpymo_backend_software_blend_sse2(d1, c1, a));
+        _mm_storeu_si128(
+            (__m128i *)(dst + 32), cpymo_backend_software_blend_sse2(d2, c2, a));
+    }
+
+    cpymo_backend_software_fill_scalar(dst, n - i, r, g, b, alpha);
+}
+
+static void cpymo_backend_software_blend_mask_sse2(
+    uint8_t *dst, const uint8_t *mask, size_t n,
+    uint8_t r, uint8_t g, uint8_t b)
+{
+    uint8_t color[48];
+    for (size_t k = 0; k < 48; k += 3) {
+        color[k] = r;
+        color[k + 1] = g;
+        color[k + 2] = b;
+    }
+
+    const __m128i c[3] = {
+        _mm_loadu_si128((const __m128i *)color),
+        _mm_loadu_si128((const __m128i *)(color + 16)),
+        _mm_loadu_si128((const __m128i *)(color + 32))
+    };
+
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, dst += 48, mask += 16) {
+        __m128i m = _mm_loadu_si128((const __m128i *)mask);
+        __m128i m_lo = _mm_unpacklo_epi8(m, zero);
+        __m128i m_hi = _mm_unpackhi_epi8(m, zero);
+
+        __m128i aaa[4], a[3];
+        aaa[0] = _mm_unpacklo_epi16(m_lo, zero);
+        aaa[1] = _mm_unpackhi_epi16(m_lo, zero);
+        aaa[2] = _mm_unpacklo_epi16(m_hi, zero);
+        aaa[3] = _mm_unpackhi_epi16(m_hi, zero);
+        for (int q = 0; q < 4; ++q)
+            aaa[q] = cpymo_backend_software_pack12_sse2(
+                cpymo_backend_software_spread3_sse2(aaa[q]));
+
+        cpymo_backend_software_merge12_sse2(aaa, a);
+        cpymo_backend_software_blend48_sse2(dst, c, a);
+    }
+
+    cpymo_backend_software_blend_mask_scalar(dst, mask, n - i, r, g, b);
+}
+
+static const cpymo_backend_software_kernels
+    cpymo_backend_software_kernels_sse2 = {
+    "sse2",
+    &cpymo_backend_software_blend_rgba_sse2,
+    &cpymo_backend_software_blend_rgb_sse2,
+    &cpymo_backend_software_fill_sse2,
+    &cpymo_backend_software_blend_mask_sse2
+};
+
+#endif
+
+#ifdef CPYMO_BACKEND_SOFTWARE_AVX2
+
+#define AVX2 __attribute__((target("avx2")))
+
+static inline AVX2 __m256i cpymo_backend_software_div255_avx2(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+// Blends 32 bytes, every byte has its own alpha.
+static inline AVX2 __m256i cpymo_backend_software_blend_avx2(
+    __m256i d, __m256i s, __m256i a)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(255);
+
+    __m256i a_lo = _mm256_unpacklo_epi8(a, zero);
+    __m256i a_hi = _mm256_unpackhi_epi8(a, zero);
+
+    __m256i lo = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), a_lo),
+        _mm256_mullo_epi16(
+            _mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, a_lo)));
+
+    __m256i hi = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), a_hi),
+        _mm256_mullo_epi16(
+            _mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, a_hi)));
+
+    return _mm256_packus_epi16(
+        cpymo_backend_software_div255_avx2(lo),
+        cpymo_backend_software_div255_avx2(hi));
+}
+
+// 8 pixels go to the low 24 bytes, the high 8 bytes are 0.
+static inline AVX2 __m256i cpymo_backend_software_pack_rgb_avx2(__m256i v)
+{
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+}
+
+// Only the low 24 bytes are stored: the next 8 pixels load from dst + 24,
+// a load overlapping this store would stall on store forwarding.
+static inline AVX2 void cpymo_backend_software_store24_avx2(
+    uint8_t *dst, __m256i v)
+{
+    _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+    _mm_storel_epi64(
+        (__m128i *)(dst + 16), _mm256_extracti128_si256(v, 1));
+}
+
+static AVX2 void cpymo_backend_software_blend_rgba_avx2(
+    uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha)
+{
+    const __m256i rgb = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m256i aaa = _mm256_setr_epi8(
+        3, 3, 3, 7, 7, 7, 11, 11, 11, 15, 15, 15, -1, -1, -1, -1,
+        3, 3, 3, 7, 7, 7, 11, 11, 11, 15, 15, 15, -1, -1, -1, -1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i global_alpha = _mm256_set1_epi16((short)alpha);
+
+    // A 32 bytes load must end inside dst, so the last 11 pixels are scalar.
+    size_t i = 0;
+    for (; i + 11 <= n; i += 8, dst += 24, src += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)src);
+        __m256i a = cpymo_backend_software_pack_rgb_avx2(
+            _mm256_shuffle_epi8(s, aaa));
+        s = cpymo_backend_software_pack_rgb_avx2(_mm256_shuffle_epi8(s, rgb));
+
+        if (alpha != 255) {
+            __m256i lo = cpymo_backend_software_div255_avx2(
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), global_alpha));
+            __m256i hi = cpymo_backend_software_div255_avx2(
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), global_alpha));
+            a = _mm256_packus_epi16(lo, hi);
+        }
+
+        __m256i d = _mm256_loadu_si256((const __m256i *)dst);
+        cpymo_backend_software_store24_avx2(
+            dst, cpymo_backend_software_blend_avx2(d, s, a));
+    }
+
+    cpymo_backend_software_blend_rgba_scalar(dst, src, n - i, alpha);
+}
+
+static AVX2 void cpymo_backend_software_blend_rgb_avx2(
+    uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha)
+{
+    const __m256i a = _mm256_set1_epi8((char)alpha);
+    size_t i = 0;
+    for (; i + 32 <= n * 3; i += 32) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256(
+            (__m256i *)(dst + i), cpymo_backend_software_blend_avx2(d, s, a));
+    }
+
+    for (; i < n * 3; ++i)
+        dst[i] = BLEND(src[i], dst[i], alpha);
+}
+
+static AVX2 void cpymo_backend_software_fill_avx2(
+    uint8_t *dst, size_t n, uint8_t r, uint8_t g, uint8_t b, unsigned alpha)
+{
+    // 32 pixels are 3 registers, the color repeats every 96 bytes.
+    uint8_t color[96];
+    for (size_t k = 0; k < 96; k += 3) {
+        color[k] = r;
+        color[k + 1] = g;
+        color[k + 2] = b;
+    }
+
+    const __m256i c0 = _mm256_loadu_si256((const __m256i *)color);
+    const __m256i c1 = _mm256_loadu_si256((const __m256i *)(color + 32));
+    const __m256i c2 = _mm256_loadu_si256((const __m256i *)(color + 64));
+    const __m256i a = _mm256_set1_epi8((char)alpha);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32, dst += 96) {
+        __m256i d0 = _mm256_loadu_si256((const __m256i *)dst);
+        __m256i d1 = _mm256_loadu_si256((const __m256i *)(dst + 32));
+        __m256i d2 = _mm256_loadu_si256((const __m256i *)(dst + 64));
+        _mm256_storeu_si256(
+            (__m256i *)dst, cpymo_backend_software_blend_avx2(d0, c0, a));
+        _mm256_storeu_si256(
+            (__m256i *)(dst + 32), cpymo_backend_software_blend_avx2(d1, c1, a));
+        _mm256_storeu_si256(
+            (__m256i *)(dst + 64), cpymo_backend_software_blend_avx2(d2, c2, a));
+    }
+
+    cpymo_backend_software_fill_scalar(dst, n - i, r, g, b, alpha);
+}
+
+static AVX2 void cpymo_backend_software_blend_mask_avx2(
+    uint8_t *dst, const uint8_t *mask, size_t n,
+    uint8_t r, uint8_t g, uint8_t b)
+{
+    const __m256i spread = _mm256_setr_epi8(
+        0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, -1, -1, -1, -1,
+        4, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 7, -1, -1, -1, -1);
+    const __m256i color = _mm256_setr_epi8(
+        r, g, b, r, g, b, r, g, b, r, g, b, r, g, b, r,
+        g, b, r, g, b, r, g, b, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    // A 32 bytes load must end inside dst, so the last 11 pixels are scalar.
+    size_t i = 0;
+    for (; i + 11 <= n; i += 8, dst += 24, mask += 8) {
+        __m256i m = _mm256_broadcastsi128_si256(
+            _mm_loadl_epi64((const __m128i *)mask));
+        __m256i a = cpymo_backend_software_pack_rgb_avx2(
+            _mm256_shuffle_epi8(m, spread));
+
+        __m256i d = _mm256_loadu_si256((const __m256i *)dst);
+        cpymo_backend_software_store24_avx2(
+            dst, cpymo_backend_software_blend_avx2(d, color, a));
+    }
+
+    cpymo_backend_software_blend_mask_scalar(dst, mask, n - i, r, g, b);
+}
+
+#undef AVX2
+
+static const cpymo_backend_software_kernels
+    cpymo_backend_software_kernels_avx2 = {
+    "avx2",
+    &cpymo_backend_software_blend_rgba_avx2,
+    &cpymo_backend_software_blend_rgb_avx2,
+    &cpymo_backend_software_fill_avx2,
+    &cpymo_backend_software_blend_mask_avx2
+};
+
+#endif
+
+#ifdef CPYMO_BACKEND_SOFTWARE_NEON
+
+static inline uint8x8_t cpymo_backend_software_div255_neon(uint16x8_t x)
+{
+    x = vaddq_u16(x, vdupq_n_u16(128));
+    return vshrn_n_u16(vsraq_n_u16(x, x, 8), 8);
+}
+
+// Blends 16 bytes, every byte has its own alpha.
+static inline uint8x16_t cpymo_backend_software_blend_neon(
+    uint8x16_t d, uint8x16_t s, uint8x16_t a)
+{
+    uint8x16_t inv_a = vmvnq_u8(a);
+
+    uint16x8_t lo = vmlal_u8(
+        vmull_u8(vget_low_u8(s), vget_low_u8(a)),
+        vget_low_u8(d), vget_low_u8(inv_a));
+
+    uint16x8_t hi = vmlal_u8(
+        vmull_u8(vget_high_u8(s), vget_high_u8(a)),
+        vget_high_u8(d), vget_high_u8(inv_a));
+
+    return vcombine_u8(
+        cpymo_backend_software_div255_neon(lo),
+        cpymo_backend_software_div255_neon(hi));
+}
+
+static void cpymo_backend_software_blend_rgba_neon(
+    uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha)
+{
+    const uint8x8_t global_alpha = vdup_n_u8((uint8_t)alpha);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, dst += 48, src += 64) {
+        uint8x16x4_t s = vld4q_u8(src);
+        uint8x16x3_t d = vld3q_u8(dst);
+        uint8x16_t a = s.val[3];
+
+        if (alpha != 255) {
+            a = vcombine_u8(
+                cpymo_backend_software_div255_neon(
+                    vmull_u8(vget_low_u8(a), global_alpha)),
+                cpymo_backend_software_div255_neon(
+                    vmull_u8(vget_high_u8(a), global_alpha)));
+        }
+
+        d.val[0] = cpymo_backend_software_blend_neon(d.val[0], s.val[0], a);
+        d.val[1] = cpymo_backend_software_blend_neon(d.val[1], s.val[1], a);
+        d.val[2] = cpymo_backend_software_blend_neon(d.val[2], s.val[2], a);
+        vst3q_u8(dst, d);
+    }
+
+    cpymo_backend_software_blend_rgba_scalar(dst, src, n - i, alpha);
+}
+
+static void cpymo_backend_software_blend_rgb_neon(
+    uint8_t *dst, const uint8_t *src, size_t n, unsigned alpha)
+{
+    const uint8x16_t a = vdupq_n_u8((uint8_t)alpha);
+    size_t i = 0;
+    for (; i + 16 <= n * 3; i += 16) {
+        uint8x16_t d = vld1q_u8(dst + i);
+        uint8x16_t s = vld1q_u8(src + i);
+        vst1q_u8(dst + i, cpymo_backend_software_blend_neon(d, s, a));
+    }
+
+    for (; i < n * 3; ++i)
+        dst[i] = BLEND(src[i], dst[i], alpha);
+}
+
+static void cpymo_backend_software_fill_neon(
+    uint8_t *dst, size_t n, uint8_t r, uint8_t g, uint8_t b, unsigned alpha)
+{
+    const uint8x16_t cr = vdupq_n_u8(r), cg = vdupq_n_u8(g), cb = vdupq_n_u8(b);
+    const uint8x16_t a = vdupq_n_u8((uint8_t)alpha);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, dst += 48) {
+        uint8x16x3_t d = vld3q_u8(dst);
+        d.val[0] = cpymo_backend_software_blend_neon(d.val[0], cr, a);
+        d.val[1] = cpymo_backend_software_blend_neon(d.val[1], cg, a);
+        d.val[2] = cpymo_backend_software_blend_neon(d.val[2], cb, a);
+        vst3q_u8(dst, d);
+    }
+
+    cpymo_backend_software_fill_scalar(dst, n - i, r, g, b, alpha);
+}
+
+static void cpymo_backend_software_blend_mask_neon(
+    uint8_t *dst, const uint8_t *mask, size_t n,
+    uint8_t r, uint8_t g, uint8_t b)
+{
+    const uint8x16_t cr = vdupq_n_u8(r), cg = vdupq_n_u8(g), cb = vdupq_n_u8(b);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, dst += 48, mask += 16) {
+        uint8x16_t a = vld1q_u8(mask);
+        uint8x16x3_t d = vld3q_u8(dst);
+        d.val[0] = cpymo_backend_software_blend_neon(d.val[0], cr, a);
+        d.val[1] = cpymo_backend_software_blend_neon(d.val[1], cg, a);
+        d.val[2] = cpymo_backend_software_blend_neon(d.val[2], cb, a);
+        vst3q_u8(dst, d);
+    }
+
+    cpymo_backend_software_blend_mask_scalar(dst, mask, n - i, r, g, b);
+}
+
+static const cpymo_backend_software_kernels
+    cpymo_backend_software_kernels_neon = {
+    "neon",
+    &cpymo_backend_software_blend_rgba_neon,
+    &cpymo_backend_software_blend_rgb_neon,
+    &cpymo_backend_software_fill_neon,
+    &cpymo_backend_software_blend_mask_neon
+};
+
+#endif
+
+const cpymo_backend_software_kernels *cpymo_backend_software_kernels_get(
+    size_t i)
+{
+    const cpymo_backend_software_kernels *available[4];
+    size_t count = 0;
+
+#ifdef CPYMO_BACKEND_SOFTWARE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        available[count++] = &cpymo_backend_software_kernels_avx2;
+#endif
+
+#ifdef CPYMO_BACKEND_SOFTWARE_SSE2
+    available[count++] = &cpymo_backend_software_kernels_sse2;
+#endif
+
+#ifdef CPYMO_BACKEND_SOFTWARE_NEON
+    available[count++] = &cpymo_backend_software_kernels_neon;
+#endif
+
+    available[count++] = &cpymo_backend_software_kernels_scalar;
+
+    return i < count ? available[i] : NULL;
+}
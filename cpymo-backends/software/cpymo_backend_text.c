@@ -3,15 +3,14 @@
 #include <cpymo_color.h>
 #include <cpymo_str.h>
 #include <cpymo_backend_software.h>
+#include "cpymo_backend_software_deferred.h"
 #include <cpymo_backend_text.h>
+#include <cpymo_backend_font.h>
+#include <cpymo_profiler.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
-#ifndef TEXT_LINE_Y_OFFSET
-#define TEXT_LINE_Y_OFFSET 0
-#endif
-
 #ifndef TEXT_CHARACTER_W_SCALE
 #define TEXT_CHARACTER_W_SCALE 4
 #endif
@@ -19,59 +18,6 @@
 extern cpymo_backend_software_context 
     *cpymo_backend_software_cur_context;
 
-static void cpymo_backend_text_render(
-    void *out_or_null, 
-    int *w, int *h, 
-    cpymo_str text, 
-    float scale, float baseline) 
-{
-    stbtt_fontinfo *font = cpymo_backend_software_cur_context->font;
-	float xpos = 0;
-
-	int width = 0, height = 0;
-	float y_base = 0;
-	while (text.len > 0) {
-		uint32_t codepoint = cpymo_str_utf8_try_head_to_utf32(&text);
-		int x0, y0, x1, y1;
-
-		int advance_width, lsb;
-		float x_shift = xpos - (float)floor(xpos);
-		stbtt_GetCodepointHMetrics(font, (int)codepoint, &advance_width, &lsb);
-
-		if (codepoint == '\n') {
-			xpos = 0;
-
-			y_base += baseline + TEXT_LINE_Y_OFFSET;
-
-			continue;
-		}
-
-		stbtt_GetCodepointBitmapBoxSubpixel(font, (int)codepoint, scale, scale, x_shift, 0, &x0, &y0, &x1, &y1);
-		if (out_or_null)
-			stbtt_MakeCodepointBitmapSubpixel(
-				font,
-				(unsigned char *)out_or_null + (int)xpos + x0 + (int)(baseline + y0 + y_base) * *w,
-				x1 - x0, y1 - y0, *w, scale, scale, x_shift, 0, (int)codepoint);
-
-		xpos += (advance_width * scale);
-
-		cpymo_str text2 = text;
-		uint32_t next_char = cpymo_str_utf8_try_head_to_utf32(&text2);
-		if (next_char) {
-			xpos += scale * stbtt_GetCodepointKernAdvance(font, codepoint, next_char);
-		}
-
-		int new_width = (int)ceil(xpos);
-		if (new_width > width) width = new_width;
-
-		int new_height = (int)((y1 - y0) + baseline + y_base);
-		if (new_height > height) height = new_height;
-	}
-
-	*w = width;
-	*h = height;
-}
-
 typedef struct {
     size_t w, h;
     float baseline;
@@ -101,7 +47,7 @@ error_t cpymo_backend_text_create(
     float baseline = scale * ascent;
 
     int w, h;
-    cpymo_backend_text_render(NULL, &w, &h, utf8_string, scale, baseline);
+    cpymo_backend_font_render_ex(font, NULL, &w, &h, utf8_string, scale, baseline);
     h += 4; // magic
 
     cpymo_backend_text_impl *o = (cpymo_backend_text_impl *)malloc(sizeof(cpymo_backend_text_impl) + w * h);
@@ -110,7 +56,7 @@ error_t cpymo_backend_text_create(
     o->w = (uint16_t)w;
     o->h = (uint16_t)h;
     *out_width = cpymo_backend_text_width(utf8_string, single_character_size_in_logical_screen);
-    cpymo_backend_text_render(o->px, &w, &h, utf8_string, scale, baseline);
+    cpymo_backend_font_render_ex(font, o->px, &w, &h, utf8_string, scale, baseline);
     *out = o;
 
     scale = stbtt_ScaleForPixelHeight(font, single_character_size_in_logical_screen);
@@ -121,26 +67,29 @@ error_t cpymo_backend_text_create(
 
 void cpymo_backend_text_free(cpymo_backend_text t){ free(t); }
 
-static void cpymo_backend_text_draw_internal(cpymo_color col, float x, float y, float alpha, cpymo_backend_text_impl *t)
+static void cpymo_backend_text_draw_internal(
+    const cpymo_backend_software_context *c,
+    cpymo_color col, float x, float y, float alpha, cpymo_backend_text_impl *t)
 {
-    cpymo_backend_software_image *render_target = 
-        cpymo_backend_software_cur_context->render_target;
+    cpymo_backend_software_image *render_target = c->render_target;
 
     float 
         window_size_w = (float)render_target->w,
         window_size_h = (float)render_target->h;
     
-    x /= cpymo_backend_software_cur_context->logical_screen_w;
+    x /= c->logical_screen_w;
     x *= window_size_w;
-    y /= cpymo_backend_software_cur_context->logical_screen_h;
+    y /= c->logical_screen_h;
     y *= window_size_h;
 
     for (uint16_t draw_rect_y = 0; draw_rect_y < t->h; ++draw_rect_y) {
+        size_t draw_y = draw_rect_y + (size_t)y;
+        if (draw_y < c->clip_y1 || draw_y >= c->clip_y2) continue;
+
         for (uint16_t draw_rect_x = 0; draw_rect_x < t->w * TEXT_CHARACTER_W_SCALE; ++draw_rect_x) {
             size_t draw_x = draw_rect_x + (size_t)x;
-            size_t draw_y = draw_rect_y + (size_t)y;
 
-            if (draw_x >= window_size_w || draw_y >= window_size_h) continue;
+            if (draw_x < c->clip_x1 || draw_x >= c->clip_x2) continue;
 
             float pixel_alpha = 
                 ((float)t->px[draw_rect_y * t->w + draw_rect_x / TEXT_CHARACTER_W_SCALE] / 255.0f);
@@ -157,17 +106,39 @@ static void cpymo_backend_text_draw_internal(cpymo_color col, float x, float y,
     }
 }
 
+void cpymo_backend_software_raster_text(
+    const cpymo_backend_software_context *c,
+    cpymo_backend_text t_, float x, float y_baseline,
+    cpymo_color col, float alpha)
+{
+    cpymo_backend_text_impl *t = (cpymo_backend_text_impl *)t_;
+    float y = y_baseline - t->baseline;
+
+    cpymo_backend_text_draw_internal(c, cpymo_color_inv(col), x + 1, y + 1, alpha, t);
+    cpymo_backend_text_draw_internal(c, col, x, y, alpha, t);
+}
+
 void cpymo_backend_text_draw(
-    cpymo_backend_text t_,
+    cpymo_backend_text t,
     float x, float y_baseline,
     cpymo_color col, float alpha,
     enum cpymo_backend_image_draw_type draw_type)
 {
-    cpymo_backend_text_impl *t = (cpymo_backend_text_impl *)t_;
-    float y = y_baseline - t->baseline;
+    cpymo_backend_software_context *c = cpymo_backend_software_cur_context;
+    if (c->deferred) {
+        cpymo_backend_software_command cmd;
+        cmd.type = cpymo_backend_software_command_text;
+        cmd.u.text.t = t;
+        cmd.u.text.x = x;
+        cmd.u.text.y_baseline = y_baseline;
+        cmd.u.text.col = col;
+        cmd.u.text.alpha = alpha;
+        cpymo_backend_software_record(c, &cmd, NULL);
+        return;
+    }
 
-    cpymo_backend_text_draw_internal(cpymo_color_inv(col), x + 1, y + 1, alpha, t);
-    cpymo_backend_text_draw_internal(col, x, y, alpha, t);
+    CPYMO_PROFILE("backend_text_draw",
+        cpymo_backend_software_raster_text(c, t, x, y_baseline, col, alpha));
 }
 
 float cpymo_backend_text_width(
@@ -189,7 +160,7 @@ float cpymo_backend_text_width(
     stbtt_GetFontVMetrics(font, &ascent, NULL, NULL);
     float baseline = scale * ascent;
     int w, h;
-    cpymo_backend_text_render(NULL, &w, &h, s, scale, baseline);
+    cpymo_backend_font_render_ex(font, NULL, &w, &h, s, scale, baseline);
 
     return TEXT_CHARACTER_W_SCALE * (float)w / win_w * game_w;
 }
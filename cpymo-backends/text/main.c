@@ -11,6 +11,7 @@
 #include <cpymo_prelude.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <cpymo_backend_image.h>
@@ -105,7 +106,27 @@ void cpymo_backend_masktrans_free(cpymo_backend_masktrans m) {}
 void cpymo_backend_masktrans_draw(cpymo_backend_masktrans m, float t, bool is_fade_in) {}
 
 #include "../sdl2/cpymo_backend_save.c"
+
+#define cpymo_input_snapshot cpymo_input_snapshot_console
 #include "../ascii-art/cpymo_backend_input.c"
+#undef cpymo_input_snapshot
+
+// Benchmark mode runs the game headless as fast as possible,
+// with fixed delta time and the ok key pressed on every other step.
+static bool benchmark = false;
+static uint64_t benchmark_steps = 0;
+
+cpymo_input cpymo_input_snapshot()
+{
+    if (benchmark) {
+        cpymo_input ret;
+        memset(&ret, 0, sizeof(ret));
+        ret.ok = benchmark_steps % 2 == 0;
+        return ret;
+    }
+
+    return cpymo_input_snapshot_console();
+}
 
 error_t cpymo_backend_text_create(
     cpymo_backend_text *out, 
@@ -131,7 +152,7 @@ float cpymo_backend_text_width(
 { return t.len * single_character_size_in_logical_screen; }
 
 void cpymo_backend_text_extract(const char *text)
-{ puts(text); }
+{ if (!benchmark) puts(text); }
 
 #ifdef _WIN32
 #include <windows.h>
@@ -142,6 +163,14 @@ static uint64_t millis()
     return st.wMilliseconds + st.wSecond * 1000 + st.wMinute * 1000 * 60 + st.wHour * 1000 * 60 * 60;
 }
 
+static uint64_t micros()
+{
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / (double)freq.QuadPart * 1000000.0);
+}
+
 #else
 
 static uint64_t millis()
@@ -151,6 +180,13 @@ static uint64_t millis()
     return ((uint64_t) now.tv_sec) * 1000 + ((uint64_t) now.tv_nsec) / 1000000;
 }
 
+static uint64_t micros()
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return ((uint64_t) now.tv_sec) * 1000000 + ((uint64_t) now.tv_nsec) / 1000;
+}
+
 #endif
 
 #define STB_DS_IMPLEMENTATION
@@ -164,6 +200,38 @@ static float get_delta_time() {
     return delta;
 }
 
+static void print_benchmark_result(uint64_t wall_us)
+{
+    double secs = wall_us / 1000000.0;
+    if (wall_us == 0) secs = 0.000001;
+
+    printf("[Info] Benchmark: %llu steps in %.6f s, %.1f steps/s.\n", 
+        (unsigned long long)benchmark_steps, secs, benchmark_steps / secs);
+
+    #ifdef ENABLE_INTERPRETER_STATS
+    uint64_t total = 0;
+    for (int op = 0; op < cpymo_op_count; ++op)
+        total += cpymo_interpreter_op_stats[op];
+    printf("[Info] Benchmark: %llu commands, %.1f commands/s.\n",
+        (unsigned long long)total, total / secs);
+
+    for (int op = 0; op < cpymo_op_count; ++op) {
+        uint64_t count = cpymo_interpreter_op_stats[op];
+        if (count == 0) continue;
+        printf("%16s %12llu %14.1f/s\n", 
+            cpymo_script_op_name((cpymo_script_op)op), 
+            (unsigned long long)count, count / secs);
+    }
+    #endif
+}
+
+static void print_usage(void)
+{
+    puts("Usage: cpymo-text [-b] [-n <max_steps>] [gamedir]");
+    puts("    -b    Benchmark mode, run the game as fast as possible and print statistics.");
+    puts("    -n    Stop benchmark after max_steps engine updates.");
+}
+
 int main(int argc, char **argv)
 {
     #ifdef _WIN32
@@ -172,23 +240,38 @@ int main(int argc, char **argv)
 
     srand((unsigned)time(NULL));
     const char *gamedir = ".";
-    if (argc == 2) {
-        gamedir = argv[1];
+    uint64_t max_steps = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-b") == 0) benchmark = true;
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            benchmark = true;
+            max_steps = strtoull(argv[++i], NULL, 10);
+        }
+        else if (argv[i][0] == '-') {
+            print_usage();
+            return -1;
+        }
+        else gamedir = argv[i];
     }
 
+    if (benchmark) srand(0);
+
     error_t err = cpymo_engine_init(&engine, gamedir);
     if (err != CPYMO_ERR_SUCC) {
         printf("[Error] cpymo_engine_init: %s.\n", cpymo_error_message(err));
         return -1;
     }
 
-    printf("\033]0;%s\007", engine.gameconfig.gametitle);
+    if (!benchmark)
+        printf("\033]0;%s\007", engine.gameconfig.gametitle);
 
     prev = millis();
+    const uint64_t start = micros();
 
     while(1) {
         bool redraw = false;
-        err = cpymo_engine_update(&engine, get_delta_time(), &redraw);
+        float delta = benchmark ? 1.0f / 60.0f : get_delta_time();
+        err = cpymo_engine_update(&engine, delta, &redraw);
         if (err == CPYMO_ERR_NO_MORE_CONTENT) break;
         else if (err != CPYMO_ERR_SUCC) {
             printf("[Error] cpymo_engine_update: %s.\n", cpymo_error_message(err));
@@ -196,9 +279,15 @@ int main(int argc, char **argv)
             return -1;
         }
 
-        usleep(16000);
+        if (benchmark) {
+            benchmark_steps++;
+            if (max_steps && benchmark_steps >= max_steps) break;
+        }
+        else usleep(16000);
     }
 
+    if (benchmark) print_benchmark_result(micros() - start);
+
     cpymo_engine_free(&engine);
 
     #ifdef LEAKCHECK
@@ -0,0 +1,402 @@
+﻿#include <cpymo_prelude.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <cpymo_package.h>
+#include <cpymo_audio_mixer.h>
+#include <endianness.h>
+#include "cpymo_tool_benchmark.h"
+
+extern int help();
+extern int process_err(error_t);
+
+static double cpymo_tool_benchmark_seconds(clock_t begin, clock_t end)
+{ return (double)(end - begin) / (double)CLOCKS_PER_SEC; }
+
+static error_t cpymo_tool_benchmark_write_synthetic_package(
+	const char *path, uint32_t file_count)
+{
+	FILE *pak = fopen(path, "wb");
+	if (pak == NULL) return CPYMO_ERR_CAN_NOT_OPEN_FILE;
+
+	uint32_t file_count_store = end_htole32(file_count);
+	if (fwrite(&file_count_store, sizeof(uint32_t), 1, pak) != 1) {
+		fclose(pak);
+		return CPYMO_ERR_UNKNOWN;
+	}
+
+	const uint32_t data_begin = 
+		sizeof(uint32_t) + file_count * sizeof(cpymo_package_index);
+
+	for (uint32_t i = 0; i < file_count; ++i) {
+		cpymo_package_index index;
+		memset(&index, 0, sizeof(index));
+		sprintf(index.file_name, "ASSET_%08u", (unsigned)i);
+		index.file_offset = end_htole32(data_begin + i * sizeof(uint32_t));
+		index.file_length = end_htole32(sizeof(uint32_t));
+
+		if (fwrite(&index, sizeof(index), 1, pak) != 1) {
+			fclose(pak);
+			return CPYMO_ERR_UNKNOWN;
+		}
+	}
+
+	for (uint32_t i = 0; i < file_count; ++i) {
+		uint32_t content = end_htole32(i);
+		if (fwrite(&content, sizeof(content), 1, pak) != 1) {
+			fclose(pak);
+			return CPYMO_ERR_UNKNOWN;
+		}
+	}
+
+	fclose(pak);
+	return CPYMO_ERR_SUCC;
+}
+
+static const cpymo_package_index *cpymo_tool_benchmark_linear_find(
+	const cpymo_package *pkg, cpymo_str name)
+{
+	for (uint32_t i = 0; i < pkg->file_count; ++i)
+		if (cpymo_str_equals_str_ignore_case(name, pkg->files[i].file_name))
+			return pkg->files + i;
+	return NULL;
+}
+
+static error_t cpymo_tool_benchmark_package(uint32_t file_count, unsigned rounds)
+{
+	const char *path = "cpymo-tool-benchmark.pak";
+	error_t err = cpymo_tool_benchmark_write_synthetic_package(path, file_count);
+	CPYMO_THROW(err);
+
+	cpymo_package pkg;
+	clock_t begin = clock();
+	err = cpymo_package_open(&pkg, path);
+	clock_t end = clock();
+	if (err != CPYMO_ERR_SUCC) {
+		remove(path);
+		return err;
+	}
+
+	printf("Package with %u files opened in %.3f ms.\n",
+		(unsigned)file_count, cpymo_tool_benchmark_seconds(begin, end) * 1000.0);
+
+	char (*names)[32] = (char (*)[32])malloc(sizeof(char[32]) * file_count);
+	if (names == NULL) {
+		cpymo_package_close(&pkg);
+		remove(path);
+		return CPYMO_ERR_OUT_OF_MEM;
+	}
+
+	// Scripts reference assets in lower case.
+	for (uint32_t i = 0; i < file_count; ++i)
+		sprintf(names[i], "asset_%08u", (unsigned)i);
+
+	size_t found = 0;
+	begin = clock();
+	for (unsigned r = 0; r < rounds; ++r) {
+		for (uint32_t i = 0; i < file_count; ++i) {
+			cpymo_package_index index;
+			if (cpymo_package_find(&index, &pkg, cpymo_str_pure(names[i])) == CPYMO_ERR_SUCC)
+				found++;
+		}
+	}
+	end = clock();
+	const double hashed = cpymo_tool_benchmark_seconds(begin, end);
+
+	begin = clock();
+	for (unsigned r = 0; r < rounds; ++r) {
+		for (uint32_t i = 0; i < file_count; ++i) {
+			if (cpymo_tool_benchmark_linear_find(&pkg, cpymo_str_pure(names[i])))
+				found++;
+		}
+	}
+	end = clock();
+	const double linear = cpymo_tool_benchmark_seconds(begin, end);
+
+	free(names);
+	cpymo_package_close(&pkg);
+	remove(path);
+
+	const double lookups = (double)file_count * (double)rounds;
+	if (found != 2 * (size_t)lookups) {
+		printf("[Error] Only %u of %u lookups succeed.\n", 
+			(unsigned)found, (unsigned)(2 * lookups));
+		return CPYMO_ERR_UNKNOWN;
+	}
+
+	printf("cpymo_package_find: %10.1f ns/lookup\n", hashed / lookups * 1e9);
+	printf("linear scan:        %10.1f ns/lookup\n", linear / lookups * 1e9);
+	if (hashed > 0) printf("speedup:            %10.1fx\n", linear / hashed);
+
+	return CPYMO_ERR_SUCC;
+}
+
+#define MIXER_FREQ 48000
+#define MIXER_CHANNELS 2
+#define MIXER_SOURCES 3
+#define MIXER_CALLBACK_FRAMES 1024
+
+static void cpymo_tool_benchmark_mixer_wave(
+	void *out, size_t frames, cpymo_backend_audio_format fmt, double freq)
+{
+	for (size_t i = 0; i < frames * MIXER_CHANNELS; ++i) {
+		// Loud enough that the mix of all sources clips sometimes.
+		const double x = 0.7 * sin(2 * 3.14159265358979 * freq * (double)(i / MIXER_CHANNELS) / MIXER_FREQ);
+		switch (fmt) {
+		case cpymo_backend_audio_s16: ((int16_t *)out)[i] = (int16_t)(x * INT16_MAX); break;
+		case cpymo_backend_audio_s32: ((int32_t *)out)[i] = (int32_t)(x * INT32_MAX); break;
+		case cpymo_backend_audio_f32: ((float *)out)[i] = (float)x; break;
+		}
+	}
+}
+
+static double cpymo_tool_benchmark_mixer_run(
+	void (*mix)(void *, size_t, cpymo_backend_audio_format, const void *const *, const float *, size_t),
+	uint8_t *dst, uint8_t *const *sources, size_t source_frames,
+	cpymo_backend_audio_format fmt, size_t frame_size, size_t callbacks)
+{
+	static const float volumes[MIXER_SOURCES] = { 1.0f, 0.8f, 0.5f };
+	const void *srcs[MIXER_SOURCES];
+	size_t pos = 0;
+
+	clock_t begin = clock();
+	for (size_t i = 0; i < callbacks; ++i) {
+		if (pos + MIXER_CALLBACK_FRAMES > source_frames) pos = 0;
+		for (size_t k = 0; k < MIXER_SOURCES; ++k)
+			srcs[k] = sources[k] + pos * frame_size;
+
+		mix(dst, MIXER_CALLBACK_FRAMES * frame_size, fmt, srcs, volumes, MIXER_SOURCES);
+		pos += MIXER_CALLBACK_FRAMES;
+	}
+	clock_t end = clock();
+
+	return cpymo_tool_benchmark_seconds(begin, end);
+}
+
+// s16 may differ by one where rounding breaks ties differently,
+// s32 is summed exactly so it must be the same bit by bit.
+static bool cpymo_tool_benchmark_mixer_same(
+	const uint8_t *a, const uint8_t *b, size_t len, cpymo_backend_audio_format fmt)
+{
+	switch (fmt) {
+	case cpymo_backend_audio_s16:
+		for (size_t i = 0; i < len / sizeof(int16_t); ++i)
+			if (abs(((const int16_t *)a)[i] - ((const int16_t *)b)[i]) > 1) return false;
+		break;
+	case cpymo_backend_audio_s32:
+		for (size_t i = 0; i < len / sizeof(int32_t); ++i)
+			if (((const int32_t *)a)[i] != ((const int32_t *)b)[i]) return false;
+		break;
+	case cpymo_backend_audio_f32:
+		for (size_t i = 0; i < len / sizeof(float); ++i)
+			if (fabs(((const float *)a)[i] - ((const float *)b)[i]) > 1e-6) return false;
+		break;
+	}
+
+	return true;
+}
+
+#define MIXER_CHECK_SOURCES 4
+#define MIXER_CHECK_SAMPLES 1031
+
+static uint32_t cpymo_tool_benchmark_mixer_random(uint32_t *state)
+{
+	*state = *state * 1664525u + 1013904223u;
+	return *state;
+}
+
+// Full scale noise with the extremes of each format mixed in,
+// so that clipping and rounding are reached often.
+static void cpymo_tool_benchmark_mixer_noise(
+	void *out, size_t samples, cpymo_backend_audio_format fmt, uint32_t *state)
+{
+	for (size_t i = 0; i < samples; ++i) {
+		const uint32_t r = cpymo_tool_benchmark_mixer_random(state);
+		const bool extreme = (r & 15) == 0;
+		switch (fmt) {
+		case cpymo_backend_audio_s16: 
+			((int16_t *)out)[i] = extreme ? (r & 16 ? INT16_MAX : INT16_MIN) : (int16_t)(r >> 16);
+			break;
+		case cpymo_backend_audio_s32: 
+			((int32_t *)out)[i] = extreme ? (r & 16 ? INT32_MAX : INT32_MIN) : (int32_t)r;
+			break;
+		case cpymo_backend_audio_f32: 
+			((float *)out)[i] = extreme ? (r & 16 ? 1.0f : -1.0f) : (float)(int32_t)r / 2147483648.0f;
+			break;
+		}
+	}
+}
+
+// Mixes every length up to MIXER_CHECK_SAMPLES samples from 0 to 
+// MIXER_CHECK_SOURCES sources at several volumes, with sources and output
+// starting one sample off, and compares the result with scalar mixing.
+static error_t cpymo_tool_benchmark_mixer_check(
+	cpymo_backend_audio_format fmt, const char *fmt_name)
+{
+	static const float volume_sets[][MIXER_CHECK_SOURCES] = {
+		{ 1.0f, 1.0f, 1.0f, 1.0f },
+		{ 1.0f, 0.8f, 0.5f, 0.25f },
+		{ 0.0f, 0.3f, 0.7f, 0.0f },
+		{ 0.1f, 0.01f, 0.999f, 0.333f },
+	};
+
+	const size_t sample_size = fmt == cpymo_backend_audio_s16 ? sizeof(int16_t) : sizeof(int32_t);
+	const size_t buf_size = (MIXER_CHECK_SAMPLES + 1) * sample_size;
+
+	uint8_t *sources[MIXER_CHECK_SOURCES];
+	uint8_t *dst = (uint8_t *)malloc(buf_size);
+	uint8_t *dst_scalar = (uint8_t *)malloc(buf_size);
+	bool oom = dst == NULL || dst_scalar == NULL;
+	uint32_t state = 1;
+	for (size_t k = 0; k < MIXER_CHECK_SOURCES; ++k) {
+		sources[k] = (uint8_t *)malloc(buf_size);
+		if (sources[k] == NULL) oom = true;
+		else cpymo_tool_benchmark_mixer_noise(sources[k], MIXER_CHECK_SAMPLES + 1, fmt, &state);
+	}
+
+	error_t err = CPYMO_ERR_SUCC;
+	if (oom) {
+		err = CPYMO_ERR_OUT_OF_MEM;
+		goto CLEAN;
+	}
+
+	unsigned cases = 0;
+	for (size_t offset = 0; offset <= 1; ++offset) {
+		for (size_t v = 0; v < sizeof(volume_sets) / sizeof(volume_sets[0]); ++v) {
+			for (size_t count = 0; count <= MIXER_CHECK_SOURCES; ++count) {
+				for (size_t samples = 0; samples <= MIXER_CHECK_SAMPLES - offset; ++samples) {
+					const void *srcs[MIXER_CHECK_SOURCES];
+					for (size_t k = 0; k < count; ++k)
+						srcs[k] = sources[k] + offset * sample_size;
+
+					const size_t len = samples * sample_size;
+					cpymo_audio_mix(dst + offset * sample_size, len, fmt, srcs, volume_sets[v], count);
+					cpymo_audio_mix_scalar(dst_scalar + offset * sample_size, len, fmt, srcs, volume_sets[v], count);
+					cases++;
+
+					if (!cpymo_tool_benchmark_mixer_same(
+						dst + offset * sample_size, dst_scalar + offset * sample_size, len, fmt)) {
+						printf("[Error] %s mixed by %s differs from scalar mixing: "
+							"%u samples, %u sources, volume set %u, offset %u.\n", 
+							fmt_name, cpymo_audio_mixer_simd(), (unsigned)samples, 
+							(unsigned)count, (unsigned)v, (unsigned)offset);
+						err = CPYMO_ERR_UNKNOWN;
+						goto CLEAN;
+					}
+				}
+			}
+		}
+	}
+
+	printf("[Info] %s mixed by %s is the same as scalar mixing in %u cases.\n", 
+		fmt_name, cpymo_audio_mixer_simd(), cases);
+
+CLEAN:
+	for (size_t k = 0; k < MIXER_CHECK_SOURCES; ++k)
+		if (sources[k]) free(sources[k]);
+	if (dst) free(dst);
+	if (dst_scalar) free(dst_scalar);
+	return err;
+}
+
+static error_t cpymo_tool_benchmark_mixer(
+	cpymo_backend_audio_format fmt, const char *fmt_name, unsigned seconds)
+{
+	const size_t frame_size = MIXER_CHANNELS * 
+		(fmt == cpymo_backend_audio_s16 ? sizeof(int16_t) : sizeof(int32_t));
+	const size_t source_frames = MIXER_FREQ;
+	const size_t callbacks = (size_t)seconds * MIXER_FREQ / MIXER_CALLBACK_FRAMES;
+
+	uint8_t *sources[MIXER_SOURCES];
+	uint8_t *dst = (uint8_t *)malloc(MIXER_CALLBACK_FRAMES * frame_size);
+	uint8_t *dst_scalar = (uint8_t *)malloc(MIXER_CALLBACK_FRAMES * frame_size);
+	bool oom = dst == NULL || dst_scalar == NULL;
+	for (size_t k = 0; k < MIXER_SOURCES; ++k) {
+		sources[k] = (uint8_t *)malloc(source_frames * frame_size);
+		if (sources[k] == NULL) oom = true;
+		else cpymo_tool_benchmark_mixer_wave(sources[k], source_frames, fmt, 220.0 * (k + 1) + 3);
+	}
+
+	error_t err = CPYMO_ERR_SUCC;
+	if (oom) {
+		err = CPYMO_ERR_OUT_OF_MEM;
+		goto CLEAN;
+	}
+
+	// Every callback of the first second must be mixed the same way.
+	for (size_t pos = 0; pos + MIXER_CALLBACK_FRAMES <= source_frames; pos += MIXER_CALLBACK_FRAMES) {
+		static const float volumes[MIXER_SOURCES] = { 1.0f, 0.8f, 0.5f };
+		const void *srcs[MIXER_SOURCES];
+		for (size_t k = 0; k < MIXER_SOURCES; ++k)
+			srcs[k] = sources[k] + pos * frame_size;
+
+		const size_t len = MIXER_CALLBACK_FRAMES * frame_size;
+		cpymo_audio_mix(dst, len, fmt, srcs, volumes, MIXER_SOURCES);
+		cpymo_audio_mix_scalar(dst_scalar, len, fmt, srcs, volumes, MIXER_SOURCES);
+		if (!cpymo_tool_benchmark_mixer_same(dst, dst_scalar, len, fmt)) {
+			printf("[Error] %s mixed by %s differs from scalar mixing.\n", 
+				fmt_name, cpymo_audio_mixer_simd());
+			err = CPYMO_ERR_UNKNOWN;
+			goto CLEAN;
+		}
+	}
+
+	const double simd = cpymo_tool_benchmark_mixer_run(
+		&cpymo_audio_mix, dst, sources, source_frames, fmt, frame_size, callbacks);
+	const double scalar = cpymo_tool_benchmark_mixer_run(
+		&cpymo_audio_mix_scalar, dst_scalar, sources, source_frames, fmt, frame_size, callbacks);
+
+	const double samples = (double)callbacks * MIXER_CALLBACK_FRAMES * MIXER_CHANNELS;
+	printf("%s %-7s %10.2f ns/sample\n", fmt_name, cpymo_audio_mixer_simd(), simd / samples * 1e9);
+	printf("%s scalar  %10.2f ns/sample\n", fmt_name, scalar / samples * 1e9);
+	if (simd > 0) printf("%s speedup %10.1fx\n", fmt_name, scalar / simd);
+
+CLEAN:
+	for (size_t k = 0; k < MIXER_SOURCES; ++k)
+		if (sources[k]) free(sources[k]);
+	if (dst) free(dst);
+	if (dst_scalar) free(dst_scalar);
+	return err;
+}
+
+int cpymo_tool_invoke_benchmark_mixer(int argc, const char **argv)
+{
+	unsigned seconds = 60;
+
+	if (argc >= 3 && strcmp(argv[2], "-c") == 0) {
+		error_t err = cpymo_tool_benchmark_mixer_check(cpymo_backend_audio_s16, "s16");
+		if (err == CPYMO_ERR_SUCC) 
+			err = cpymo_tool_benchmark_mixer_check(cpymo_backend_audio_s32, "s32");
+		if (err == CPYMO_ERR_SUCC) 
+			err = cpymo_tool_benchmark_mixer_check(cpymo_backend_audio_f32, "f32");
+		return process_err(err);
+	}
+
+	if (argc >= 3) seconds = (unsigned)atoi(argv[2]);
+	if (seconds == 0) return help();
+
+	printf("Mixing %u seconds of %d sources, %d Hz %d channels, a sample is one channel of a frame.\n",
+		seconds, MIXER_SOURCES, MIXER_FREQ, MIXER_CHANNELS);
+
+	error_t err = cpymo_tool_benchmark_mixer(cpymo_backend_audio_s16, "s16", seconds);
+	if (err == CPYMO_ERR_SUCC) 
+		err = cpymo_tool_benchmark_mixer(cpymo_backend_audio_s32, "s32", seconds);
+	if (err == CPYMO_ERR_SUCC) 
+		err = cpymo_tool_benchmark_mixer(cpymo_backend_audio_f32, "f32", seconds);
+
+	return process_err(err);
+}
+
+int cpymo_tool_invoke_benchmark_package(int argc, const char **argv)
+{
+	uint32_t file_count = 4096;
+	unsigned rounds = 4;
+
+	if (argc >= 3) file_count = (uint32_t)atoi(argv[2]);
+	if (argc >= 4) rounds = (unsigned)atoi(argv[3]);
+	if (file_count == 0 || rounds == 0) return help();
+
+	return process_err(cpymo_tool_benchmark_package(file_count, rounds));
+}
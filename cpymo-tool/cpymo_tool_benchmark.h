@@ -0,0 +1,3 @@
+
+int cpymo_tool_invoke_benchmark_package(int argc, const char **argv);
+int cpymo_tool_invoke_benchmark_mixer(int argc, const char **argv);
@@ -13,6 +13,7 @@
 #include "cpymo_tool_resize.h"
 #include "cpymo_tool_pack_images.h"
 #include "cpymo_tool_image.h"
+#include "cpymo_tool_benchmark.h"
 
 #define STBI_NO_PSD
 #define STBI_NO_TGA
@@ -50,6 +51,15 @@ int help() {
 	printf("Generate album UI image cache:\n");
 	printf(
 		"    cpymo-tool gen-album-cache <gamedir> [additional-album-lists...]\n");
+	printf("Benchmark package lookups on a synthetic package:\n");
+	printf(
+		"    cpymo-tool benchmark-package [file-count] [rounds]\n");
+	printf("Benchmark mixing BGM, SE and voice into one audio stream:\n");
+	printf(
+		"    cpymo-tool benchmark-mixer [seconds]\n");
+	printf("Check that SIMD mixing gives the same samples as scalar mixing:\n");
+	printf(
+		"    cpymo-tool benchmark-mixer -c\n");
 	printf("\n");
 	return 0;
 }
@@ -78,6 +88,10 @@ int main(int argc, const char **argv) {
 			ret = cpymo_tool_invoke_pack_images(argc, argv);
 		else if (strcmp(argv[1], "gen-album-cache") == 0)
 			ret = cpymo_tool_invoke_generate_album_ui(argc, argv);
+		else if (strcmp(argv[1], "benchmark-package") == 0)
+			ret = cpymo_tool_invoke_benchmark_package(argc, argv);
+		else if (strcmp(argv[1], "benchmark-mixer") == 0)
+			ret = cpymo_tool_invoke_benchmark_mixer(argc, argv);
 		else ret = help();
 	}
 
@@ -18,6 +18,29 @@ void cpymo_anime_draw(const cpymo_anime *anime)
 	}
 }
 
+static error_t cpymo_anime_load(cpymo_engine *e, cpymo_anime *anime)
+{
+	cpymo_backend_image img;
+	int w, h;
+	error_t err = cpymo_assetloader_load_system_image(
+		&img,
+		&w, &h,
+		cpymo_str_pure(anime->anime_name),
+		&e->assetloader,
+		true);
+	if (err != CPYMO_ERR_SUCC) {
+		cpymo_anime_off(anime);
+		return err;
+	}
+
+	anime->anime_image = img;
+	anime->frame_height = h / anime->all_frame;
+	anime->image_width = w;
+	anime->deferred = false;
+
+	return CPYMO_ERR_SUCC;
+}
+
 error_t cpymo_anime_on(
 	struct cpymo_engine *engine,
 	int frames,
@@ -29,36 +52,42 @@ error_t cpymo_anime_on(
 {
 	cpymo_anime_off(&engine->anime);
 
-	cpymo_backend_image img;
-	int w, h;
-	error_t err = cpymo_assetloader_load_system_image(
-		&img,
-		&w, &h,
-		filename_span,
-		&engine->assetloader,
-		true);
-	if (err != CPYMO_ERR_SUCC) return err;
+	if (frames <= 0) return CPYMO_ERR_INVALID_ARG;
+
+	engine->anime.anime_name = (char *)malloc(filename_span.len + 1);
+	if (engine->anime.anime_name == NULL) return CPYMO_ERR_OUT_OF_MEM;
+	cpymo_str_copy(engine->anime.anime_name, filename_span.len + 1, filename_span);
 
-	engine->anime.anime_image = img;
 	engine->anime.interval = interval;
 	engine->anime.current_time = interval;
 	engine->anime.current_frame = -1;
-	engine->anime.frame_height = h / frames;
 	engine->anime.all_frame = frames;
 	engine->anime.is_loop = loop;
 	engine->anime.draw_x = x;
 	engine->anime.draw_y = y;
-	engine->anime.image_width = w;
+	engine->anime.image_width = 0;
+	engine->anime.frame_height = 0;
+	engine->anime.deferred = true;
 
-	if (loop) {
-		char *anime_name = (char *)realloc(engine->anime.anime_name, filename_span.len + 1);
-		if (anime_name) {
-			cpymo_str_copy(anime_name, filename_span.len + 1, filename_span);
-			engine->anime.anime_name = anime_name;
-		}
+	// Frames shown while skipping are never presented,
+	// so the image is loaded by cpymo_anime_load_deferred().
+	if (cpymo_engine_skipping(engine)) 
+		return CPYMO_ERR_SUCC;
+
+	return cpymo_anime_load(engine, &engine->anime);
+}
+
+void cpymo_anime_load_deferred(cpymo_engine *e, cpymo_anime *anime)
+{
+	if (!anime->deferred) return;
+
+	error_t err = cpymo_anime_load(e, anime);
+	if (err != CPYMO_ERR_SUCC) {
+		printf("[Error] Can not load anime: %s\n", cpymo_error_message(err));
+		return;
 	}
 
-	return CPYMO_ERR_SUCC;
+	cpymo_engine_request_redraw(e);
 }
 
 void cpymo_anime_update(
@@ -66,11 +95,13 @@ void cpymo_anime_update(
 	cpymo_anime *anime, 
 	float delta_time)
 {
-	if (anime->anime_image) {
+	if (anime->anime_image || anime->deferred) {
 		anime->current_time += delta_time;
 		if (anime->current_time >= anime->interval) {
 			anime->current_time = 0.0f;
-			cpymo_engine_request_redraw(e);
+			cpymo_engine_request_redraw_rect(
+				e, anime->draw_x, anime->draw_y, 
+				(float)anime->image_width, (float)anime->frame_height);
 
 			anime->current_frame++;
 			if (anime->current_frame >= anime->all_frame) {
@@ -83,6 +114,8 @@ void cpymo_anime_update(
 
 void cpymo_anime_off(cpymo_anime *anime)
 {
+	anime->deferred = false;
+
 	if (anime->anime_name) {
 		free(anime->anime_name);
 		anime->anime_name = NULL;
@@ -18,6 +18,9 @@ typedef struct {
 	int image_width;
 
 	char *anime_name;
+
+	// Started while skipping, anime_image is loaded by cpymo_anime_load_deferred().
+	bool deferred;
 } cpymo_anime;
 
 void cpymo_anime_update(
@@ -26,6 +29,7 @@ void cpymo_anime_update(
 	float delta_time);
 	
 void cpymo_anime_draw(const cpymo_anime *);
+void cpymo_anime_load_deferred(struct cpymo_engine *e, cpymo_anime *anime);
 
 error_t cpymo_anime_on(
 	struct cpymo_engine *engine,
@@ -39,7 +43,7 @@ error_t cpymo_anime_on(
 void cpymo_anime_off(cpymo_anime *anime);
 
 static inline void cpymo_anime_init(cpymo_anime *anime)
-{ anime->anime_image = NULL; anime->anime_name = NULL; }
+{ anime->anime_image = NULL; anime->anime_name = NULL; anime->deferred = false; }
 
 static inline void cpymo_anime_free(cpymo_anime *anime)
 { cpymo_anime_off(anime); }
@@ -1,6 +1,10 @@
 ﻿#include "cpymo_prelude.h"
 #include "cpymo_assetloader.h"
 #include "cpymo_utils.h"
+#include "cpymo_prefetch.h"
+#include "cpymo_image_cache.h"
+#include "cpymo_script.h"
+#include "cpymo_profiler.h"
 #include <stdlib.h>
 #include <string.h>
 #include <memory.h>
@@ -16,6 +20,9 @@ error_t cpymo_assetloader_init(cpymo_assetloader * out, const cpymo_gameconfig *
 	out->gamedir = chbuf;
 
 	out->game_config = config;
+	out->prefetch = NULL;
+	out->image_cache = NULL;
+	out->script_cache = NULL;
 
 	if (chbuf == NULL) return CPYMO_ERR_OUT_OF_MEM;
 
@@ -69,6 +76,26 @@ error_t cpymo_assetloader_init(cpymo_assetloader * out, const cpymo_gameconfig *
 	chbuf[gamedir_strlen] = '\0';
 	
 	out->gamedir = (char*)realloc((void *)out->gamedir, gamedir_strlen + 1);
+
+#ifdef ENABLE_IMAGE_CACHE
+	if (CPYMO_IMAGE_CACHE_BUDGET > 0) {
+		err = cpymo_image_cache_create(&out->image_cache, CPYMO_IMAGE_CACHE_BUDGET);
+		if (err != CPYMO_ERR_SUCC) out->image_cache = NULL;
+	}
+#endif
+
+#ifdef ENABLE_SCRIPT_CACHE
+	err = cpymo_script_cache_create(&out->script_cache, CPYMO_SCRIPT_CACHE_BUDGET);
+	if (err != CPYMO_ERR_SUCC) out->script_cache = NULL;
+#endif
+
+#ifdef ENABLE_ASSET_PREFETCH
+	err = cpymo_prefetch_create(&out->prefetch, out);
+	if (err != CPYMO_ERR_SUCC) {
+		printf("[Warning] Asset prefetch disabled: %s.\n", cpymo_error_message(err));
+		out->prefetch = NULL;
+	}
+#endif
 	
 	return CPYMO_ERR_SUCC;
 }
@@ -76,6 +103,16 @@ error_t cpymo_assetloader_init(cpymo_assetloader * out, const cpymo_gameconfig *
 void cpymo_assetloader_free(cpymo_assetloader * loader)
 {
 	if (loader) {
+		// Workers may still be reading packages.
+		cpymo_prefetch_free(loader->prefetch);
+		loader->prefetch = NULL;
+
+		cpymo_image_cache_free(loader->image_cache);
+		loader->image_cache = NULL;
+
+		cpymo_script_cache_free(loader->script_cache);
+		loader->script_cache = NULL;
+
 		if (loader->use_pkg_bg) cpymo_package_close(&loader->pkg_bg);
 		if (loader->use_pkg_chara) cpymo_package_close(&loader->pkg_chara);
 		if (loader->use_pkg_se) cpymo_package_close(&loader->pkg_se);
@@ -84,6 +121,22 @@ void cpymo_assetloader_free(cpymo_assetloader * loader)
 	}
 }
 
+void cpymo_assetloader_set_image_cache_budget(cpymo_assetloader *loader, size_t budget)
+{
+#ifdef ENABLE_IMAGE_CACHE
+	if (budget == 0) {
+		cpymo_image_cache_free(loader->image_cache);
+		loader->image_cache = NULL;
+	}
+	else if (loader->image_cache) 
+		cpymo_image_cache_set_budget(loader->image_cache, budget);
+	else if (cpymo_image_cache_create(&loader->image_cache, budget) != CPYMO_ERR_SUCC)
+		loader->image_cache = NULL;
+#else
+	(void)loader; (void)budget;
+#endif
+}
+
 error_t cpymo_assetloader_get_fs_path(
 	char **out_str,
 	cpymo_str asset_name,
@@ -174,17 +227,20 @@ static error_t cpymo_assetloader_load_image_pixels(
 	const cpymo_package *pkg,
 	const cpymo_assetloader *l)
 {
-	if (using_pkg) 
-		return cpymo_package_read_image(pixels, w, h, c, pkg, asset_name);
-	else return cpymo_assetloader_load_filesystem_image_pixels(
-		pixels,
-		w,
-		h,
-		c,
-		asset_type,
-		asset_name,
-		asset_ext_name,
-		l);
+	error_t err;
+	CPYMO_PROFILE("image_decode", 
+		if (using_pkg) 
+			err = cpymo_package_read_image(pixels, w, h, c, pkg, asset_name);
+		else err = cpymo_assetloader_load_filesystem_image_pixels(
+			pixels,
+			w,
+			h,
+			c,
+			asset_type,
+			asset_name,
+			asset_ext_name,
+			l));
+	return err;
 }
 
 
@@ -195,12 +251,82 @@ error_t cpymo_assetloader_load_bg_pixels(void ** px, int * w, int * h, cpymo_str
 		loader->game_config->bgformat, loader->use_pkg_bg, &loader->pkg_bg, loader);
 }
 
+static error_t cpymo_assetloader_load_image_pixels_with_mask(
+	void **pixels, int *w, int *h,
+	void **mask, int *mw, int *mh,
+	cpymo_str name, 
+	const char *asset_type,
+	const char *asset_ext,
+	const char *mask_ext,
+	bool use_pkg,
+	const cpymo_package *pkg,
+	const cpymo_assetloader *loader,
+	bool load_mask)
+{
+	*mask = NULL;
+
+	error_t err = cpymo_assetloader_load_image_pixels(
+		pixels, w, h, 4, 
+		asset_type, name, asset_ext,
+		use_pkg, pkg, loader);
+	CPYMO_THROW(err);
+
+	if (load_mask && cpymo_gameconfig_is_symbian(loader->game_config)) {
+		char *filename = (char *)malloc(name.len + 6);
+		if (filename == NULL) return CPYMO_ERR_SUCC;
+		
+		strncpy(filename, name.begin, name.len);
+		strcpy(filename + name.len, "_mask");
+
+		err = cpymo_assetloader_load_image_pixels(
+			mask, mw, mh, 1,
+			asset_type, cpymo_str_pure(filename), mask_ext,
+			use_pkg, pkg, loader);
+		free(filename);
+		if (err != CPYMO_ERR_SUCC) *mask = NULL;
+	}
+
+	return CPYMO_ERR_SUCC;
+}
+
+error_t cpymo_assetloader_load_chara_pixels(
+	void **px, int *w, int *h,
+	void **mask, int *mw, int *mh,
+	cpymo_str name, const cpymo_assetloader *l)
+{
+	return cpymo_assetloader_load_image_pixels_with_mask(
+		px, w, h, mask, mw, mh,
+		name, "chara", l->game_config->charaformat, l->game_config->charamaskformat,
+		l->use_pkg_chara, &l->pkg_chara, l, true);
+}
+
+error_t cpymo_assetloader_load_system_pixels(
+	void **px, int *w, int *h,
+	void **mask, int *mw, int *mh,
+	cpymo_str name, const cpymo_assetloader *l,
+	bool load_mask)
+{
+	return cpymo_assetloader_load_image_pixels_with_mask(
+		px, w, h, mask, mw, mh,
+		name, "system", "png", "png", false, NULL, l, load_mask);
+}
+
 #ifndef CPYMO_TOOL
 error_t cpymo_assetloader_load_bg_image(cpymo_backend_image * img, int * w, int * h, cpymo_str name, const cpymo_assetloader * loader)
 {
 	void *pixels = NULL;
-	error_t err = cpymo_assetloader_load_bg_pixels(&pixels, w, h, name, loader);
-	CPYMO_THROW(err);
+	error_t err;
+	if (!cpymo_image_cache_get(
+		loader->image_cache, "bg", name, false, &pixels, w, h, NULL, NULL, NULL)) {
+		if (!cpymo_prefetch_take(
+			loader->prefetch, cpymo_prefetch_bg, name, &pixels, w, h, NULL, NULL, NULL)) {
+			err = cpymo_assetloader_load_bg_pixels(&pixels, w, h, name, loader);
+			CPYMO_THROW(err);
+		}
+
+		cpymo_image_cache_put(
+			loader->image_cache, "bg", name, false, pixels, *w, *h, 3, NULL, 0, 0);
+	}
 
 	err = cpymo_backend_image_load(
 		img,
@@ -229,42 +355,39 @@ static error_t cpymo_assetloader_load_image_with_mask(
 	const cpymo_assetloader *loader,
 	bool load_mask)
 {
-	void *pixels = NULL;
-	error_t err = cpymo_assetloader_load_image_pixels(
-		&pixels, w, h, 4, 
-		asset_type, name, asset_ext,
-		use_pkg, pkg, loader);
-	CPYMO_THROW(err);
-
-	if (load_mask && cpymo_gameconfig_is_symbian(loader->game_config)) {
-		char *filename = (char *)malloc(name.len + 6);
-		if (filename == NULL) goto LOAD_WITHOUT_MASK;
-		
-		strncpy(filename, name.begin, name.len);
-		strcpy(filename + name.len, "_mask");
+	cpymo_prefetch_type prefetch_type = 
+		strcmp(asset_type, "chara") == 0 ? cpymo_prefetch_chara : cpymo_prefetch_system;
+	load_mask = load_mask && cpymo_gameconfig_is_symbian(loader->game_config);
 
-		void *mask = NULL;
-		int mw, mh;
-		err = cpymo_assetloader_load_image_pixels(
-			&mask, &mw, &mh, 1,
-			asset_type, cpymo_str_pure(filename), mask_ext,
-			use_pkg, pkg, loader);
-		free(filename);
-		if (err == CPYMO_ERR_SUCC) {
-			error_t err = cpymo_backend_image_load_with_mask(img, pixels, mask, *w, *h, mw, mh);
-			if (err != CPYMO_ERR_SUCC) {
-				free(mask);
-				goto LOAD_WITHOUT_MASK;
-			}
+	void *pixels = NULL, *mask = NULL;
+	int mw = 0, mh = 0;
+	error_t err;
+	if (!cpymo_image_cache_get(
+		loader->image_cache, asset_type, name, load_mask, &pixels, w, h, &mask, &mw, &mh)) {
+		if (!cpymo_prefetch_take(
+			loader->prefetch, prefetch_type, name, 
+			&pixels, w, h, 
+			load_mask ? &mask : NULL, &mw, &mh)) {
+			err = cpymo_assetloader_load_image_pixels_with_mask(
+				&pixels, w, h, &mask, &mw, &mh,
+				name, asset_type, asset_ext, mask_ext,
+				use_pkg, pkg, loader, load_mask);
+			CPYMO_THROW(err);
 		}
-		else goto LOAD_WITHOUT_MASK;
+
+		cpymo_image_cache_put(
+			loader->image_cache, asset_type, name, load_mask, pixels, *w, *h, 4, mask, mw, mh);
 	}
-	else {
-	LOAD_WITHOUT_MASK:
-		err = cpymo_backend_image_load(img, pixels, *w, *h, cpymo_backend_image_format_rgba);
-		if (err != CPYMO_ERR_SUCC) free(pixels);
+
+	if (mask) {
+		err = cpymo_backend_image_load_with_mask(img, pixels, mask, *w, *h, mw, mh);
+		if (err == CPYMO_ERR_SUCC) return CPYMO_ERR_SUCC;
+		free(mask);
 	}
 
+	err = cpymo_backend_image_load(img, pixels, *w, *h, cpymo_backend_image_format_rgba);
+	if (err != CPYMO_ERR_SUCC) free(pixels);
+
 	return err;
 }
 #endif
@@ -6,17 +6,45 @@
 #include "cpymo_parser.h"
 #include <stddef.h>
 
+struct cpymo_prefetch;
+struct cpymo_image_cache;
+struct cpymo_script_cache;
+
 typedef struct {
 	bool use_pkg_bg, use_pkg_chara, use_pkg_se, use_pkg_voice;
 	cpymo_package pkg_bg, pkg_chara, pkg_se, pkg_voice;
 	const cpymo_gameconfig *game_config;
 	const char *gamedir;
+
+	// Background image decoder, NULL when prefetch is not available.
+	struct cpymo_prefetch *prefetch;
+
+	// Decoded pixels of recently loaded images, NULL when disabled.
+	struct cpymo_image_cache *image_cache;
+
+	// Scripts loaded before, NULL when disabled.
+	struct cpymo_script_cache *script_cache;
 } cpymo_assetloader;
 
 error_t cpymo_assetloader_init(cpymo_assetloader *out, const cpymo_gameconfig *config, const char *gamedir);
 void cpymo_assetloader_free(cpymo_assetloader *loader);
 
+// Creates, shrinks or frees (budget = 0) the image cache,
+// does nothing when the image cache is not compiled.
+void cpymo_assetloader_set_image_cache_budget(cpymo_assetloader *loader, size_t budget);
+
 error_t cpymo_assetloader_load_bg_pixels(void **px, int *w, int *h, cpymo_str name, const cpymo_assetloader *l);
+
+// *mask is set to NULL when there is no mask to load.
+error_t cpymo_assetloader_load_chara_pixels(
+	void **px, int *w, int *h,
+	void **mask, int *mw, int *mh,
+	cpymo_str name, const cpymo_assetloader *l);
+error_t cpymo_assetloader_load_system_pixels(
+	void **px, int *w, int *h,
+	void **mask, int *mw, int *mh,
+	cpymo_str name, const cpymo_assetloader *l,
+	bool load_mask);
 error_t cpymo_assetloader_load_script(char **out_buffer, size_t *buf_size, const char *script_name, const cpymo_assetloader *loader);
 
 error_t cpymo_assetloader_get_fs_path(
@@ -3,6 +3,8 @@
 #include <assert.h>
 #include <cpymo_backend_audio.h>
 #include "cpymo_engine.h"
+#include "cpymo_audio_mixer.h"
+#include "cpymo_thread.h"
 
 #ifdef __CXX
 #undef av_err2str
@@ -10,13 +12,25 @@
 #endif
 
 #ifndef DISABLE_FFMPEG_AUDIO
+
+#if !defined CPYMO_NO_THREADS && !defined DISABLE_AUDIO_DECODE_THREAD
+#define ENABLE_AUDIO_DECODE_THREAD
+
+struct cpymo_audio_decoder {
+	cpymo_thread thread;
+	cpymo_mutex mutex;
+	cpymo_cond work, idle;
+	bool quit;
+};
+#endif
+
 static inline void cpymo_audio_channel_init(cpymo_audio_channel *c)
 {
-	c->enabled = false;
 	c->loop = false;
 	c->format_context = NULL;
 	c->codec_context = NULL;
 	c->swr_context = NULL;
+	c->converted_buf_size = 0;
 	c->converted_frame_current_offset = 0;
 	c->io_context = NULL;
 }
@@ -36,15 +50,36 @@ static void cpymo_audio_channel_reset_unsafe(cpymo_audio_channel *c)
 	cpymo_audio_channel_init(c);
 }
 
-static void cpymo_audio_channel_reset(cpymo_audio_channel *c)
+static inline bool cpymo_audio_decoder_running(const cpymo_audio_system *s)
 {
-	if (c->enabled) {
-		cpymo_backend_audio_lock();
-		c->enabled = false;
-		cpymo_backend_audio_unlock();
+	return s->decoder != NULL;
+}
 
-		cpymo_audio_channel_reset_unsafe(c);
+static void cpymo_audio_channel_reset(cpymo_audio_system *s, cpymo_audio_channel *c)
+{
+	if (!s->enabled) return;
+
+	cpymo_backend_audio_lock();
+	c->enabled = false;
+	cpymo_backend_audio_unlock();
+
+#ifdef ENABLE_AUDIO_DECODE_THREAD
+	if (s->decoder) {
+		cpymo_mutex_lock(&s->decoder->mutex);
+		c->decoding = false;
+		while (c->decoder_busy)
+			cpymo_cond_wait(&s->decoder->idle, &s->decoder->mutex);
+		cpymo_mutex_unlock(&s->decoder->mutex);
 	}
+#endif
+
+	// Neither the decoder nor the audio callback touches this channel now.
+	c->decoding = false;
+	cpymo_audio_channel_reset_unsafe(c);
+	c->ring_read = 0;
+	c->ring_write = 0;
+	c->ring_pending = 0;
+	c->decoder_done = 0;
 }
 
 static enum AVSampleFormat cpymo_audio_fmt2ffmpeg(
@@ -137,6 +172,7 @@ static error_t cpymo_audio_channel_convert_current_frame(cpymo_audio_channel *c)
 	if (samples == 0) {
 		memset(c->converted_buf, 0, c->converted_buf_all_size);
 		c->converted_buf_size = 0;
+		c->converted_frame_current_offset = 0;
 		return CPYMO_ERR_SUCC;
 	}
 	else if (samples < 0) {
@@ -217,70 +253,159 @@ static error_t cpymo_audio_channel_next_frame(cpymo_audio_channel *c)
 	}
 }}
 
-static void cpymo_audio_mix_samples(
-	void *dst_, 
-	const void *src_,
-	size_t len, 
-	cpymo_backend_audio_format fmt,
-	float volume)
+// Producer side of the ring buffer.
+// Moves converted samples into the ring buffer, 
+// and decodes the next frame if they are all used up.
+// Returns false if the ring buffer is full or there is nothing more to decode.
+static bool cpymo_audio_channel_decode_ahead(cpymo_audio_channel *c, size_t ring_size)
 {
+	size_t write = c->ring_write;
+	size_t free_size = ring_size - (write - cpymo_atomic_load_acquire(&c->ring_read));
+	if (free_size == 0 || c->decoder_done) return false;
+
+	if (c->converted_frame_current_offset == c->converted_buf_size) {
+		if (cpymo_audio_channel_next_frame(c) != CPYMO_ERR_SUCC) {
+			cpymo_audio_channel_reset_unsafe(c);
+			cpymo_atomic_store_release(&c->decoder_done, 1);
+			return false;
+		}
+	}
+
+	while (free_size > 0 && c->converted_frame_current_offset < c->converted_buf_size) {
+		const size_t offset = write % ring_size;
+		size_t size = c->converted_buf_size - c->converted_frame_current_offset;
+		if (size > free_size) size = free_size;
+		if (size > ring_size - offset) size = ring_size - offset;
+
+		memcpy(c->ring + offset, c->converted_buf + c->converted_frame_current_offset, size);
+		c->converted_frame_current_offset += size;
+		write += size;
+		free_size -= size;
+	}
 
-#define MIX_SIGNED(TYPE, TYPE_MAX_VAL) { \
-	TYPE *dst = (TYPE *)dst_; \
-	const TYPE *src = (TYPE *)src_; \
-	len /= sizeof(TYPE); \
-	\
-	for (size_t i = 0; i < len; ++i) { \
-		double src_sample = (float)src[i] / (float)TYPE_MAX_VAL; \
-		double dst_sample = (float)dst[i] / (float)TYPE_MAX_VAL; \
-		src_sample *= volume * 1.0f; \
-		dst_sample += src_sample; \
-		\
-		if (dst_sample > 1) dst_sample = 1; \
-		if (dst_sample < -1) dst_sample = -1; \
-		\
-		dst[i] = (TYPE)(dst_sample * TYPE_MAX_VAL); \
-	}\
+	cpymo_atomic_store_release(&c->ring_write, write);
+	return true;
 }
 
-	switch (fmt) {
-	case cpymo_backend_audio_s16: MIX_SIGNED(int16_t, INT16_MAX); break;
-	case cpymo_backend_audio_s32: MIX_SIGNED(int32_t, INT32_MAX); break;
-	case cpymo_backend_audio_f32: MIX_SIGNED(float, 1.0f); break;
+#ifdef ENABLE_AUDIO_DECODE_THREAD
+static void cpymo_audio_decoder(void *param)
+{
+	cpymo_audio_system *s = (cpymo_audio_system *)param;
+	struct cpymo_audio_decoder *d = s->decoder;
+
+	cpymo_mutex_lock(&d->mutex);
+	while (!d->quit) {
+		bool progress = false;
+
+		// One frame for each channel at a time, so a channel can be
+		// stopped without waiting for others to fill their ring buffers.
+		for (size_t i = 0; i < CPYMO_AUDIO_MAX_CHANNELS; ++i) {
+			cpymo_audio_channel *c = s->channels + i;
+			if (!c->decoding) continue;
+
+			c->decoder_busy = true;
+			cpymo_mutex_unlock(&d->mutex);
+			progress |= cpymo_audio_channel_decode_ahead(c, s->ring_size);
+			cpymo_mutex_lock(&d->mutex);
+			c->decoder_busy = false;
+
+			if (c->decoder_done) c->decoding = false;
+		}
+
+		cpymo_cond_broadcast(&d->idle);
+
+		// The audio callback signals without holding the mutex, 
+		// a lost wakeup only delays decoding until its next call.
+		if (!progress && !d->quit)
+			cpymo_cond_wait(&d->work, &d->mutex);
 	}
+	cpymo_mutex_unlock(&d->mutex);
 }
 
-static void cpymo_audio_channel_mix_samples(uint8_t *dst, size_t len, cpymo_audio_channel *c)
+static error_t cpymo_audio_decoder_start(cpymo_audio_system *s)
 {
-	const cpymo_backend_audio_info *info = cpymo_backend_audio_get_info();
+	struct cpymo_audio_decoder *d = 
+		(struct cpymo_audio_decoder *)malloc(sizeof(struct cpymo_audio_decoder));
+	if (d == NULL) return CPYMO_ERR_OUT_OF_MEM;
 
-	while (len > 0) {
-		uint8_t *src = c->converted_buf + c->converted_frame_current_offset;
-		size_t src_size = c->converted_buf_size - c->converted_frame_current_offset;
+	d->quit = false;
 
-		if (src_size == 0) {
-			error_t err = cpymo_audio_channel_next_frame(c);
-			if (err == CPYMO_ERR_SUCC) 
-				continue;
-			else
-				goto FILL_BLANK_AND_RESET;
-		}
-		else {
-			size_t write_size = src_size;
-			if (write_size > len) write_size = len;
+	error_t err = cpymo_mutex_init(&d->mutex);
+	if (err != CPYMO_ERR_SUCC) {
+		free(d);
+		return err;
+	}
 
-			cpymo_audio_mix_samples(dst, src, write_size, info->format, c->volume);
-			c->converted_frame_current_offset += write_size;
-			dst += write_size;
-			len -= write_size;
-		}
+	err = cpymo_cond_init(&d->work);
+	if (err != CPYMO_ERR_SUCC) {
+		cpymo_mutex_free(&d->mutex);
+		free(d);
+		return err;
 	}
 
-	return;
+	err = cpymo_cond_init(&d->idle);
+	if (err != CPYMO_ERR_SUCC) {
+		cpymo_cond_free(&d->work);
+		cpymo_mutex_free(&d->mutex);
+		free(d);
+		return err;
+	}
 
-FILL_BLANK_AND_RESET:
-	cpymo_audio_channel_reset_unsafe(c);
-	return;
+	// The thread reads s->decoder as soon as it starts.
+	s->decoder = d;
+	err = cpymo_thread_create(&d->thread, &cpymo_audio_decoder, s);
+	if (err != CPYMO_ERR_SUCC) {
+		s->decoder = NULL;
+		cpymo_cond_free(&d->idle);
+		cpymo_cond_free(&d->work);
+		cpymo_mutex_free(&d->mutex);
+		free(d);
+		return err;
+	}
+
+	return CPYMO_ERR_SUCC;
+}
+
+static void cpymo_audio_decoder_stop(cpymo_audio_system *s)
+{
+	struct cpymo_audio_decoder *d = s->decoder;
+
+	cpymo_mutex_lock(&d->mutex);
+	d->quit = true;
+	cpymo_cond_signal(&d->work);
+	cpymo_mutex_unlock(&d->mutex);
+
+	cpymo_thread_join(d->thread);
+
+	cpymo_cond_free(&d->idle);
+	cpymo_cond_free(&d->work);
+	cpymo_mutex_free(&d->mutex);
+	free(d);
+	s->decoder = NULL;
+}
+#endif
+
+static void cpymo_audio_channel_start(cpymo_audio_system *s, cpymo_audio_channel *c)
+{
+	c->lowest_buffered = s->ring_size;
+
+	// Samples of the first frame.
+	cpymo_audio_channel_decode_ahead(c, s->ring_size);
+
+#ifdef ENABLE_AUDIO_DECODE_THREAD
+	if (s->decoder) {
+		cpymo_mutex_lock(&s->decoder->mutex);
+		c->decoding = true;
+		cpymo_cond_signal(&s->decoder->work);
+		cpymo_mutex_unlock(&s->decoder->mutex);
+	}
+	else
+#endif
+	c->decoding = true;
+
+	cpymo_backend_audio_lock();
+	c->enabled = true;
+	cpymo_backend_audio_unlock();
 }
 
 static int cpymo_audio_packaged_audio_ffmpeg_read_packet(void *opaque, uint8_t *buf, int buf_size)
@@ -309,7 +434,7 @@ static int64_t cpymo_audio_packaged_audio_ffmpeg_seek(void *opaque, int64_t offs
 }
 
 static error_t cpymo_audio_channel_play_file(
-	cpymo_audio_channel *c, 
+	cpymo_audio_system *s, cpymo_audio_channel *c, 
 	const char * filename, const cpymo_package_stream_reader *package_reader, 
 	bool loop)
 {
@@ -321,7 +446,7 @@ static error_t cpymo_audio_channel_play_file(
 	if (package_reader) { assert(filename == NULL); }
 	assert(!(filename == NULL && package_reader == NULL));
 
-	cpymo_audio_channel_reset(c);
+	cpymo_audio_channel_reset(s, c);
 	// everything safe now.
 
 	assert(c->enabled == false);
@@ -465,33 +590,93 @@ static error_t cpymo_audio_channel_play_file(
 		return CPYMO_ERR_SUCC;
 	}
 
-	cpymo_backend_audio_lock();
-	c->enabled = true;
-	cpymo_backend_audio_unlock();
+	cpymo_audio_channel_start(s, c);
 	return CPYMO_ERR_SUCC;
 }
 
 void cpymo_audio_init(cpymo_audio_system *s)
 {
-	s->enabled = cpymo_backend_audio_get_info() != NULL;
+	const cpymo_backend_audio_info *info = cpymo_backend_audio_get_info();
+	s->enabled = info != NULL;
 
 	for (size_t i = 0; i < CPYMO_AUDIO_MAX_CHANNELS; ++i) {
-		cpymo_audio_channel_init(s->channels + i);
-		s->channels[i].packet = NULL;
-		s->channels[i].frame = NULL;
-		s->channels[i].converted_buf = NULL;
-		s->channels[i].converted_buf_all_size = 0;
-		s->channels[i].volume = 0;
+		cpymo_audio_channel *c = s->channels + i;
+		cpymo_audio_channel_init(c);
+		c->enabled = false;
+		c->packet = NULL;
+		c->frame = NULL;
+		c->converted_buf = NULL;
+		c->converted_buf_all_size = 0;
+		c->volume = 0;
+		c->ring = NULL;
+		c->ring_read = 0;
+		c->ring_write = 0;
+		c->ring_pending = 0;
+		c->decoder_done = 0;
+		c->decoding = false;
+		c->decoder_busy = false;
+		c->underruns = 0;
+		c->lowest_buffered = 0;
 	}
 
 	s->bgm_name = NULL;
 	s->se_name = NULL;
+	s->ring_size = 0;
+	s->bytes_per_second = 0;
+	s->decoder = NULL;
+
+	if (!s->enabled) return;
+
+	const size_t frame_size = info->channels *
+		(info->format == cpymo_backend_audio_s16 ? sizeof(int16_t) : sizeof(int32_t));
+	s->bytes_per_second = info->freq * frame_size;
+	s->ring_size = 
+		s->bytes_per_second * CPYMO_AUDIO_DECODE_AHEAD_MS / 1000 / frame_size * frame_size;
+
+	for (size_t i = 0; i < CPYMO_AUDIO_MAX_CHANNELS; ++i) {
+		s->channels[i].lowest_buffered = s->ring_size;
+		s->channels[i].ring = (uint8_t *)malloc(s->ring_size);
+		if (s->channels[i].ring == NULL) {
+			printf("[Error] Can not allocate audio buffers, audio disabled.\n");
+			for (size_t j = 0; j < i; ++j) {
+				free(s->channels[j].ring);
+				s->channels[j].ring = NULL;
+			}
+
+			s->enabled = false;
+			return;
+		}
+	}
+
+#ifdef ENABLE_AUDIO_DECODE_THREAD
+	if (cpymo_audio_decoder_start(s) != CPYMO_ERR_SUCC)
+		printf("[Warning] Can not start audio decoder thread, decoding in audio callback.\n");
+#endif
 }
 
 void cpymo_audio_free(cpymo_audio_system *s)
 {
 	if (s->enabled == false) return;
 
+#ifdef ENABLE_AUDIO_DECODE_THREAD
+	if (s->decoder) cpymo_audio_decoder_stop(s);
+#endif
+
+#ifndef NDEBUG
+	{
+		cpymo_audio_stats stats;
+		cpymo_audio_get_stats(&stats, s);
+		printf("[Info] Audio: %u/%u/%u underruns, lowest decode-ahead %u/%u/%u ms of %u ms (BGM/SE/VO).\n",
+			stats.underruns[CPYMO_AUDIO_CHANNEL_BGM],
+			stats.underruns[CPYMO_AUDIO_CHANNEL_SE],
+			stats.underruns[CPYMO_AUDIO_CHANNEL_VO],
+			(unsigned)(stats.lowest_buffered[CPYMO_AUDIO_CHANNEL_BGM] * 1000 / stats.bytes_per_second),
+			(unsigned)(stats.lowest_buffered[CPYMO_AUDIO_CHANNEL_SE] * 1000 / stats.bytes_per_second),
+			(unsigned)(stats.lowest_buffered[CPYMO_AUDIO_CHANNEL_VO] * 1000 / stats.bytes_per_second),
+			(unsigned)(stats.capacity * 1000 / stats.bytes_per_second));
+	}
+#endif
+
 	cpymo_backend_audio_lock();
 
 	for (size_t i = 0; i < CPYMO_AUDIO_MAX_CHANNELS; ++i) {
@@ -501,6 +686,7 @@ void cpymo_audio_free(cpymo_audio_system *s)
 		if (s->channels[i].packet) av_packet_free(&s->channels[i].packet);
 		if (s->channels[i].frame) av_frame_free(&s->channels[i].frame);
 		if (s->channels[i].converted_buf) free(s->channels[i].converted_buf);
+		free(s->channels[i].ring);
 	}
 
 	cpymo_backend_audio_unlock();
@@ -511,44 +697,150 @@ void cpymo_audio_free(cpymo_audio_system *s)
 	if (s->se_name) free(s->se_name);
 }
 
+void cpymo_audio_get_stats(cpymo_audio_stats *out, const cpymo_audio_system *s)
+{
+	memset(out, 0, sizeof(*out));
+	if (!s->enabled) return;
+
+	for (size_t i = 0; i < CPYMO_AUDIO_MAX_CHANNELS; ++i) {
+		const cpymo_audio_channel *c = s->channels + i;
+		const size_t read = cpymo_atomic_load_acquire(&c->ring_read);
+		out->underruns[i] = c->underruns;
+		out->buffered[i] = cpymo_atomic_load_acquire(&c->ring_write) - read;
+		out->lowest_buffered[i] = c->lowest_buffered;
+	}
+
+	out->capacity = s->ring_size;
+	out->bytes_per_second = s->bytes_per_second;
+	out->decode_thread = cpymo_audio_decoder_running(s);
+}
+
+// Consumer side of the ring buffer, called from the audio callback.
+// Samples handed out with ring_pending are used after this.
+static void cpymo_audio_channel_release(cpymo_audio_system *s, cpymo_audio_channel *c)
+{
+	if (c->ring_pending) {
+		cpymo_atomic_store_release(&c->ring_read, c->ring_read + c->ring_pending);
+		c->ring_pending = 0;
+
+#ifdef ENABLE_AUDIO_DECODE_THREAD
+		if (s->decoder) cpymo_cond_signal(&s->decoder->work);
+#endif
+	}
+}
+
+// Returns how many bytes after ring_read can be read, at most len.
+// The first call of each audio callback records underruns.
+static size_t cpymo_audio_channel_acquire(cpymo_audio_system *s, cpymo_audio_channel *c, size_t len)
+{
+	const bool first_call = c->ring_pending == 0;
+	cpymo_audio_channel_release(s, c);
+
+	const size_t read = c->ring_read;
+	if (!cpymo_audio_decoder_running(s)) {
+		while (c->ring_write - read < len 
+			&& cpymo_audio_channel_decode_ahead(c, s->ring_size));
+	}
+
+	// Load decoder_done first, so no samples written before it are missed.
+	const bool done = cpymo_atomic_load_acquire(&c->decoder_done) != 0;
+	const size_t buffered = cpymo_atomic_load_acquire(&c->ring_write) - read;
+
+	if (first_call) {
+		if (buffered < c->lowest_buffered) c->lowest_buffered = buffered;
+		if (buffered < len && !done) c->underruns++;
+	}
+
+	if (buffered == 0 && done) c->enabled = false;
+	return buffered < len ? buffered : len;
+}
+
 bool cpymo_audio_channel_get_samples(void **samples, size_t *len, size_t cid, cpymo_audio_system *s)
-{ RETRY: {
+{
 	if (!s->enabled) return false;
 
 	cpymo_audio_channel *c = &s->channels[cid];
 	if (!c->enabled) return false;
 
-	size_t writeable_size = c->converted_buf_size - c->converted_frame_current_offset;
+	size_t size = cpymo_audio_channel_acquire(s, c, *len);
+	if (size == 0) return false;
 
-	if (writeable_size == 0) {
-		error_t err = cpymo_audio_channel_next_frame(c);
-		if (err == CPYMO_ERR_SUCC) goto RETRY;
-		else {
-			cpymo_audio_channel_reset_unsafe(c);
-			return false;
-		}
-	}
-
-	*samples = c->converted_buf + c->converted_frame_current_offset;
-
-	if (writeable_size > *len) writeable_size = *len;
-	*len = writeable_size;
-	c->converted_frame_current_offset += writeable_size;
+	const size_t offset = c->ring_read % s->ring_size;
+	if (size > s->ring_size - offset) size = s->ring_size - offset;
 
+	*samples = c->ring + offset;
+	*len = size;
+	c->ring_pending = size;
 	return true;
-} }
+}
 
 void cpymo_audio_copy_mixed_samples(void * dst, size_t len, cpymo_audio_system *s)
 {
-	if (s->enabled == false) return;
+	if (s->enabled == false) {
+		memset(dst, 0, len);
+		return;
+	}
 
-	memset(dst, 0, len);
+	// Samples of a channel are in one or two spans, 
+	// as they may wrap around the end of its ring buffer.
+	struct {
+		cpymo_audio_channel *channel;
+		const uint8_t *span[2];
+		size_t span_begin[2], span_end[2];
+	} playing[CPYMO_AUDIO_MAX_CHANNELS];
+	size_t playing_count = 0;
+
+	for (size_t cid = 0; cid < CPYMO_AUDIO_MAX_CHANNELS; ++cid) {
+		cpymo_audio_channel *c = s->channels + cid;
+		if (!c->enabled) continue;
+
+		const size_t size = cpymo_audio_channel_acquire(s, c, len);
+		if (size == 0) continue;
+
+		const size_t offset = c->ring_read % s->ring_size;
+		size_t first = s->ring_size - offset;
+		if (first > size) first = size;
+
+		playing[playing_count].channel = c;
+		playing[playing_count].span[0] = c->ring + offset;
+		playing[playing_count].span_begin[0] = 0;
+		playing[playing_count].span_end[0] = first;
+		playing[playing_count].span[1] = c->ring;
+		playing[playing_count].span_begin[1] = first;
+		playing[playing_count].span_end[1] = size;
+		playing_count++;
+
+		c->ring_pending = size;
+	}
 
-	for (size_t i = 0; i < CPYMO_AUDIO_MAX_CHANNELS; ++i) {
-		if (s->channels[i].enabled) {
-			cpymo_audio_channel_mix_samples((uint8_t *)dst, len, s->channels + i);
+	// Mix all channels in one pass, split where a channel
+	// moves to its next span or runs out of samples.
+	const cpymo_backend_audio_info *info = cpymo_backend_audio_get_info();
+	size_t pos = 0;
+	while (pos < len) {
+		const void *srcs[CPYMO_AUDIO_MAX_CHANNELS];
+		float volumes[CPYMO_AUDIO_MAX_CHANNELS];
+		size_t count = 0, end = len;
+
+		for (size_t i = 0; i < playing_count; ++i) {
+			for (size_t j = 0; j < 2; ++j) {
+				if (pos >= playing[i].span_begin[j] && pos < playing[i].span_end[j]) {
+					srcs[count] = playing[i].span[j] + (pos - playing[i].span_begin[j]);
+					volumes[count] = playing[i].channel->volume;
+					count++;
+
+					if (playing[i].span_end[j] < end) end = playing[i].span_end[j];
+					break;
+				}
+			}
 		}
+
+		cpymo_audio_mix((uint8_t *)dst + pos, end - pos, info->format, srcs, volumes, count);
+		pos = end;
 	}
+
+	for (size_t i = 0; i < playing_count; ++i)
+		cpymo_audio_channel_release(s, playing[i].channel);
 }
 
 bool cpymo_audio_enabled(cpymo_engine * e)
@@ -586,6 +878,7 @@ static error_t cpymo_audio_high_level_play(
 			CPYMO_THROW(err);
 
 			err = cpymo_audio_channel_play_file(
+				&e->audio,
 				&e->audio.channels[channel],
 				NULL,
 				&r,
@@ -615,6 +908,7 @@ static error_t cpymo_audio_high_level_play(
 			#endif
 
 			err = cpymo_audio_channel_play_file(
+				&e->audio,
 				&e->audio.channels[channel],
 				path,
 				NULL,
@@ -666,6 +960,7 @@ void cpymo_audio_bgm_stop(cpymo_engine * engine)
 
 	if (engine->audio.enabled) {
 		cpymo_audio_channel_reset(
+			&engine->audio,
 			&engine->audio.channels[CPYMO_AUDIO_CHANNEL_BGM]);
 	}
 }
@@ -700,6 +995,7 @@ void cpymo_audio_se_stop(cpymo_engine *e)
 
 	if (e->audio.enabled) {
 		cpymo_audio_channel_reset(
+			&e->audio,
 			&e->audio.channels[CPYMO_AUDIO_CHANNEL_SE]);
 	}
 }
@@ -714,12 +1010,13 @@ error_t cpymo_audio_vo_play(cpymo_engine * e, cpymo_str voname)
 
 void cpymo_audio_vo_stop(cpymo_engine * e)
 {
-	cpymo_audio_channel_reset(e->audio.channels + CPYMO_AUDIO_CHANNEL_VO);
+	cpymo_audio_channel_reset(&e->audio, e->audio.channels + CPYMO_AUDIO_CHANNEL_VO);
 }
 
 void cpymo_audio_play_video(cpymo_engine * e, const char * path)
 {
 	cpymo_audio_channel_play_file(
+		&e->audio,
 		&e->audio.channels[CPYMO_AUDIO_CHANNEL_BGM],
 		path,
 		NULL,
@@ -775,6 +1072,9 @@ void cpymo_audio_init(cpymo_audio_system *s)
 
 void cpymo_audio_free(cpymo_audio_system *s) {}
 
+void cpymo_audio_get_stats(cpymo_audio_stats *out, const cpymo_audio_system *s)
+{ memset(out, 0, sizeof(*out)); }
+
 float cpymo_audio_get_channel_volume(size_t cid, const cpymo_audio_system *s)
 {
 	return s->volumes[cid];
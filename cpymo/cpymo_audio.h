@@ -26,6 +26,14 @@ typedef struct {
 
 #if (!defined DISABLE_FFMPEG_AUDIO)
 
+// Audio is decoded ahead by a background thread into a ring buffer
+// for each channel, so the audio callback only has to copy and mix samples.
+// Without threads, or with DISABLE_AUDIO_DECODE_THREAD,
+// the audio callback fills the ring buffers by itself.
+#ifndef CPYMO_AUDIO_DECODE_AHEAD_MS
+#define CPYMO_AUDIO_DECODE_AHEAD_MS 500
+#endif
+
 #ifdef __CXX
 extern "C" {
 #endif
@@ -58,6 +66,19 @@ typedef struct {
 	cpymo_package_stream_reader package_reader;
 
 	int stream_id;
+
+	// Decoded samples, written by the decoder and read by the audio callback.
+	// ring_pending bytes after ring_read are handed out to the audio callback
+	// and will be released on its next call.
+	uint8_t *ring;
+	volatile size_t ring_read, ring_write, decoder_done;
+	size_t ring_pending;
+
+	// Guarded by the decoder lock.
+	bool decoding, decoder_busy;
+
+	unsigned underruns;
+	size_t lowest_buffered;
 } cpymo_audio_channel;
 
 typedef struct {
@@ -65,6 +86,11 @@ typedef struct {
 	cpymo_audio_channel channels[CPYMO_AUDIO_MAX_CHANNELS];
 
 	char *bgm_name, *se_name;
+
+	size_t ring_size, bytes_per_second;
+
+	// Decoder thread, NULL when the audio callback decodes.
+	struct cpymo_audio_decoder *decoder;
 } cpymo_audio_system;
 
 #elif (!defined DISABLE_AUDIO)
@@ -81,6 +107,21 @@ bool cpymo_audio_channel_get_samples(
 void cpymo_audio_init(cpymo_audio_system *);
 void cpymo_audio_free(cpymo_audio_system *);
 
+typedef struct {
+	// underruns: times the audio callback asked a playing channel for samples
+	// but nothing was decoded yet.
+	// buffered: bytes decoded ahead for each channel.
+	// lowest_buffered: the least bytes decoded ahead when the audio callback
+	// came for samples, since the channel started playing.
+	unsigned underruns[CPYMO_AUDIO_MAX_CHANNELS];
+	size_t buffered[CPYMO_AUDIO_MAX_CHANNELS];
+	size_t lowest_buffered[CPYMO_AUDIO_MAX_CHANNELS];
+	size_t capacity, bytes_per_second;
+	bool decode_thread;
+} cpymo_audio_stats;
+
+void cpymo_audio_get_stats(cpymo_audio_stats *out, const cpymo_audio_system *);
+
 float cpymo_audio_get_channel_volume(size_t cid, const cpymo_audio_system *s);
 
 void cpymo_audio_set_channel_volume(size_t cid, cpymo_audio_system *s, float vol);
@@ -0,0 +1,268 @@
+﻿#include "cpymo_prelude.h"
+#include "cpymo_audio_mixer.h"
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef DISABLE_AUDIO_MIXER_SIMD
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+	(defined(__i386__) && defined(__SSE2__)) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPYMO_AUDIO_MIXER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CPYMO_AUDIO_MIXER_NEON
+#include <arm_neon.h>
+#endif
+
+#endif
+
+// Samples are summed, then clipped and rounded to nearest.
+// s16 and f32 are summed as float, s32 needs more than the 24 bits
+// of a float so it is summed as double.
+#define S16_MIN -32768.0f
+#define S16_MAX 32767.0f
+#define S32_MIN -2147483648.0
+#define S32_MAX 2147483647.0
+
+static inline float cpymo_audio_mixer_clamp(float x, float lo, float hi)
+{
+	if (x < lo) return lo;
+	if (x > hi) return hi;
+	return x;
+}
+
+// The volume of s32 keeps 19 fraction bits, so every sample * volume
+// is exact in double and the sum is the same whether or not
+// the compiler fuses the multiply and add.
+static inline double cpymo_audio_mixer_volume_s32(float volume)
+{
+	return (double)(int32_t)(volume * 524288.0f + 0.5f) / 524288.0;
+}
+
+#define SUM(TYPE, I) \
+	float sum = 0; \
+	for (size_t k = 0; k < count; ++k) \
+		sum += (float)((const TYPE *)srcs[k])[I] * volumes[k];
+
+#define SUM_S32(I) \
+	double sum = 0; \
+	for (size_t k = 0; k < count; ++k) \
+		sum += (double)((const int32_t *)srcs[k])[I] * cpymo_audio_mixer_volume_s32(volumes[k]);
+
+static void cpymo_audio_mix_scalar_from(
+	void *dst, size_t begin, size_t len, cpymo_backend_audio_format fmt,
+	const void *const *srcs, const float *volumes, size_t count)
+{
+	switch (fmt) {
+	case cpymo_backend_audio_s16:
+		for (size_t i = begin; i < len / sizeof(int16_t); ++i) {
+			SUM(int16_t, i);
+			((int16_t *)dst)[i] = 
+				(int16_t)lrintf(cpymo_audio_mixer_clamp(sum, S16_MIN, S16_MAX));
+		}
+		break;
+	case cpymo_backend_audio_s32:
+		for (size_t i = begin; i < len / sizeof(int32_t); ++i) {
+			SUM_S32(i);
+			((int32_t *)dst)[i] = 
+				(int32_t)lrint(sum < S32_MIN ? S32_MIN : sum > S32_MAX ? S32_MAX : sum);
+		}
+		break;
+	case cpymo_backend_audio_f32:
+		for (size_t i = begin; i < len / sizeof(float); ++i) {
+			SUM(float, i);
+			((float *)dst)[i] = cpymo_audio_mixer_clamp(sum, -1.0f, 1.0f);
+		}
+		break;
+	}
+}
+
+#undef SUM
+#undef SUM_S32
+
+void cpymo_audio_mix_scalar(
+	void *dst, size_t len, cpymo_backend_audio_format fmt,
+	const void *const *srcs, const float *volumes, size_t count)
+{
+	cpymo_audio_mix_scalar_from(dst, 0, len, fmt, srcs, volumes, count);
+}
+
+#ifdef CPYMO_AUDIO_MIXER_SSE2
+static void cpymo_audio_mix_sse2(
+	void *dst, size_t len, cpymo_backend_audio_format fmt,
+	const void *const *srcs, const float *volumes, size_t count)
+{
+	size_t i = 0;
+
+	switch (fmt) {
+	case cpymo_backend_audio_s16: {
+		const __m128 lo = _mm_set1_ps(S16_MIN), hi = _mm_set1_ps(S16_MAX);
+		for (; i + 8 <= len / sizeof(int16_t); i += 8) {
+			__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+			for (size_t k = 0; k < count; ++k) {
+				const __m128i x = _mm_loadu_si128((const __m128i *)((const int16_t *)srcs[k] + i));
+				const __m128 v = _mm_set1_ps(volumes[k]);
+				const __m128 x0 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+				const __m128 x1 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+				sum0 = _mm_add_ps(sum0, _mm_mul_ps(x0, v));
+				sum1 = _mm_add_ps(sum1, _mm_mul_ps(x1, v));
+			}
+
+			sum0 = _mm_min_ps(_mm_max_ps(sum0, lo), hi);
+			sum1 = _mm_min_ps(_mm_max_ps(sum1, lo), hi);
+			_mm_storeu_si128((__m128i *)((int16_t *)dst + i), 
+				_mm_packs_epi32(_mm_cvtps_epi32(sum0), _mm_cvtps_epi32(sum1)));
+		}
+		break;
+	}
+	case cpymo_backend_audio_s32: {
+		const __m128d lo = _mm_set1_pd(S32_MIN), hi = _mm_set1_pd(S32_MAX);
+		for (; i + 4 <= len / sizeof(int32_t); i += 4) {
+			__m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+			for (size_t k = 0; k < count; ++k) {
+				const __m128i x = _mm_loadu_si128((const __m128i *)((const int32_t *)srcs[k] + i));
+				const __m128d v = _mm_set1_pd(cpymo_audio_mixer_volume_s32(volumes[k]));
+				const __m128d x0 = _mm_cvtepi32_pd(x);
+				const __m128d x1 = _mm_cvtepi32_pd(_mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+				sum0 = _mm_add_pd(sum0, _mm_mul_pd(x0, v));
+				sum1 = _mm_add_pd(sum1, _mm_mul_pd(x1, v));
+			}
+
+			sum0 = _mm_min_pd(_mm_max_pd(sum0, lo), hi);
+			sum1 = _mm_min_pd(_mm_max_pd(sum1, lo), hi);
+			_mm_storeu_si128((__m128i *)((int32_t *)dst + i), 
+				_mm_unpacklo_epi64(_mm_cvtpd_epi32(sum0), _mm_cvtpd_epi32(sum1)));
+		}
+		break;
+	}
+	case cpymo_backend_audio_f32: {
+		const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+		for (; i + 4 <= len / sizeof(float); i += 4) {
+			__m128 sum = _mm_setzero_ps();
+			for (size_t k = 0; k < count; ++k) {
+				const __m128 x = _mm_loadu_ps((const float *)srcs[k] + i);
+				sum = _mm_add_ps(sum, _mm_mul_ps(x, _mm_set1_ps(volumes[k])));
+			}
+
+			_mm_storeu_ps((float *)dst + i, _mm_min_ps(_mm_max_ps(sum, lo), hi));
+		}
+		break;
+	}
+	}
+
+	cpymo_audio_mix_scalar_from(dst, i, len, fmt, srcs, volumes, count);
+}
+#endif
+
+#ifdef CPYMO_AUDIO_MIXER_NEON
+static inline int32x4_t cpymo_audio_mixer_round_neon(float32x4_t x)
+{
+#ifdef __aarch64__
+	return vcvtnq_s32_f32(x);
+#else
+	// ARMv7 only truncates, round half away from zero instead.
+	const uint32x4_t negative = vcltq_f32(x, vdupq_n_f32(0));
+	const float32x4_t half = vbslq_f32(negative, vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+	return vcvtq_s32_f32(vaddq_f32(x, half));
+#endif
+}
+
+static void cpymo_audio_mix_neon(
+	void *dst, size_t len, cpymo_backend_audio_format fmt,
+	const void *const *srcs, const float *volumes, size_t count)
+{
+	size_t i = 0;
+
+	switch (fmt) {
+	case cpymo_backend_audio_s16: {
+		const float32x4_t lo = vdupq_n_f32(S16_MIN), hi = vdupq_n_f32(S16_MAX);
+		for (; i + 8 <= len / sizeof(int16_t); i += 8) {
+			float32x4_t sum0 = vdupq_n_f32(0), sum1 = vdupq_n_f32(0);
+			for (size_t k = 0; k < count; ++k) {
+				const int16x8_t x = vld1q_s16((const int16_t *)srcs[k] + i);
+				const float32x4_t x0 = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+				const float32x4_t x1 = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+				sum0 = vmlaq_n_f32(sum0, x0, volumes[k]);
+				sum1 = vmlaq_n_f32(sum1, x1, volumes[k]);
+			}
+
+			sum0 = vminq_f32(vmaxq_f32(sum0, lo), hi);
+			sum1 = vminq_f32(vmaxq_f32(sum1, lo), hi);
+			vst1q_s16((int16_t *)dst + i, vcombine_s16(
+				vqmovn_s32(cpymo_audio_mixer_round_neon(sum0)),
+				vqmovn_s32(cpymo_audio_mixer_round_neon(sum1))));
+		}
+		break;
+	}
+#ifdef __aarch64__
+	case cpymo_backend_audio_s32: {
+		const float64x2_t lo = vdupq_n_f64(S32_MIN), hi = vdupq_n_f64(S32_MAX);
+		for (; i + 4 <= len / sizeof(int32_t); i += 4) {
+			float64x2_t sum0 = vdupq_n_f64(0), sum1 = vdupq_n_f64(0);
+			for (size_t k = 0; k < count; ++k) {
+				const int32x4_t x = vld1q_s32((const int32_t *)srcs[k] + i);
+				const float64x2_t v = vdupq_n_f64(cpymo_audio_mixer_volume_s32(volumes[k]));
+				const float64x2_t x0 = vcvtq_f64_s64(vmovl_s32(vget_low_s32(x)));
+				const float64x2_t x1 = vcvtq_f64_s64(vmovl_s32(vget_high_s32(x)));
+				sum0 = vfmaq_f64(sum0, x0, v);
+				sum1 = vfmaq_f64(sum1, x1, v);
+			}
+
+			sum0 = vminq_f64(vmaxq_f64(sum0, lo), hi);
+			sum1 = vminq_f64(vmaxq_f64(sum1, lo), hi);
+			vst1q_s32((int32_t *)dst + i, vcombine_s32(
+				vmovn_s64(vcvtnq_s64_f64(sum0)), vmovn_s64(vcvtnq_s64_f64(sum1))));
+		}
+		break;
+	}
+#else
+	// ARMv7 NEON has no double, s32 is left to the scalar tail.
+	case cpymo_backend_audio_s32: break;
+#endif
+	case cpymo_backend_audio_f32: {
+		const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+		for (; i + 4 <= len / sizeof(float); i += 4) {
+			float32x4_t sum = vdupq_n_f32(0);
+			for (size_t k = 0; k < count; ++k)
+				sum = vmlaq_n_f32(sum, vld1q_f32((const float *)srcs[k] + i), volumes[k]);
+
+			vst1q_f32((float *)dst + i, vminq_f32(vmaxq_f32(sum, lo), hi));
+		}
+		break;
+	}
+	}
+
+	cpymo_audio_mix_scalar_from(dst, i, len, fmt, srcs, volumes, count);
+}
+#endif
+
+void cpymo_audio_mix(
+	void *dst, size_t len, cpymo_backend_audio_format fmt,
+	const void *const *srcs, const float *volumes, size_t count)
+{
+	if (count == 0) {
+		memset(dst, 0, len);
+		return;
+	}
+
+#if defined CPYMO_AUDIO_MIXER_SSE2
+	cpymo_audio_mix_sse2(dst, len, fmt, srcs, volumes, count);
+#elif defined CPYMO_AUDIO_MIXER_NEON
+	cpymo_audio_mix_neon(dst, len, fmt, srcs, volumes, count);
+#else
+	cpymo_audio_mix_scalar(dst, len, fmt, srcs, volumes, count);
+#endif
+}
+
+const char *cpymo_audio_mixer_simd(void)
+{
+#if defined CPYMO_AUDIO_MIXER_SSE2
+	return "sse2";
+#elif defined CPYMO_AUDIO_MIXER_NEON
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,23 @@
+#ifndef INCLUDE_CPYMO_AUDIO_MIXER
+#define INCLUDE_CPYMO_AUDIO_MIXER
+
+#include <stddef.h>
+#include <cpymo_backend_audio.h>
+
+// Mixes `count` sources into dst in one pass.
+// Each sample of dst becomes the sum of the source samples scaled by
+// their volume, clipped to the range of the sample format.
+// dst is overwritten, it and every source are `len` bytes long.
+void cpymo_audio_mix(
+	void *dst, size_t len, cpymo_backend_audio_format fmt,
+	const void *const *srcs, const float *volumes, size_t count);
+
+// Same as cpymo_audio_mix() but never uses SIMD.
+void cpymo_audio_mix_scalar(
+	void *dst, size_t len, cpymo_backend_audio_format fmt,
+	const void *const *srcs, const float *volumes, size_t count);
+
+// Instruction set used by cpymo_audio_mix(): "sse2", "neon" or "scalar".
+const char *cpymo_audio_mixer_simd(void);
+
+#endif
@@ -12,8 +12,8 @@
 #endif
 
 typedef struct cpymo_backlog_record {
-	bool owning_name;
-	cpymo_backend_text name, text_render;
+	cpymo_name_cache_entry *name;
+	cpymo_backend_text text_render;
 	char vo_filename[32];
 	char *text;
 	float font_size;
@@ -29,7 +29,6 @@ error_t cpymo_backlog_init(cpymo_backlog *b)
 	if (b->records == NULL) return CPYMO_ERR_OUT_OF_MEM;
 	b->next_record_to_write = 0;
 	b->pending_vo_filename[0] = '\0';
-	b->owning_name = false;
 	b->pending_name = NULL;
 
 #ifdef ENABLE_TEXT_EXTRACT
@@ -38,7 +37,6 @@ error_t cpymo_backlog_init(cpymo_backlog *b)
 
 	for (size_t i = 0; i < CPYMO_BACKLOG_MAX_RECORDS; i++) {
 		b->records[i].vo_filename[0] = '\0';
-		b->records[i].owning_name = false;
 		b->records[i].name = NULL;
 		b->records[i].text = NULL;
 		b->records[i].text_render = NULL;
@@ -53,13 +51,11 @@ error_t cpymo_backlog_init(cpymo_backlog *b)
 
 static void cpymo_backlog_record_clean(cpymo_backlog_record *rec)
 {
-	if (rec->owning_name && rec->name) {
-		cpymo_backend_text_free(rec->name);
+	cpymo_name_cache_unref(rec->name);
 
 #ifdef ENABLE_TEXT_EXTRACT
-		if (rec->name_str) free(rec->name_str);
+	if (rec->name_str) free(rec->name_str);
 #endif
-	}
 
 	if (rec->text_render) cpymo_backend_text_free(rec->text_render);
 	rec->text_render = NULL;
@@ -67,7 +63,6 @@ static void cpymo_backlog_record_clean(cpymo_backlog_record *rec)
 	if (rec->text) free(rec->text);
 	rec->text = NULL;
 
-	rec->owning_name = false;
 	rec->name = NULL;
 	rec->vo_filename[0] = '\0';
 
@@ -78,13 +73,11 @@ static void cpymo_backlog_record_clean(cpymo_backlog_record *rec)
 
 void cpymo_backlog_free(cpymo_backlog *b)
 {
-	if (b->owning_name && b->pending_name) {
-		cpymo_backend_text_free(b->pending_name);
+	cpymo_name_cache_unref(b->pending_name);
 
 #ifdef ENABLE_TEXT_EXTRACT
-		if (b->pending_name_str) free(b->pending_name_str);
+	if (b->pending_name_str) free(b->pending_name_str);
 #endif
-	}
 
 	for (size_t i = 0; i < CPYMO_BACKLOG_MAX_RECORDS; i++) {
 		cpymo_backlog_record *rec = &b->records[i];
@@ -101,16 +94,13 @@ void cpymo_backlog_record_write_vo(cpymo_backlog *b, cpymo_str vo)
 }
 
 void cpymo_backlog_record_write_name(
-	cpymo_backlog *b, cpymo_backend_text name, cpymo_str name_text)
+	cpymo_backlog *b, cpymo_name_cache_entry *name, cpymo_str name_text)
 {
-	if (b->owning_name && b->pending_name) {
-		cpymo_backend_text_free(b->pending_name);
+	cpymo_name_cache_unref(b->pending_name);
 #ifdef ENABLE_TEXT_EXTRACT
-		if (b->pending_name_str) free(b->pending_name_str);
+	if (b->pending_name_str) free(b->pending_name_str);
 #endif
-	}
 
-	b->owning_name = name == NULL ? false : true;
 	b->pending_name = name;
 
 #ifdef ENABLE_TEXT_EXTRACT
@@ -128,14 +118,14 @@ error_t cpymo_backlog_record_write_text(
 
 	cpymo_backlog_record_clean(rec);
 
-	rec->name = b->pending_name;
-	rec->owning_name = b->owning_name;
+	// Following pages of the same say keep the name.
+	rec->name = cpymo_name_cache_ref(b->pending_name);
 
 #ifdef ENABLE_TEXT_EXTRACT
-	rec->name_str = b->pending_name_str;
+	rec->name_str = b->pending_name_str ? 
+		cpymo_str_copy_malloc(cpymo_str_pure(b->pending_name_str)) : NULL;
 #endif
 
-	b->owning_name = false;
 	rec->text = text;
 	strcpy(rec->vo_filename, b->pending_vo_filename);
 	b->pending_vo_filename[0] = '\0';
@@ -156,7 +146,7 @@ static void cpymo_backlog_ui_draw_node(const cpymo_engine *e, const void *node_t
 	y += font_size;
 	if (rec->name) {
 		cpymo_backend_text_draw(
-			rec->name, 0, y, cpymo_color_white,
+			rec->name->text, 0, y, cpymo_color_white,
 			1.0, cpymo_backend_image_draw_type_ui_element);
 
 		y += font_size;
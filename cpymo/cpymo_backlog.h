@@ -3,6 +3,7 @@
 
 #include "cpymo_parser.h"
 #include "cpymo_error.h"
+#include "cpymo_name_cache.h"
 #include <cpymo_backend_text.h>
 
 struct cpymo_backlog_record;
@@ -12,8 +13,7 @@ typedef struct {
 	size_t next_record_to_write;
 	char pending_vo_filename[32];
 
-	bool owning_name;
-	cpymo_backend_text pending_name;
+	cpymo_name_cache_entry *pending_name;
 
 #ifdef ENABLE_TEXT_EXTRACT
 	char *pending_name_str;
@@ -29,7 +29,7 @@ void cpymo_backlog_record_write_vo(
 
 void cpymo_backlog_record_write_name(
 	cpymo_backlog *,
-	cpymo_backend_text name_moveinto,
+	cpymo_name_cache_entry *name_moveinto,
 	cpymo_str name_str);
 
 error_t cpymo_backlog_record_write_text(
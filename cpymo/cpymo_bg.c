@@ -129,6 +129,47 @@ static void cpymo_bg_transfer_operate(cpymo_engine *e)
 	cpymo_engine_request_redraw(e);
 }
 
+static void cpymo_bg_place(
+	const cpymo_engine *e, float x, float y, int w, int h, 
+	float *out_x, float *out_y)
+{
+	// In pymo, when x = y = 0 and bg smaller than screen, bg will be centered.
+	if (fabs(x) < 1 && fabs(y) < 1 && (w <= e->gameconfig.imagesize_w || h <= e->gameconfig.imagesize_h)) {
+		*out_x = (float)(e->gameconfig.imagesize_w - w) / 2.0f;
+		*out_y = (float)(e->gameconfig.imagesize_h - h) / 2.0f;
+	} 
+	else {
+		*out_x = -(x / 100.0f) * (float)w;
+		*out_y = -(y / 100.0f) * (float)h;
+	}
+}
+
+void cpymo_bg_load_deferred(cpymo_engine *e)
+{
+	cpymo_bg *bg = &e->bg;
+	if (!bg->current_bg_deferred) return;
+	bg->current_bg_deferred = false;
+
+	int w, h;
+	cpymo_backend_image img;
+	error_t err = cpymo_assetloader_load_bg_image(
+		&img, &w, &h, cpymo_str_pure(bg->current_bg_name), &e->assetloader);
+	if (err != CPYMO_ERR_SUCC) {
+		printf("[Error] Can not load bg \"%s\": %s\n", 
+			bg->current_bg_name, cpymo_error_message(err));
+		return;
+	}
+
+	bg->current_bg = img;
+	bg->current_bg_w = w;
+	bg->current_bg_h = h;
+	cpymo_bg_place(
+		e, bg->deferred_x, bg->deferred_y, w, h, 
+		&bg->current_bg_x, &bg->current_bg_y);
+
+	cpymo_engine_request_redraw(e);
+}
+
 static void cpymo_bg_transfer(cpymo_engine *e)
 {
 	cpymo_engine_request_redraw(e);
@@ -188,6 +229,35 @@ error_t cpymo_bg_command(
 	float y,
 	float time)
 {
+	if (cpymo_engine_skipping(engine)) {
+		// Backgrounds passed by while skipping are usually replaced
+		// before they are ever presented, only remember what to load.
+		char *next_bg_name = (char *)realloc(bg->current_bg_name, bgname.len + 1);
+		if (next_bg_name == NULL) return CPYMO_ERR_OUT_OF_MEM;
+		cpymo_str_copy(next_bg_name, bgname.len + 1, bgname);
+		bg->current_bg_name = next_bg_name;
+
+		if (bg->current_bg) cpymo_backend_image_free(bg->current_bg);
+		if (bg->transform_next_bg) cpymo_backend_image_free(bg->transform_next_bg);
+		if (bg->trans) cpymo_backend_masktrans_free(bg->trans);
+		bg->current_bg = NULL;
+		bg->transform_next_bg = NULL;
+		bg->trans = NULL;
+		bg->transform_draw = NULL;
+
+		bg->current_bg_deferred = true;
+		bg->deferred_x = x;
+		bg->deferred_y = y;
+
+		cpymo_charas_fast_kill_all(&engine->charas);
+		cpymo_scroll_reset(&engine->scroll);
+		cpymo_engine_request_redraw(engine);
+		return CPYMO_ERR_SUCC;
+	}
+
+	// The new background fades in over the current one.
+	cpymo_bg_load_deferred(engine);
+
 	int w, h;
 	cpymo_backend_image img;
 	error_t err = cpymo_assetloader_load_bg_image(&img, &w, &h, bgname, &engine->assetloader);
@@ -206,15 +276,9 @@ error_t cpymo_bg_command(
 	bg->transform_next_bg_w = w;
 	bg->transform_next_bg_h = h;
 
-	// In pymo, when x = y = 0 and bg smaller than screen, bg will be centered.
-	if (fabs(x) < 1 && fabs(y) < 1 && (w <= engine->gameconfig.imagesize_w || h <= engine->gameconfig.imagesize_h)) {
-		bg->transform_next_bg_x = (float)(engine->gameconfig.imagesize_w - w) / 2.0f;
-		bg->transform_next_bg_y = (float)(engine->gameconfig.imagesize_h - h) / 2.0f;
-	} 
-	else {
-		bg->transform_next_bg_x = -(x / 100.0f) * (float)w;
-		bg->transform_next_bg_y = -(y / 100.0f) * (float)h;
-	}
+	cpymo_bg_place(
+		engine, x, y, w, h, 
+		&bg->transform_next_bg_x, &bg->transform_next_bg_y);
 
 #ifdef LOW_FRAME_RATE
 	transition = cpymo_str_pure("BG_NOFADE");
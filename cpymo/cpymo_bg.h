@@ -27,6 +27,11 @@ typedef struct {
 
 	// Current background name
 	char *current_bg_name;
+
+	// Set while skipping, current_bg_name is not decoded until
+	// cpymo_bg_load_deferred() is called.
+	bool current_bg_deferred;
+	float deferred_x, deferred_y;
 } cpymo_bg;
 
 static inline void cpymo_bg_init(cpymo_bg *bg)
@@ -39,6 +44,7 @@ static inline void cpymo_bg_init(cpymo_bg *bg)
 	bg->follow_chara_quake = false;
 	bg->trans = NULL;
 	bg->current_bg_name = NULL;
+	bg->current_bg_deferred = false;
 }
 
 void cpymo_bg_free(cpymo_bg *);
@@ -47,6 +53,7 @@ static inline void cpymo_bg_reset(cpymo_bg *bg)
 { cpymo_bg_free(bg); cpymo_bg_init(bg); }
 
 void cpymo_bg_draw(const struct cpymo_engine *);
+void cpymo_bg_load_deferred(struct cpymo_engine *);
 void cpymo_bg_draw_transform_effect(const struct cpymo_engine *);
 
 error_t cpymo_bg_command(
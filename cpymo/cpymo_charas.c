@@ -11,7 +11,7 @@ void cpymo_charas_free(cpymo_charas *c)
 		struct cpymo_chara *to_free = c->chara;
 		c->chara = c->chara->next;
 
-		cpymo_backend_image_free(to_free->img);
+		if (to_free->img) cpymo_backend_image_free(to_free->img);
 		free(to_free);
 	}
 
@@ -27,7 +27,7 @@ static void cpymo_charas_gc(cpymo_charas *p)
 		if (!pcur->alive && cpymo_tween_value(&pcur->alpha) <= 0.0001f) {
 			*ppcur = pnext;
 
-			cpymo_backend_image_free(pcur->img);
+			if (pcur->img) cpymo_backend_image_free(pcur->img);
 			free(pcur);
 		}
 		else {
@@ -38,15 +38,38 @@ static void cpymo_charas_gc(cpymo_charas *p)
 	}
 }
 
+static void cpymo_chara_request_redraw(cpymo_engine *e, const struct cpymo_chara *c)
+{
+	if (c->img == NULL) return;
+
+	if (c->play_anime) {
+		cpymo_engine_request_redraw(e);
+		return;
+	}
+
+	cpymo_engine_request_redraw_rect(
+		e, 
+		cpymo_tween_value(&c->pos_x), 
+		cpymo_tween_value(&c->pos_y), 
+		(float)c->img_w, 
+		(float)c->img_h);
+}
+
 static bool cpymo_charas_wait_all_tween(cpymo_engine *e, float delta_time)
 {
-	cpymo_engine_request_redraw(e);
 	bool waiting = false;
 
 	bool forward_key_pressed = cpymo_input_foward_key_just_pressed(e);
 
 	struct cpymo_chara * pcur = e->charas.chara;
 	while (pcur) {
+		// Repaint where the chara was and where it will be.
+		const bool changing = 
+			!cpymo_tween_finished(&pcur->pos_x)
+			|| !cpymo_tween_finished(&pcur->pos_y)
+			|| !cpymo_tween_finished(&pcur->alpha);
+
+		if (changing) cpymo_chara_request_redraw(e, pcur);
 
 		if (forward_key_pressed) {
 			cpymo_tween_finish(&pcur->pos_x);
@@ -63,6 +86,8 @@ static bool cpymo_charas_wait_all_tween(cpymo_engine *e, float delta_time)
 		cpymo_tween_update(&pcur->pos_y, delta_time);
 		cpymo_tween_update(&pcur->alpha, delta_time);
 
+		if (changing) cpymo_chara_request_redraw(e, pcur);
+
 		pcur = pcur->next;
 	}
 
@@ -81,6 +106,11 @@ void cpymo_charas_draw(const cpymo_engine *e)
 	const struct cpymo_chara *pcur = c->chara;
 
 	while (pcur) {
+		if (pcur->img == NULL) {
+			pcur = pcur->next;
+			continue;
+		}
+
 		float anime_offset_x = 0;
 		float anime_offset_y = 0;
 		if (pcur->play_anime) {
@@ -107,6 +137,50 @@ void cpymo_charas_draw(const cpymo_engine *e)
 	}
 }
 
+static error_t cpymo_chara_load_image(cpymo_engine *e, struct cpymo_chara *c)
+{
+	error_t err = cpymo_assetloader_load_chara_image(
+		&c->img, &c->img_w, &c->img_h, 
+		cpymo_str_pure(c->chara_name), &e->assetloader);
+	if (err != CPYMO_ERR_SUCC) {
+		c->img = NULL;
+		if (err == CPYMO_ERR_NOT_FOUND || err == CPYMO_ERR_CAN_NOT_OPEN_FILE)
+			printf("[Error] Can not load chara \"%s\".\n", c->chara_name);
+	}
+
+	return err;
+}
+
+static void cpymo_chara_load_deferred(cpymo_engine *e, struct cpymo_chara *c)
+{
+	if (!c->deferred) return;
+	c->deferred = false;
+
+	if (cpymo_chara_load_image(e, c) != CPYMO_ERR_SUCC) {
+		c->alive = false;
+		cpymo_tween_assign(&c->alpha, 0);
+		return;
+	}
+
+	float x = c->deferred_x, y = c->deferred_y;
+	cpymo_chara_convert_to_mode0_pos(e, c, c->deferred_coord_mode, &x, &y);
+	cpymo_tween_assign(&c->pos_x, x);
+	cpymo_tween_assign(&c->pos_y, y);
+
+	cpymo_engine_request_redraw(e);
+}
+
+void cpymo_charas_load_deferred(cpymo_engine *e)
+{
+	struct cpymo_chara *c = e->charas.chara;
+	while (c) {
+		if (c->alive) cpymo_chara_load_deferred(e, c);
+		c = c->next;
+	}
+
+	cpymo_charas_gc(&e->charas);
+}
+
 error_t cpymo_chara_convert_to_mode0_pos(
 	cpymo_engine *e,
 	struct cpymo_chara *c,
@@ -116,6 +190,8 @@ error_t cpymo_chara_convert_to_mode0_pos(
 	if (coord_mode < 0 || coord_mode > 6)
 		return CPYMO_ERR_INVALID_ARG;
 
+	cpymo_chara_load_deferred(e, c);
+
 	if (coord_mode == 0 || coord_mode == 4) {
 		// 立绘左沿距屏幕左沿的距离
 	}
@@ -156,6 +232,7 @@ error_t cpymo_charas_new_chara(
 	if (err == CPYMO_ERR_SUCC) {
 		ch->alive = false;
 		cpymo_tween_to(&ch->alpha, 0, time);
+		cpymo_chara_request_redraw(e, ch);
 	}
 
 	ch = (struct cpymo_chara *)malloc(
@@ -163,25 +240,40 @@ error_t cpymo_charas_new_chara(
 	if (ch == NULL) return CPYMO_ERR_OUT_OF_MEM;
 	cpymo_str_copy(ch->chara_name, filename.len + 1, filename);
 
-	err = cpymo_assetloader_load_chara_image(&ch->img, &ch->img_w, &ch->img_h, filename, &e->assetloader);
-	if (err != CPYMO_ERR_SUCC) {
-		free(ch);
-
-		if (err == CPYMO_ERR_NOT_FOUND || err == CPYMO_ERR_CAN_NOT_OPEN_FILE) {
-			char name[32];
-			cpymo_str_copy(name, sizeof(name), filename);
-			printf("[Error] Can not load chara \"%s\".\n", name);
-			return CPYMO_ERR_SUCC;
+	ch->img = NULL;
+	ch->img_w = 0;
+	ch->img_h = 0;
+	ch->deferred = cpymo_engine_skipping(e);
+
+	if (ch->deferred) {
+		// Most charas shown while skipping are gone before the next 
+		// frame is presented, so loading waits for cpymo_charas_load_deferred().
+		if (coord_mode < 0 || coord_mode > 6) {
+			free(ch);
+			return CPYMO_ERR_INVALID_ARG;
 		}
 
-		return err;
+		ch->deferred_coord_mode = coord_mode;
+		ch->deferred_x = x;
+		ch->deferred_y = y;
 	}
+	else {
+		err = cpymo_chara_load_image(e, ch);
+		if (err != CPYMO_ERR_SUCC) {
+			free(ch);
 
-	err = cpymo_chara_convert_to_mode0_pos(e, ch, coord_mode, &x, &y);
-	if (err != CPYMO_ERR_SUCC) {
-		cpymo_backend_image_free(ch->img);
-		free(ch);
-		return err;
+			if (err == CPYMO_ERR_NOT_FOUND || err == CPYMO_ERR_CAN_NOT_OPEN_FILE)
+				return CPYMO_ERR_SUCC;
+
+			return err;
+		}
+
+		err = cpymo_chara_convert_to_mode0_pos(e, ch, coord_mode, &x, &y);
+		if (err != CPYMO_ERR_SUCC) {
+			cpymo_backend_image_free(ch->img);
+			free(ch);
+			return err;
+		}
 	}
 
 	ch->play_anime = false;
@@ -230,6 +322,7 @@ error_t cpymo_charas_new_chara(
 	}
 	
 
+	cpymo_chara_request_redraw(e, ch);
 	*out = ch;
 
 	//print_charas(&e->charas);
@@ -262,6 +355,7 @@ error_t cpymo_charas_kill(cpymo_engine *e, int chara_id, float time)
 
 	ch->alive = false;
 	cpymo_tween_to(&ch->alpha, 0, time);
+	cpymo_chara_request_redraw(e, ch);
 
 	return CPYMO_ERR_SUCC;
 }
@@ -277,6 +371,7 @@ static void cpymo_charas_stop_all_tween(cpymo_engine *e)
 	}
 
 	cpymo_charas_gc(&e->charas);
+	cpymo_engine_request_redraw(e);
 }
 
 void cpymo_charas_wait(cpymo_engine *e)
@@ -294,6 +389,7 @@ void cpymo_charas_kill_all(cpymo_engine *e, float time)
 		if (ch->alive) {
 			ch->alive = false;
 			cpymo_tween_to(&ch->alpha, 0, time);
+			cpymo_chara_request_redraw(e, ch);
 		}
 
 		ch = ch->next;
@@ -312,6 +408,16 @@ error_t cpymo_charas_pos(cpymo_engine *e, int chara_id, int coord_mode, float x,
 	error_t err = cpymo_charas_find(&e->charas, &c, chara_id);
 	CPYMO_THROW(err);
 
+	if (c->deferred) {
+		if (coord_mode < 0 || coord_mode > 6)
+			return CPYMO_ERR_INVALID_ARG;
+
+		c->deferred_coord_mode = coord_mode;
+		c->deferred_x = x;
+		c->deferred_y = y;
+		return CPYMO_ERR_SUCC;
+	}
+
 	err = cpymo_chara_convert_to_mode0_pos(e, c, coord_mode, &x, &y);
 	CPYMO_THROW(err);
 
@@ -336,6 +442,7 @@ static void cpymo_charas_stop_all_anime(cpymo_engine *e)
 	float last_pos_y = c->anime_pos[(c->anime_pos_count - 1) * 2 + 1] * (float)e->gameconfig.imagesize_h / 360.0f;
 
 	while (ch) {
+		if (ch->alive) cpymo_chara_load_deferred(e, ch);
 		ch->play_anime = false;
 		cpymo_tween_assign(&ch->pos_x, last_pos_x + cpymo_tween_value(&ch->pos_x));
 		cpymo_tween_assign(&ch->pos_y, last_pos_y + cpymo_tween_value(&ch->pos_y));
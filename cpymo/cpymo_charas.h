@@ -17,6 +17,12 @@ struct cpymo_chara {
 
 	bool play_anime;
 
+	// Created while skipping, img is not loaded and the position
+	// is still in deferred_coord_mode.
+	bool deferred;
+	int deferred_coord_mode;
+	float deferred_x, deferred_y;
+
 	struct cpymo_chara *next;
 
 	char chara_name[];
@@ -44,6 +50,7 @@ static inline void cpymo_charas_init(cpymo_charas *cpymo_charas)
 void cpymo_charas_free(cpymo_charas *);
 
 void cpymo_charas_draw(const struct cpymo_engine *);
+void cpymo_charas_load_deferred(struct cpymo_engine *);
 
 error_t cpymo_charas_new_chara(
 	struct cpymo_engine *, struct cpymo_chara **out,
@@ -1,6 +1,9 @@
 ﻿#include "cpymo_prelude.h"
 #include "cpymo_engine.h"
 #include "cpymo_interpreter.h"
+#include "cpymo_prefetch.h"
+#include "cpymo_image_cache.h"
+#include "cpymo_profiler.h"
 #include <cpymo_backend_image.h>
 #include <string.h>
 #include <stdio.h>
@@ -56,8 +59,68 @@ static error_t cpymo_engine_version_warning(cpymo_engine *e)
 	return err;
 }
 
+// Desktop builds can tune the asset loader with environment variables.
+static bool cpymo_engine_getenv_size(const char *name, size_t *out)
+{
+	const char *value = getenv(name);
+	if (value == NULL || *value < '0' || *value > '9') return false;
+
+	*out = (size_t)strtoull(value, NULL, 10);
+	return true;
+}
+
+#ifdef ENABLE_PROFILER
+static void cpymo_engine_record_counters(const cpymo_engine *e)
+{
+	#ifdef ENABLE_ASSET_PREFETCH
+	if (e->assetloader.prefetch) {
+		cpymo_prefetch_stats s = cpymo_prefetch_get_stats(e->assetloader.prefetch);
+		cpymo_profiler_counter("prefetch", "hits", s.hits);
+		cpymo_profiler_counter("prefetch", "misses", s.misses);
+		cpymo_profiler_counter("prefetch", "requested", s.requested);
+		cpymo_profiler_counter("prefetch", "dropped", s.dropped);
+		cpymo_profiler_counter("prefetch", "evicted", s.evicted);
+	}
+	#endif
+
+	#ifdef ENABLE_IMAGE_CACHE
+	if (e->assetloader.image_cache) {
+		cpymo_image_cache_stats s = cpymo_image_cache_get_stats(e->assetloader.image_cache);
+		cpymo_profiler_counter("image_cache", "hits", s.hits);
+		cpymo_profiler_counter("image_cache", "misses", s.misses);
+		cpymo_profiler_counter("image_cache", "evictions", s.evictions);
+		cpymo_profiler_counter("image_cache", "used", s.used);
+	}
+	#endif
+
+	#ifdef ENABLE_SCRIPT_CACHE
+	if (e->assetloader.script_cache) {
+		cpymo_script_cache_stats s = cpymo_script_cache_get_stats(e->assetloader.script_cache);
+		cpymo_profiler_counter("script_cache", "hits", s.hits);
+		cpymo_profiler_counter("script_cache", "misses", s.misses);
+		cpymo_profiler_counter("script_cache", "evictions", s.evictions);
+		cpymo_profiler_counter("script_cache", "idle_bytes", s.idle_bytes);
+	}
+	#endif
+
+	{
+		static const char *const channels[CPYMO_AUDIO_MAX_CHANNELS] = { "bgm", "se", "vo" };
+		cpymo_audio_stats s;
+		cpymo_audio_get_stats(&s, &e->audio);
+		for (size_t i = 0; i < CPYMO_AUDIO_MAX_CHANNELS; ++i) {
+			cpymo_profiler_counter("audio_underruns", channels[i], s.underruns[i]);
+			cpymo_profiler_counter("audio_buffered", channels[i], s.buffered[i]);
+		}
+	}
+}
+#endif
+
 error_t cpymo_engine_init(cpymo_engine *out, const char *gamedir)
 {
+	#ifdef ENABLE_PROFILER
+	cpymo_profiler_init();
+	#endif
+
 	// init audio system
 	cpymo_audio_init(&out->audio);
 
@@ -85,6 +148,21 @@ error_t cpymo_engine_init(cpymo_engine *out, const char *gamedir)
 	err = cpymo_assetloader_init(&out->assetloader, &out->gameconfig, gamedir);
 	if (err != CPYMO_ERR_SUCC) return err;
 
+	{
+		size_t budget;
+		if (cpymo_engine_getenv_size("CPYMO_IMAGE_CACHE_BUDGET", &budget))
+			cpymo_assetloader_set_image_cache_budget(&out->assetloader, budget);
+	}
+
+	#ifdef ENABLE_ASSET_PREFETCH
+	{
+		size_t lines;
+		if (out->assetloader.prefetch 
+			&& cpymo_engine_getenv_size("CPYMO_PREFETCH_LOOKAHEAD", &lines))
+			cpymo_prefetch_set_lookahead(out->assetloader.prefetch, lines);
+	}
+	#endif
+
 	// create vars
 	cpymo_vars_init(&out->vars);
 
@@ -144,6 +222,9 @@ error_t cpymo_engine_init(cpymo_engine *out, const char *gamedir)
 	// init floating hint
 	cpymo_floating_hint_init(&out->floating_hint);
 
+	// init name cache
+	cpymo_name_cache_init(&out->name_cache);
+
 	// init say
 	cpymo_say_init(&out->say);
 
@@ -170,6 +251,9 @@ error_t cpymo_engine_init(cpymo_engine *out, const char *gamedir)
 	// states
 	out->skipping = false;
 	out->redraw = true;
+	out->redraw_all = true;
+	out->redraw_x1 = out->redraw_x2 = 0;
+	out->redraw_y1 = out->redraw_y2 = 0;
 	out->ignore_next_mouse_button_flag = false;
 
 	// default config
@@ -211,6 +295,10 @@ error_t cpymo_engine_init(cpymo_engine *out, const char *gamedir)
 
 void cpymo_engine_free(cpymo_engine *engine)
 {
+	#ifdef ENABLE_PROFILER
+	cpymo_profiler_dump(CPYMO_PROFILER_TRACE_FILE);
+	#endif
+
 	while (engine->ui) cpymo_ui_exit(engine);
 
 	if (engine->assetloader.gamedir) {
@@ -227,6 +315,7 @@ void cpymo_engine_free(cpymo_engine *engine)
 	cpymo_text_free(&engine->text);
 	cpymo_say_free(&engine->say);
 	cpymo_backlog_free(&engine->backlog);
+	cpymo_name_cache_free(&engine->name_cache);
 	cpymo_floating_hint_free(&engine->floating_hint);
 	cpymo_scroll_free(&engine->scroll);
 	cpymo_charas_free(&engine->charas);
@@ -258,6 +347,58 @@ bool cpymo_engine_skipping(cpymo_engine *e)
 void cpymo_engine_request_redraw(cpymo_engine *engine)
 {
 	engine->redraw = true;
+	engine->redraw_all = true;
+}
+
+void cpymo_engine_request_redraw_rect(
+	cpymo_engine *e, float x, float y, float w, float h)
+{
+	e->redraw = true;
+	if (e->redraw_all || w <= 0 || h <= 0) return;
+
+	if (e->redraw_x2 <= e->redraw_x1) {
+		e->redraw_x1 = x;
+		e->redraw_y1 = y;
+		e->redraw_x2 = x + w;
+		e->redraw_y2 = y + h;
+	}
+	else {
+		if (x < e->redraw_x1) e->redraw_x1 = x;
+		if (y < e->redraw_y1) e->redraw_y1 = y;
+		if (x + w > e->redraw_x2) e->redraw_x2 = x + w;
+		if (y + h > e->redraw_y2) e->redraw_y2 = y + h;
+	}
+}
+
+bool cpymo_engine_take_redraw_rect(
+	cpymo_engine *e, float *x, float *y, float *w, float *h)
+{
+	bool changed = true;
+	if (e->redraw_all) {
+		*x = 0;
+		*y = 0;
+		*w = (float)e->gameconfig.imagesize_w;
+		*h = (float)e->gameconfig.imagesize_h;
+	}
+	else if (e->redraw_x2 > e->redraw_x1) {
+		*x = e->redraw_x1;
+		*y = e->redraw_y1;
+		*w = e->redraw_x2 - e->redraw_x1;
+		*h = e->redraw_y2 - e->redraw_y1;
+	}
+	else changed = false;
+
+	e->redraw_all = false;
+	e->redraw_x1 = e->redraw_x2 = 0;
+	e->redraw_y1 = e->redraw_y2 = 0;
+	return changed;
+}
+
+void cpymo_engine_load_deferred_assets(cpymo_engine *e)
+{
+	cpymo_bg_load_deferred(e);
+	cpymo_charas_load_deferred(e);
+	cpymo_anime_load_deferred(e, &e->anime);
 }
 
 static error_t cpymo_engine_exit_update(
@@ -281,6 +422,11 @@ error_t cpymo_engine_update(cpymo_engine *engine, float delta_time_sec, bool * r
 	error_t err = CPYMO_ERR_SUCC;
 	REDRAW;
 
+	#ifdef ENABLE_PROFILER
+	if (cpymo_profiler_next_frame() % CPYMO_PROFILER_COUNTER_FRAMES == 0)
+		cpymo_engine_record_counters(engine);
+	#endif
+
 	engine->prev_input = engine->input;
 	engine->input = cpymo_input_snapshot();
 
@@ -306,30 +452,30 @@ error_t cpymo_engine_update(cpymo_engine *engine, float delta_time_sec, bool * r
 		cpymo_engine_request_redraw(engine);
 
 	if (cpymo_ui_enabled(engine))
-		err = cpymo_ui_update(engine, delta_time_sec);
+		CPYMO_PROFILE("ui_update", err = cpymo_ui_update(engine, delta_time_sec));
 	else {
 
-		cpymo_anime_update(
+		CPYMO_PROFILE("anime_update", cpymo_anime_update(
 			engine, 
 			&engine->anime, 
-			delta_time_sec);
+			delta_time_sec));
 
-		err = cpymo_select_img_update(
+		CPYMO_PROFILE("select_img_update", err = cpymo_select_img_update(
 			engine, 
 			&engine->select_img, 
-			delta_time_sec);
+			delta_time_sec));
 		CPYMO_THROW(err);
 
-		err = cpymo_wait_update(
+		CPYMO_PROFILE("wait_update", err = cpymo_wait_update(
 			&engine->wait, 
 			engine, 
-			delta_time_sec);
+			delta_time_sec));
 		CPYMO_THROW(err);
 
 		if (!cpymo_wait_is_wating(&engine->wait)) {
 			if (engine->interpreter)
-				err = cpymo_interpreter_execute_step(
-					engine->interpreter, engine);
+				CPYMO_PROFILE("interpreter", err = cpymo_interpreter_execute_step(
+					engine->interpreter, engine));
 			else return CPYMO_ERR_NO_MORE_CONTENT;
 
 			if (cpymo_wait_is_wating(&engine->wait)) {
@@ -338,9 +484,15 @@ error_t cpymo_engine_update(cpymo_engine *engine, float delta_time_sec, bool * r
 			}
 
 			CPYMO_THROW(err);
+
+			CPYMO_PROFILE("prefetch_scan", 
+				cpymo_prefetch_scan(engine->assetloader.prefetch, engine->interpreter));
 		}
 	}
 
+	// Everything requested during this step is about to be presented.
+	CPYMO_PROFILE("load_deferred_assets", cpymo_engine_load_deferred_assets(engine));
+
 	REDRAW;
 
 	return err;
@@ -351,26 +503,26 @@ error_t cpymo_engine_update(cpymo_engine *engine, float delta_time_sec, bool * r
 void cpymo_engine_draw(const cpymo_engine *engine)
 {
 	if (cpymo_ui_enabled(engine)) {
-		cpymo_ui_draw(engine);
+		CPYMO_PROFILE("ui_draw", cpymo_ui_draw(engine));
 		return;
 	}
 
-	cpymo_bg_draw(engine);
-	cpymo_scroll_draw(&engine->scroll);
-	cpymo_charas_draw(engine);
-	cpymo_anime_draw(&engine->anime);
-	cpymo_select_img_draw(
+	CPYMO_PROFILE("bg_draw", cpymo_bg_draw(engine));
+	CPYMO_PROFILE("scroll_draw", cpymo_scroll_draw(&engine->scroll));
+	CPYMO_PROFILE("charas_draw", cpymo_charas_draw(engine));
+	CPYMO_PROFILE("anime_draw", cpymo_anime_draw(&engine->anime));
+	CPYMO_PROFILE("select_img_draw", cpymo_select_img_draw(
 		&engine->select_img, 
 		engine->gameconfig.imagesize_w, 
 		engine->gameconfig.imagesize_h,
-		engine->gameconfig.grayselected);
+		engine->gameconfig.grayselected));
 
-	cpymo_floating_hint_draw(&engine->floating_hint);
-	cpymo_flash_draw(engine);
-	cpymo_fade_draw(engine);
-	cpymo_bg_draw_transform_effect(engine);
+	CPYMO_PROFILE("floating_hint_draw", cpymo_floating_hint_draw(&engine->floating_hint));
+	CPYMO_PROFILE("flash_draw", cpymo_flash_draw(engine));
+	CPYMO_PROFILE("fade_draw", cpymo_fade_draw(engine));
+	CPYMO_PROFILE("bg_transform_draw", cpymo_bg_draw_transform_effect(engine));
 
-	cpymo_text_draw(engine);
-	cpymo_say_draw(engine);
+	CPYMO_PROFILE("text_draw", cpymo_text_draw(engine));
+	CPYMO_PROFILE("say_draw", cpymo_say_draw(engine));
 }
 
@@ -22,6 +22,7 @@
 #include "cpymo_ui.h"
 #include "cpymo_audio.h"
 #include "cpymo_backlog.h"
+#include "cpymo_name_cache.h"
 
 struct cpymo_engine {
 	cpymo_gameconfig gameconfig;
@@ -44,11 +45,18 @@ struct cpymo_engine {
 	struct cpymo_ui *ui;
 	cpymo_audio_system audio;
 	cpymo_backlog backlog;
+	cpymo_name_cache name_cache;
 
 	bool skipping;
 	char *title;
 
 	bool redraw;
+
+	// Area changed since the last cpymo_engine_take_redraw_rect(), 
+	// in game coordinates, empty when redraw_x2 <= redraw_x1.
+	bool redraw_all;
+	float redraw_x1, redraw_y1, redraw_x2, redraw_y2;
+
 	bool ignore_next_mouse_button_flag;
 
 	bool config_skip_already_read_only;
@@ -64,6 +72,18 @@ void cpymo_engine_draw(const cpymo_engine *engine);
 bool cpymo_engine_skipping(cpymo_engine *engine);
 
 void cpymo_engine_request_redraw(cpymo_engine *engine);
+void cpymo_engine_request_redraw_rect(
+	cpymo_engine *engine, float x, float y, float w, float h);
+
+// For backends which keep their render target between frames,
+// only the returned area has to be repainted by cpymo_engine_draw().
+// Returns false when nothing has changed.
+bool cpymo_engine_take_redraw_rect(
+	cpymo_engine *engine, float *x, float *y, float *w, float *h);
+
+// Load images that bg, charas and anime left behind while skipping.
+void cpymo_engine_load_deferred_assets(cpymo_engine *engine);
+
 void cpymo_engine_exit(cpymo_engine *e);
 
 #define CPYMO_INPUT_JUST_PRESSED(PENGINE, KEY) \
@@ -42,13 +42,30 @@ void cpymo_floating_hint_draw(const cpymo_floating_hint *h)
 	}
 }
 
+static void cpymo_floating_hint_request_redraw(cpymo_engine *e)
+{
+	const cpymo_floating_hint *h = &e->floating_hint;
+
+	if (h->background) {
+		cpymo_engine_request_redraw_rect(
+			e, 0, 0, (float)h->background_w, (float)h->background_h);
+	}
+
+	if (h->text) {
+		float pad = h->fontsize / 2;
+		cpymo_engine_request_redraw_rect(
+			e, h->x - pad, h->y - pad, 
+			h->text_width + 2 * pad, h->fontsize * 1.5f + 2 * pad);
+	}
+}
+
 static bool cpymo_floating_hint_wait(cpymo_engine *e, float dt)
 {
 	cpymo_floating_hint *h = &e->floating_hint;
 	h->time += dt;
 
 	if (h->time <= 1.0f || h->time >= 4.0f)
-		cpymo_engine_request_redraw(e);
+		cpymo_floating_hint_request_redraw(e);
 
 	if (cpymo_input_foward_key_just_pressed(e)) {
 		if (h->time <= 1.2f) h->time = 1.2f;
@@ -60,9 +77,9 @@ static bool cpymo_floating_hint_wait(cpymo_engine *e, float dt)
 
 static error_t cpymo_floating_hint_finish(cpymo_engine *e)
 {
+	cpymo_floating_hint_request_redraw(e);
 	cpymo_floating_hint_free(&e->floating_hint);
 	cpymo_floating_hint_init(&e->floating_hint);
-	cpymo_engine_request_redraw(e);
 	return CPYMO_ERR_SUCC;
 }
 
@@ -102,10 +119,9 @@ error_t cpymo_floating_hint_start(
 	}
 
 	if (text.len > 0) {
-		float dummy;
 		error_t err = cpymo_backend_text_create(
 			&hint->text,
-			&dummy,
+			&hint->text_width,
 			text,
 			hint->fontsize);
 
@@ -117,7 +133,7 @@ error_t cpymo_floating_hint_start(
 		}
 	}
 
-	cpymo_engine_request_redraw(engine);
+	cpymo_floating_hint_request_redraw(engine);
 
 	cpymo_wait_register_with_callback(
 		&engine->wait,
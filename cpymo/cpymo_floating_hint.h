@@ -14,7 +14,7 @@ typedef struct {
 
 	cpymo_color color;
 
-	float fontsize;
+	float fontsize, text_width;
 	float x, y;
 	float time;
 } cpymo_floating_hint;
@@ -29,6 +29,7 @@ static inline void cpymo_floating_hint_init(cpymo_floating_hint *h)
 	h->background_w = 0;
 	h->background_h = 0;
 	h->fontsize = 0;
+	h->text_width = 0;
 }
 
 void cpymo_floating_hint_free(cpymo_floating_hint *);
@@ -376,6 +376,9 @@ error_t cpymo_engine_init_with_game_selector(
 	e->assetloader.use_pkg_voice = false;
 	e->assetloader.game_config = &e->gameconfig;
 	e->assetloader.gamedir = NULL;
+	e->assetloader.prefetch = NULL;
+	e->assetloader.image_cache = NULL;
+	e->assetloader.script_cache = NULL;
 	
 	cpymo_vars_init(&e->vars);
 	e->interpreter = NULL;
@@ -395,8 +398,9 @@ error_t cpymo_engine_init_with_game_selector(
 	cpymo_hash_flags_init(&e->flags);
 	e->ui = NULL;
 	cpymo_backlog_init(&e->backlog);
+	cpymo_name_cache_init(&e->name_cache);
 	e->skipping = false;
-	e->redraw = true;
+	cpymo_engine_request_redraw(e);
 
 	e->input = e->prev_input = cpymo_input_snapshot();
 
@@ -0,0 +1,235 @@
+﻿#include "cpymo_prelude.h"
+#include "cpymo_image_cache.h"
+
+#ifdef ENABLE_IMAGE_CACHE
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stb_ds.h>
+
+typedef struct cpymo_image_cache_entry {
+	struct cpymo_image_cache_entry *prev, *next;
+	char *key;
+
+	void *pixels, *mask;
+	int w, h, channels, mw, mh;
+	size_t bytes;
+} cpymo_image_cache_entry;
+
+struct cpymo_image_cache_slot {
+	char *key;
+	cpymo_image_cache_entry *value;
+};
+
+struct cpymo_image_cache {
+	struct cpymo_image_cache_slot *table;
+
+	// head is the most recently used entry.
+	cpymo_image_cache_entry *head, *tail;
+
+	cpymo_image_cache_stats stats;
+};
+
+static bool cpymo_image_cache_key(
+	char *buf, size_t size, const char *asset_type, cpymo_str name, bool with_mask)
+{
+	int len = snprintf(buf, size, "%s/%.*s%s", 
+		asset_type, (int)name.len, name.begin, with_mask ? "#mask" : "");
+	return len > 0 && (size_t)len < size;
+}
+
+static void cpymo_image_cache_unlink(struct cpymo_image_cache *c, cpymo_image_cache_entry *e)
+{
+	if (e->prev) e->prev->next = e->next;
+	else c->head = e->next;
+
+	if (e->next) e->next->prev = e->prev;
+	else c->tail = e->prev;
+
+	e->prev = e->next = NULL;
+}
+
+static void cpymo_image_cache_push_front(struct cpymo_image_cache *c, cpymo_image_cache_entry *e)
+{
+	e->prev = NULL;
+	e->next = c->head;
+	if (c->head) c->head->prev = e;
+	c->head = e;
+	if (c->tail == NULL) c->tail = e;
+}
+
+static void cpymo_image_cache_remove(struct cpymo_image_cache *c, cpymo_image_cache_entry *e)
+{
+	cpymo_image_cache_unlink(c, e);
+	shdel(c->table, e->key);
+
+	c->stats.used -= e->bytes;
+	free(e->pixels);
+	if (e->mask) free(e->mask);
+	free(e->key);
+	free(e);
+}
+
+static void cpymo_image_cache_shrink(struct cpymo_image_cache *c, size_t budget)
+{
+	while (c->tail && c->stats.used > budget) {
+		cpymo_image_cache_remove(c, c->tail);
+		c->stats.evictions++;
+	}
+}
+
+error_t cpymo_image_cache_create(struct cpymo_image_cache **out, size_t budget)
+{
+	struct cpymo_image_cache *c = 
+		(struct cpymo_image_cache *)malloc(sizeof(struct cpymo_image_cache));
+	if (c == NULL) return CPYMO_ERR_OUT_OF_MEM;
+
+	memset(c, 0, sizeof(*c));
+	c->stats.budget = budget;
+
+	*out = c;
+	return CPYMO_ERR_SUCC;
+}
+
+void cpymo_image_cache_free(struct cpymo_image_cache *c)
+{
+	if (c == NULL) return;
+
+#ifndef NDEBUG
+	printf("[Info] Image cache: %u hits, %u misses, %u evictions, %u KiB used.\n",
+		c->stats.hits, c->stats.misses, c->stats.evictions, (unsigned)(c->stats.used / 1024));
+#endif
+
+	cpymo_image_cache_shrink(c, 0);
+	shfree(c->table);
+	free(c);
+}
+
+void cpymo_image_cache_set_budget(struct cpymo_image_cache *c, size_t budget)
+{
+	c->stats.budget = budget;
+	cpymo_image_cache_shrink(c, budget);
+}
+
+cpymo_image_cache_stats cpymo_image_cache_get_stats(const struct cpymo_image_cache *c)
+{
+	return c->stats;
+}
+
+static cpymo_image_cache_entry *cpymo_image_cache_find(
+	struct cpymo_image_cache *c, 
+	const char *asset_type, cpymo_str name, bool with_mask)
+{
+	char key[128];
+	if (c == NULL || c->table == NULL) return NULL;
+	if (!cpymo_image_cache_key(key, sizeof(key), asset_type, name, with_mask)) return NULL;
+
+	struct cpymo_image_cache_slot *slot = shgetp_null(c->table, key);
+	return slot ? slot->value : NULL;
+}
+
+bool cpymo_image_cache_contains(
+	struct cpymo_image_cache *c, 
+	const char *asset_type, cpymo_str name, bool with_mask)
+{
+	return cpymo_image_cache_find(c, asset_type, name, with_mask) != NULL;
+}
+
+bool cpymo_image_cache_get(
+	struct cpymo_image_cache *c,
+	const char *asset_type, cpymo_str name, bool with_mask,
+	void **pixels, int *w, int *h,
+	void **mask, int *mw, int *mh)
+{
+	if (c == NULL) return false;
+
+	cpymo_image_cache_entry *e = cpymo_image_cache_find(c, asset_type, name, with_mask);
+	if (e == NULL) {
+		c->stats.misses++;
+		return false;
+	}
+
+	const size_t size = (size_t)e->w * (size_t)e->h * (size_t)e->channels;
+	void *px = malloc(size);
+	if (px == NULL) return false;
+	memcpy(px, e->pixels, size);
+
+	void *m = NULL;
+	if (mask && e->mask) {
+		m = malloc((size_t)e->mw * (size_t)e->mh);
+		if (m == NULL) {
+			free(px);
+			return false;
+		}
+
+		memcpy(m, e->mask, (size_t)e->mw * (size_t)e->mh);
+		*mw = e->mw;
+		*mh = e->mh;
+	}
+
+	*pixels = px;
+	*w = e->w;
+	*h = e->h;
+	if (mask) *mask = m;
+
+	cpymo_image_cache_unlink(c, e);
+	cpymo_image_cache_push_front(c, e);
+	c->stats.hits++;
+	return true;
+}
+
+void cpymo_image_cache_put(
+	struct cpymo_image_cache *c,
+	const char *asset_type, cpymo_str name, bool with_mask,
+	const void *pixels, int w, int h, int channels,
+	const void *mask, int mw, int mh)
+{
+	if (c == NULL) return;
+
+	char key[128];
+	if (!cpymo_image_cache_key(key, sizeof(key), asset_type, name, with_mask)) return;
+
+	const size_t px_size = (size_t)w * (size_t)h * (size_t)channels;
+	const size_t mask_size = mask ? (size_t)mw * (size_t)mh : 0;
+	const size_t bytes = px_size + mask_size;
+	if (bytes > c->stats.budget) return;
+
+	cpymo_image_cache_entry *old = cpymo_image_cache_find(c, asset_type, name, with_mask);
+	if (old) cpymo_image_cache_remove(c, old);
+
+	cpymo_image_cache_shrink(c, c->stats.budget - bytes);
+
+	cpymo_image_cache_entry *e = 
+		(cpymo_image_cache_entry *)malloc(sizeof(cpymo_image_cache_entry));
+	if (e == NULL) return;
+
+	memset(e, 0, sizeof(*e));
+	e->key = (char *)malloc(strlen(key) + 1);
+	e->pixels = malloc(px_size);
+	if (mask_size) e->mask = malloc(mask_size);
+
+	if (e->key == NULL || e->pixels == NULL || (mask_size && e->mask == NULL)) {
+		if (e->key) free(e->key);
+		if (e->pixels) free(e->pixels);
+		if (e->mask) free(e->mask);
+		free(e);
+		return;
+	}
+
+	strcpy(e->key, key);
+	memcpy(e->pixels, pixels, px_size);
+	if (mask_size) memcpy(e->mask, mask, mask_size);
+	e->w = w;
+	e->h = h;
+	e->channels = channels;
+	e->mw = mw;
+	e->mh = mh;
+	e->bytes = bytes;
+
+	shput(c->table, e->key, e);
+	cpymo_image_cache_push_front(c, e);
+	c->stats.used += bytes;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef INCLUDE_CPYMO_IMAGE_CACHE
+#define INCLUDE_CPYMO_IMAGE_CACHE
+
+#include "cpymo_error.h"
+#include "cpymo_str.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+// Decoded pixel cache for images loaded by cpymo_assetloader.
+// Backends take the ownership of pixels they load, upload them and free them
+// or keep them as their image, so a hit hands out a copy instead of decoding
+// the file again. The cache saves decoding and reading packages, not memory
+// bandwidth, sharing pixels would need every backend to borrow them instead.
+// Least recently used images are evicted when the byte budget is exceeded.
+// Only used from the main thread.
+
+#if !defined CPYMO_TOOL && !defined DISABLE_STB_IMAGE && !defined DISABLE_IMAGE_CACHE
+#define ENABLE_IMAGE_CACHE
+#endif
+
+// Default byte budget, 0 to create no cache.
+// The engine can change it with cpymo_assetloader_set_image_cache_budget().
+#ifndef CPYMO_IMAGE_CACHE_BUDGET
+#if defined __3DS__ || defined __PSP__ || defined __WII__
+#define CPYMO_IMAGE_CACHE_BUDGET 0
+#elif defined __PSV__ || defined __SWITCH__ || defined __WIIU__ \
+	|| defined __ANDROID__ || defined __IOS__ || defined __EMSCRIPTEN__
+#define CPYMO_IMAGE_CACHE_BUDGET (8 * 1024 * 1024)
+#else
+#define CPYMO_IMAGE_CACHE_BUDGET (16 * 1024 * 1024)
+#endif
+#endif
+
+typedef struct {
+	size_t budget, used;
+	unsigned hits, misses, evictions;
+} cpymo_image_cache_stats;
+
+struct cpymo_image_cache;
+
+#ifdef ENABLE_IMAGE_CACHE
+
+error_t cpymo_image_cache_create(struct cpymo_image_cache **out, size_t budget);
+void cpymo_image_cache_free(struct cpymo_image_cache *c);
+
+void cpymo_image_cache_set_budget(struct cpymo_image_cache *c, size_t budget);
+cpymo_image_cache_stats cpymo_image_cache_get_stats(const struct cpymo_image_cache *c);
+
+bool cpymo_image_cache_contains(
+	struct cpymo_image_cache *c, 
+	const char *asset_type, cpymo_str name, bool with_mask);
+
+// Returns false on miss, otherwise pixels (and mask if requested) are fresh copies.
+bool cpymo_image_cache_get(
+	struct cpymo_image_cache *c,
+	const char *asset_type, cpymo_str name, bool with_mask,
+	void **pixels, int *w, int *h,
+	void **mask, int *mw, int *mh);
+
+// Stores copies of pixels and mask, mask can be NULL.
+void cpymo_image_cache_put(
+	struct cpymo_image_cache *c,
+	const char *asset_type, cpymo_str name, bool with_mask,
+	const void *pixels, int w, int h, int channels,
+	const void *mask, int mw, int mh);
+
+#else
+
+static inline void cpymo_image_cache_free(struct cpymo_image_cache *c) { (void)c; }
+
+static inline bool cpymo_image_cache_contains(
+	struct cpymo_image_cache *c, 
+	const char *asset_type, cpymo_str name, bool with_mask)
+{ (void)c; (void)asset_type; (void)name; (void)with_mask; return false; }
+
+static inline bool cpymo_image_cache_get(
+	struct cpymo_image_cache *c,
+	const char *asset_type, cpymo_str name, bool with_mask,
+	void **pixels, int *w, int *h,
+	void **mask, int *mw, int *mh)
+{
+	(void)c; (void)asset_type; (void)name; (void)with_mask;
+	(void)pixels; (void)w; (void)h; (void)mask; (void)mw; (void)mh;
+	return false;
+}
+
+static inline void cpymo_image_cache_put(
+	struct cpymo_image_cache *c,
+	const char *asset_type, cpymo_str name, bool with_mask,
+	const void *pixels, int w, int h, int channels,
+	const void *mask, int mw, int mh)
+{
+	(void)c; (void)asset_type; (void)name; (void)with_mask;
+	(void)pixels; (void)w; (void)h; (void)channels; (void)mask; (void)mw; (void)mh;
+}
+
+#endif
+
+#endif
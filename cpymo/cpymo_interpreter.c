@@ -30,6 +30,8 @@ void cpymo_interpreter_init(
 	out->no_more_content = false;
 	out->caller = caller;
 	out->checkpoint.cur_line = 0;
+	out->arg = out->arg_end = NULL;
+	out->skipped_in_step = 0;
 }
 
 error_t cpymo_interpreter_init_script(
@@ -38,35 +40,23 @@ error_t cpymo_interpreter_init_script(
 	const cpymo_assetloader *loader,
 	cpymo_interpreter *caller)
 {	
-	out->script = NULL;
-	out->own_script = true;
-
-	cpymo_interpreter *find_script = caller;
-	while (find_script) {
-		if (cpymo_str_equals_str(script_name, find_script->script->script_name)) {
-			out->script = find_script->script;
-			out->own_script = false;
-			break;
-		}
-		find_script = find_script->caller;
-	}
-
-	if (out->script == NULL) {
-		error_t err = cpymo_script_load(&out->script, script_name, loader);
-		CPYMO_THROW(err);
-	}
+	cpymo_script *script = NULL;
+	error_t err = cpymo_script_acquire(&script, script_name, loader);
+	CPYMO_THROW(err);
 
-	cpymo_interpreter_init(out, out->script, out->own_script, caller);
+	cpymo_interpreter_init(out, script, true, caller);
 
 	return CPYMO_ERR_SUCC;
 }
 
 error_t cpymo_interpreter_goto_line(cpymo_interpreter * interpreter, uint64_t line)
 {
-	cpymo_parser_reset(&interpreter->script_parser);
-	while (line != interpreter->script_parser.cur_line)
-		if (!cpymo_parser_next_line(&interpreter->script_parser))
-			return CPYMO_ERR_NO_MORE_CONTENT;
+	const cpymo_script_instr *ins = cpymo_script_instr_at(interpreter->script, (size_t)line);
+	if (ins == NULL) return CPYMO_ERR_NO_MORE_CONTENT;
+
+	interpreter->script_parser.cur_pos = ins->begin;
+	interpreter->script_parser.cur_line = (size_t)line;
+	interpreter->script_parser.is_line_end = false;
 	return CPYMO_ERR_SUCC;
 }
 
@@ -78,53 +68,34 @@ void cpymo_interpreter_free(cpymo_interpreter * interpreter)
 		caller = caller->caller;
 
 		if (to_free->own_script)
-			cpymo_script_free(to_free->script);
+			cpymo_script_release(to_free->script);
 		free(to_free);
 	}
 
 	if (interpreter->own_script)
-		cpymo_script_free(interpreter->script);
+		cpymo_script_release(interpreter->script);
 }
 
 error_t cpymo_interpreter_goto_label(cpymo_interpreter * interpreter, cpymo_str label)
 {
-	bool retring = false;
-	uint64_t cur_line_num = interpreter->script_parser.cur_line;
+	cpymo_parser *parser = &interpreter->script_parser;
 
-RETRY:
-	while (1) {
-		cpymo_str command = 
-			cpymo_parser_curline_pop_command(&interpreter->script_parser);
+	// Missing labels have been reported while loading script,
+	// just continue with the next line.
+	size_t line;
+	if (!cpymo_script_find_label(interpreter->script, label, parser->cur_line, &line))
+		return CPYMO_ERR_SUCC;
 
-		if (cpymo_str_equals_str(command, "label")) {
-			cpymo_str cur_label = 
-				cpymo_parser_curline_pop_commacell(&interpreter->script_parser);
+	error_t err = cpymo_interpreter_goto_line(interpreter, line);
+	CPYMO_THROW(err);
 
-			if (cpymo_str_equals(cur_label, label)) {
-				cpymo_parser_next_line(&interpreter->script_parser);
-				return CPYMO_ERR_SUCC;
-			}
-		}
-		else {
-			if (!cpymo_parser_next_line(&interpreter->script_parser)) {
-				if (retring) {
-					char label_name[32];
-					cpymo_str_copy(label_name, sizeof(label_name), label);
-					printf("[Error] Can not find label %s in script %s.\n", 
-						label_name, interpreter->script->script_name);
-					return cpymo_interpreter_goto_line(interpreter, cur_line_num);
-				}
-				else {
-					cpymo_parser_reset(&interpreter->script_parser);
-					retring = true;
-					goto RETRY;
-				}
-			}
-		}
-	}
+	cpymo_parser_next_line(parser);
+	return CPYMO_ERR_SUCC;
 }
 
-static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *interpreter, cpymo_engine *engine, jmp_buf cont);
+static error_t cpymo_interpreter_dispatch(
+	cpymo_script_op op, cpymo_str command, 
+	cpymo_interpreter *interpreter, cpymo_engine *engine, jmp_buf cont);
 
 #define CPYMO_EXEC_CONTVAL_OK 1
 #define CPYMO_EXEC_CONTVAL_INTERPRETER_UPDATED 2
@@ -134,16 +105,30 @@ error_t cpymo_interpreter_execute_step(cpymo_interpreter * interpreter, cpymo_en
 	jmp_buf cont;
 
 	switch (setjmp(cont)) {
-	case 0: break;
+	case 0: interpreter->skipped_in_step = 0; break;
 	case CPYMO_EXEC_CONTVAL_OK: break;
-	case CPYMO_EXEC_CONTVAL_INTERPRETER_UPDATED: interpreter = engine->interpreter; break;
+	case CPYMO_EXEC_CONTVAL_INTERPRETER_UPDATED:
+		interpreter = engine->interpreter;
+		interpreter->skipped_in_step = 0;
+		break;
 	default: return CPYMO_ERR_INVALID_ARG;
 	}
 
-	cpymo_str command =
-		cpymo_parser_curline_pop_command(&interpreter->script_parser);
+	// Only run the compiled line when the parser stands at its beginning,
+	// otherwise the line has already been executed.
+	cpymo_parser *parser = &interpreter->script_parser;
+	const cpymo_script_instr *ins = cpymo_script_instr_at(interpreter->script, parser->cur_line);
+	cpymo_script_op op = cpymo_op_none;
+	cpymo_str command = { NULL, 0 };
+	if (ins && !parser->is_line_end && parser->cur_pos == ins->begin) {
+		op = (cpymo_script_op)ins->op;
+		command = ins->command;
+		interpreter->arg = interpreter->script->args + ins->first_arg;
+		interpreter->arg_end = interpreter->arg + ins->argc;
+		parser->cur_pos = ins->end;
+	}
 
-	error_t err = cpymo_interpreter_dispatch(command, interpreter, engine, cont);
+	error_t err = cpymo_interpreter_dispatch(op, command, interpreter, engine, cont);
 	switch (err) {
 	case CPYMO_ERR_NOT_FOUND:
 	case CPYMO_ERR_CAN_NOT_OPEN_FILE:
@@ -175,11 +160,10 @@ void cpymo_interpreter_checkpoint(cpymo_interpreter * interpreter)
 }
 
 #define D(CMD) \
-	else if (cpymo_str_equals_str(command, CMD))
+	else if (op == cpymo_op_##CMD)
 
 #define POP_ARG(X) \
-	cpymo_str X = cpymo_parser_curline_pop_commacell(&interpreter->script_parser); \
-	cpymo_str_trim(&X)
+	cpymo_str X = cpymo_interpreter_pop_arg(interpreter)
 
 #define IS_EMPTY(X) \
 	cpymo_str_equals_str(X, "")
@@ -198,16 +182,46 @@ void cpymo_interpreter_checkpoint(cpymo_interpreter * interpreter)
 		{ longjmp(cont, CPYMO_EXEC_CONTVAL_OK); return CPYMO_ERR_UNKNOWN; }	\
 	else return CPYMO_ERR_NO_MORE_CONTENT; }
 
-static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *interpreter, cpymo_engine *engine, jmp_buf cont)
+// While skipping, runs of image commands are executed in one step,
+// so only the images left at the end of the step will be loaded.
+// The step still ends after a bounded number of them, so input is polled
+// and frames are presented even if the script loops over image commands.
+#define CPYMO_INTERPRETER_SKIP_BATCH 64
+
+#define CONT_NEXTLINE_WHEN_SKIPPING { \
+	if (cpymo_engine_skipping(engine) && !cpymo_wait_is_wating(&engine->wait) && \
+		++interpreter->skipped_in_step < CPYMO_INTERPRETER_SKIP_BATCH) \
+		CONT_NEXTLINE; \
+	return CPYMO_ERR_SUCC; }
+
+static inline cpymo_str cpymo_interpreter_pop_arg(cpymo_interpreter *interpreter)
+{
+	if (interpreter->arg < interpreter->arg_end) return *interpreter->arg++;
+
+	cpymo_str empty = { "", 0 };
+	return empty;
+}
+
+#ifdef ENABLE_INTERPRETER_STATS
+uint64_t cpymo_interpreter_op_stats[cpymo_op_count];
+#endif
+
+static error_t cpymo_interpreter_dispatch(
+	cpymo_script_op op, cpymo_str command, 
+	cpymo_interpreter *interpreter, cpymo_engine *engine, jmp_buf cont)
 {
 	error_t err;
 
-	if (IS_EMPTY(command)) {
+#ifdef ENABLE_INTERPRETER_STATS
+	cpymo_interpreter_op_stats[op]++;
+#endif
+
+	if (op == cpymo_op_none) {
 		CONT_NEXTLINE;
 	}
 
 	/*** I. Text ***/
-	D("say") {
+	D(say) {
 		cpymo_fade_reset(&engine->fade);
 		cpymo_interpreter_checkpoint(interpreter);
 
@@ -240,7 +254,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return cpymo_say_start(engine, name_or_text, text);
 	}
 
-	D("text") {
+	D(text) {
 		POP_ARG(content); ENSURE(content);
 		POP_ARG(x1_str); ENSURE(x1_str);
 		POP_ARG(y1_str); ENSURE(y1_str);
@@ -268,19 +282,19 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return cpymo_text_new(engine, x1, y1, x2, y2, col, fontsize, content, show_immediately);
 	}
 
-	D("text_off") {
+	D(text_off) {
 		cpymo_engine_request_redraw(engine);
 		cpymo_text_clear(&engine->text);
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("waitkey") {
+	D(waitkey) {
 		cpymo_engine_request_redraw(engine);
 		cpymo_wait_for_seconds(&engine->wait, 5.0f);
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("title") {
+	D(title) {
 		POP_ARG(title);
 
 		char *buf = cpymo_str_copy_malloc(title);
@@ -292,7 +306,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_NEXTLINE;
 	}
 
-	D("title_dsp") {
+	D(title_dsp) {
 		if (strlen(engine->title) <= 0)
 			CONT_NEXTLINE;
 
@@ -313,7 +327,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 #define CHARA_BUF_SIZE 64
 
 	/*** II. Video ***/
-	D("chara") {
+	D(chara) {
 		int chara_ids[CHARA_BUF_SIZE];
 		int layers[CHARA_BUF_SIZE];
 		float pos_x_s[CHARA_BUF_SIZE];
@@ -376,10 +390,10 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 
 		cpymo_charas_wait(engine);
 
-		return CPYMO_ERR_SUCC;
+		CONT_NEXTLINE_WHEN_SKIPPING;
 	}
 
-	D("chara_cls") {
+	D(chara_cls) {
 		POP_ARG(id_str); ENSURE(id_str);
 		POP_ARG(time_str);
 
@@ -389,10 +403,10 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		else cpymo_charas_kill(engine, cpymo_str_atoi(id_str), time);
 
 		cpymo_charas_wait(engine);
-		return CPYMO_ERR_SUCC;
+		CONT_NEXTLINE_WHEN_SKIPPING;
 	}
 
-	D("chara_pos") {
+	D(chara_pos) {
 		POP_ARG(id_str); ENSURE(id_str);
 		POP_ARG(x_str); ENSURE(x_str);
 		POP_ARG(y_str); ENSURE(y_str);
@@ -404,10 +418,10 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		int coord_mode = IS_EMPTY(coord_mode_str) ? 5 : cpymo_str_atoi(coord_mode_str);
 
 		cpymo_charas_pos(engine, id, coord_mode, x, y);
-		return CPYMO_ERR_SUCC;
+		CONT_NEXTLINE_WHEN_SKIPPING;
 	}
 
-	D("bg") {
+	D(bg) {
 		POP_ARG(bg_name); ENSURE(bg_name);
 		POP_ARG(transition);
 		POP_ARG(time_str);
@@ -445,11 +459,12 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 			y,
 			time
 		);
+		CPYMO_THROW(err);
 
-		return err;
+		CONT_NEXTLINE_WHEN_SKIPPING;
 	}
 
-	D("flash") {
+	D(flash) {
 		POP_ARG(col_str); ENSURE(col_str);
 		POP_ARG(time_str); ENSURE(time_str);
 
@@ -461,7 +476,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("quake") {
+	D(quake) {
 		static float offsets[] = { -1, -2, 4, 3, 6, -4, 5, 3, 2, -1, 0, 0 };
 		cpymo_charas_play_anime(
 			engine, 0.06f, 1, offsets,
@@ -471,7 +486,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("fade_out") {
+	D(fade_out) {
 		POP_ARG(col_str); ENSURE(col_str);
 		POP_ARG(time_str); ENSURE(time_str);
 
@@ -482,14 +497,14 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("fade_in") {
+	D(fade_in) {
 		POP_ARG(time_str); ENSURE(time_str);
 		float time = cpymo_str_atoi(time_str) / 1000.0f;
 		cpymo_fade_start_fadein(engine, time);
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("movie") {
+	D(movie) {
 		POP_ARG(movie_name);
 
 		if (engine->gameconfig.playvideo) {
@@ -504,7 +519,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		}
 	}
 
-	D("textbox") {
+	D(textbox) {
 		POP_ARG(msg); ENSURE(msg);
 		POP_ARG(name); ENSURE(name);
 
@@ -535,12 +550,12 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 			return CPYMO_ERR_SUCC; \
 		}
 
-	CHARA_QUAKE("chara_quake", -10, 3, 10, 3, -6, 2, 5, 2, -4, 1, 3, 0, -1, 0, 0, 0)
-	CHARA_QUAKE("chara_down", 0, 7, 0, 16, 0, 12, 0, 16, 0, 7, 0, 0)
-	CHARA_QUAKE("chara_up", 0, -16, 0, 0, 0, -6, 0, 0)
+	CHARA_QUAKE(chara_quake, -10, 3, 10, 3, -6, 2, 5, 2, -4, 1, 3, 0, -1, 0, 0, 0)
+	CHARA_QUAKE(chara_down, 0, 7, 0, 16, 0, 12, 0, 16, 0, 7, 0, 0)
+	CHARA_QUAKE(chara_up, 0, -16, 0, 0, 0, -6, 0, 0)
 	#undef CHARA_QUAKE
 
-	D("chara_anime") {
+	D(chara_anime) {
 		POP_ARG(id_str); ENSURE(id_str);
 		POP_ARG(peroid_str); ENSURE(peroid_str);
 		POP_ARG(loop_str); ENSURE(loop_str);
@@ -588,7 +603,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		}
 	}
 
-	D("scroll") {
+	D(scroll) {
 		POP_ARG(filename); ENSURE(filename);
 		POP_ARG(sx_str); ENSURE(sx_str);
 		POP_ARG(sy_str); ENSURE(sy_str);
@@ -607,7 +622,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return cpymo_scroll_start(engine, filename, sx, sy, ex, ey, time);
 	}
 
-	D("chara_y") {
+	D(chara_y) {
 		int chara_ids[CHARA_BUF_SIZE];
 		int layers[CHARA_BUF_SIZE];
 		float pos_x_s[CHARA_BUF_SIZE];
@@ -677,10 +692,10 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 
 		cpymo_charas_wait(engine);
 
-		return CPYMO_ERR_SUCC;
+		CONT_NEXTLINE_WHEN_SKIPPING;
 	}
 
-	D("chara_scroll") {
+	D(chara_scroll) {
 		POP_ARG(coord_mode_str); ENSURE(coord_mode_str);
 		POP_ARG(chara_id_str); ENSURE(chara_id_str);
 		POP_ARG(filename_or_endx); ENSURE(filename_or_endx);
@@ -750,7 +765,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("anime_on") {
+	D(anime_on) {
 #ifdef LOW_FRAME_RATE
 		CONT_NEXTLINE;
 #endif
@@ -779,7 +794,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_NEXTLINE;
 	}
 	
-	D("anime_off") {
+	D(anime_off) {
 #ifdef LOW_FRAME_RATE
 		CONT_NEXTLINE;
 #endif
@@ -788,7 +803,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 	}
 
 	/*** III. Variables, Selection, Jump ***/
-	D("set") {
+	D(set) {
 		POP_ARG(name); ENSURE(name);
 		POP_ARG(value_str); ENSURE(value_str);
 
@@ -800,7 +815,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_NEXTLINE;
 	}
 
-	D("add") {
+	D(add) {
 		POP_ARG(name); ENSURE(name);
 		POP_ARG(value); ENSURE(value);
 
@@ -811,7 +826,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_NEXTLINE;
 	}
 
-	D("sub") {
+	D(sub) {
 		POP_ARG(name); ENSURE(name);
 		POP_ARG(value); ENSURE(value);
 
@@ -822,11 +837,11 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_NEXTLINE;
 	}
 
-	D("label") {
+	D(label) {
 		CONT_NEXTLINE;
 	}
 
-	D("goto") {
+	D(goto) {
 		POP_ARG(label);
 		ENSURE(label);
 		err = cpymo_interpreter_goto_label(interpreter, label);
@@ -835,7 +850,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_WITH_CURRENT_CONTEXT;
 	}
 
-	D("change") {
+	D(change) {
 		POP_ARG(script_name);
 		ENSURE(script_name);
 
@@ -847,7 +862,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		cpymo_interpreter_free(interpreter);
 		err = cpymo_interpreter_init_script(
 			interpreter, script_name, &engine->assetloader, caller);
-		if (own_script) cpymo_script_free(script);
+		if (own_script) cpymo_script_release(script);
 		if (err != CPYMO_ERR_SUCC) {
 			cpymo_interpreter_free(caller);
 			return err;
@@ -856,68 +871,51 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_WITH_CURRENT_CONTEXT;
 	}
 
-	D("if") {
+	D(if) {
 		POP_ARG(condition); ENSURE(condition);
 
-		cpymo_parser parser;
-		cpymo_parser_init(&parser, condition.begin, condition.len);
-
-		cpymo_str left;
-		left.begin = condition.begin;
-		left.len = 0;
-
-		while (left.len < condition.len) {
-			char ch = left.begin[left.len];
-			if (ch == '>' || ch == '<' || ch == '=' || ch == '!') 
-				break;
-			left.len++;
-		}
-
-		if (left.len >= condition.len) goto BAD_EXPRESSION;
+		const cpymo_script_instr *ins = 
+			cpymo_script_instr_at(interpreter->script, interpreter->script_parser.cur_line);
 
-		cpymo_str op;
-		op.begin = left.begin + left.len;
-		op.len = 1;
+		// Nested #if takes two arguments per level.
+		const size_t level = (size_t)(interpreter->arg - interpreter->script->args - ins->first_arg - 1) / 2;
+		cpymo_script_condition *cond = interpreter->script->conditions + ins->condition + level;
 
-		if (op.begin[0] == '!') {
-			op.len++;
-			if (op.len + left.len >= condition.len) goto BAD_EXPRESSION;
-			if (op.begin[1] != '=') goto BAD_EXPRESSION;
+		if (cond->op == cpymo_script_cond_bad) {
+			char *condition_str = cpymo_str_copy_malloc(condition);
+			if (condition_str == NULL) return CPYMO_ERR_OUT_OF_MEM;
+			printf( 
+				"[Error] Bad if expression \"%s\" in script %s(%u).\n", 
+				condition_str,
+				interpreter->script->script_name,
+				(unsigned)interpreter->script_parser.cur_line);
+			free(condition_str);
+			return CPYMO_ERR_INVALID_ARG;
 		}
 
-		if ((op.begin[0] == '>' || op.begin[0] == '<')) {
-			if (op.len + 1 + left.len < condition.len) {
-				if (op.begin[1] == '=')
-					op.len++;
+		if (cond->vars_generation != engine->vars.generation) {
+			if (!cond->left.is_constant) {
+				err = cpymo_vars_intern(&engine->vars, cond->left.name, &cond->left.var);
+				CPYMO_THROW(err);
 			}
-		}
 
-		if ((op.begin[0] == '<')) {
-			if (op.len + 1 + left.len < condition.len) {
-				if (op.begin[1] == '>')
-					op.len++;
+			if (!cond->right.is_constant) {
+				err = cpymo_vars_intern(&engine->vars, cond->right.name, &cond->right.var);
+				CPYMO_THROW(err);
 			}
-		}
-
-		cpymo_str right;
-		right.begin = op.begin + op.len;
-		right.len = condition.len - op.len - left.len;
-
-		cpymo_str_trim(&left);
-		cpymo_str_trim(&op);
-		cpymo_str_trim(&right);
-
-		if (IS_EMPTY(left) || IS_EMPTY(right) || IS_EMPTY(op)) 
-			goto BAD_EXPRESSION;
 
-		const int lv = cpymo_vars_eval(&engine->vars, left);
+			cond->vars_generation = engine->vars.generation;
+		}
 
-		int rv;
-		if (cpymo_vars_is_constant(right)) {
-			rv = cpymo_str_atoi(right);
+		int lv = cond->left.constant;
+		if (!cond->left.is_constant) {
+			const cpymo_val *var = cpymo_vars_access_id(&engine->vars, cond->left.var);
+			lv = var ? *var : 0;
 		}
-		else {
-			const cpymo_val *var = cpymo_vars_access(&engine->vars, right);
+
+		int rv = cond->right.constant;
+		if (!cond->right.is_constant) {
+			const cpymo_val *var = cpymo_vars_access_id(&engine->vars, cond->right.var);
 			if (var == NULL) { CONT_NEXTLINE; }
 			else {
 				rv = *var;
@@ -925,53 +923,27 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		}
 
 		bool run_sub_command;
-		if (cpymo_str_equals_str(op, "="))
-			run_sub_command = lv == rv;
-		else if (cpymo_str_equals_str(op, "!=") || cpymo_str_equals_str(op, "<>"))
-			run_sub_command = lv != rv;
-		else if (cpymo_str_equals_str(op, ">"))
-			run_sub_command = lv > rv;
-		else if (cpymo_str_equals_str(op, ">="))
-			run_sub_command = lv >= rv;
-		else if (cpymo_str_equals_str(op, "<"))
-			run_sub_command = lv < rv;
-		else if (cpymo_str_equals_str(op, "<="))
-			run_sub_command = lv <= rv;
-		else goto BAD_EXPRESSION;
+		switch (cond->op) {
+		case cpymo_script_cond_eq: run_sub_command = lv == rv; break;
+		case cpymo_script_cond_ne: run_sub_command = lv != rv; break;
+		case cpymo_script_cond_gt: run_sub_command = lv > rv; break;
+		case cpymo_script_cond_ge: run_sub_command = lv >= rv; break;
+		case cpymo_script_cond_lt: run_sub_command = lv < rv; break;
+		case cpymo_script_cond_le: run_sub_command = lv <= rv; break;
+		default: run_sub_command = false; break;
+		}
 
 		if (run_sub_command) {
-			while (!interpreter->script_parser.is_line_end) {
-				// Skip blanks
-				char ch = cpymo_parser_curline_peek(&interpreter->script_parser);
-				if (ch == ' ' || ch == '\t')
-					cpymo_parser_curline_readchar(&interpreter->script_parser);
-				else break;
-			}
-
-			cpymo_str sub_command =
-				cpymo_parser_curline_readuntil_or(&interpreter->script_parser, ' ', '\t');
-
-			cpymo_str_trim(&sub_command);
-			return cpymo_interpreter_dispatch(sub_command, interpreter, engine, cont);
+			POP_ARG(sub_command);
+			cpymo_script_op sub_op = cpymo_str_equals_str(sub_command, "if") ? 
+				cpymo_op_if : (cpymo_script_op)ins->sub_op;
+			return cpymo_interpreter_dispatch(sub_op, sub_command, interpreter, engine, cont);
 		}
-		
 
 		CONT_NEXTLINE;
-
-		BAD_EXPRESSION: {
-			char *condition_str = cpymo_str_copy_malloc(condition);
-			if (condition_str == NULL) return CPYMO_ERR_OUT_OF_MEM;
-			printf( 
-				"[Error] Bad if expression \"%s\" in script %s(%u).\n", 
-				condition_str,
-				interpreter->script->script_name,
-				(unsigned)interpreter->script_parser.cur_line);
-			free(condition_str);
-			return CPYMO_ERR_INVALID_ARG;
-		}
 	}
 
-	D("call") {
+	D(call) {
 		POP_ARG(script_name);
 		ENSURE(script_name);
 
@@ -995,7 +967,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_UNKNOWN;
 	}
 
-	D("ret") {
+	D(ret) {
 		if (interpreter->caller == NULL) return CPYMO_ERR_NO_MORE_CONTENT;
 
 		assert(engine->interpreter == interpreter);
@@ -1004,14 +976,14 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 
 		engine->interpreter = interpreter->caller;
 		if (interpreter->own_script)
-			cpymo_script_free(interpreter->script);
+			cpymo_script_release(interpreter->script);
 		free(interpreter);
 
 		longjmp(cont, CPYMO_EXEC_CONTVAL_INTERPRETER_UPDATED);
 		return CPYMO_ERR_UNKNOWN;
 	}
 
-	D("sel") {
+	D(sel) {
 		cpymo_interpreter_checkpoint(interpreter);
 
 		POP_ARG(choices_str); ENSURE(choices_str);
@@ -1080,7 +1052,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("select_text") { 
+	D(select_text) { 
 		cpymo_interpreter_checkpoint(interpreter);
 
 		POP_ARG(choices_str); ENSURE(choices_str); 
@@ -1135,7 +1107,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("select_var") {
+	D(select_var) {
 		cpymo_interpreter_checkpoint(interpreter);
 
 		POP_ARG(choices_str); ENSURE(choices_str);
@@ -1189,7 +1161,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("select_img") {
+	D(select_img) {
 		cpymo_interpreter_checkpoint(interpreter);
 
 		POP_ARG(choices_str); ENSURE(choices_str);
@@ -1237,7 +1209,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("select_imgs") {
+	D(select_imgs) {
 		cpymo_interpreter_checkpoint(interpreter);
 
 		POP_ARG(choices_str); ENSURE(choices_str);
@@ -1286,7 +1258,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 	
-	D("wait") {
+	D(wait) {
 		POP_ARG(wait_ms_str);
 		ENSURE(wait_ms_str);
 
@@ -1296,7 +1268,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return CPYMO_ERR_SUCC;
 	}
 
-	D("wait_se") {
+	D(wait_se) {
 		if (cpymo_audio_enabled(engine)) {
 			cpymo_wait_register(&engine->wait, &cpymo_audio_wait_se);
 			return CPYMO_ERR_SUCC;
@@ -1306,7 +1278,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		}
 	}
 
-	D("rand") {
+	D(rand) {
 		POP_ARG(var_name); ENSURE(var_name);
 		POP_ARG(min_val_str); ENSURE(min_val_str);
 		POP_ARG(max_val_str); ENSURE(max_val_str);
@@ -1330,7 +1302,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 	}
 
 	/*** IV. Audio ***/
-	D("bgm") {
+	D(bgm) {
 		POP_ARG(filename); ENSURE(filename);
 		POP_ARG(isloop_s);
 
@@ -1343,12 +1315,12 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_NEXTLINE;
 	}
 
-	D("bgm_stop") {
+	D(bgm_stop) {
 		cpymo_audio_bgm_stop(engine);
 		CONT_NEXTLINE;
 	}
 
-	D("se") {
+	D(se) {
 		POP_ARG(filename); ENSURE(filename);
 		POP_ARG(isloop_s);
 
@@ -1369,12 +1341,12 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		CONT_NEXTLINE;
 	}
 
-	D("se_stop") {
+	D(se_stop) {
 		cpymo_audio_se_stop(engine);
 		CONT_NEXTLINE;
 	}
 
-	D("vo") {
+	D(vo) {
 		POP_ARG(filename); ENSURE(filename);
 
 		if (!cpymo_engine_skipping(engine)) {
@@ -1396,7 +1368,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 	}
 
 	/*** V. System ***/
-	D("load") {
+	D(load) {
 		POP_ARG(save_id_x);
 
 		if (IS_EMPTY(save_id_x)) {
@@ -1421,7 +1393,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		}
 	}
 
-	D("album") {
+	D(album) {
 		POP_ARG(list_name);
 
 		cpymo_str ui_name;
@@ -1437,11 +1409,11 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return cpymo_album_enter(engine, list_name, ui_name, 0);
 	}
 
-	D("music") {
+	D(music) {
 		return cpymo_music_box_enter(engine);
 	}
 
-	D("date") {
+	D(date) {
 		int fmonth = cpymo_vars_get(&engine->vars, cpymo_str_pure("FMONTH"));
 		int fdate = cpymo_vars_get(&engine->vars, cpymo_str_pure("FDATE"));
 		char *str = NULL;
@@ -1471,7 +1443,7 @@ static error_t cpymo_interpreter_dispatch(cpymo_str command, cpymo_interpreter *
 		return err;
 	}
 
-	D("config") {
+	D(config) {
 		return cpymo_config_ui_enter(engine);
 	}
 	
@@ -14,8 +14,14 @@ struct cpymo_interpreter {
 
 	cpymo_parser script_parser;
 
+	// Remaining arguments of the compiled line being executed.
+	const cpymo_str *arg, *arg_end;
+
 	bool no_more_content;
 
+	// Image commands continued in this step while skipping.
+	size_t skipped_in_step;
+
 	struct cpymo_interpreter *caller;
 
 	struct {
@@ -46,4 +52,9 @@ void cpymo_interpreter_checkpoint(cpymo_interpreter *interpreter);
 
 error_t cpymo_interpreter_goto_line(cpymo_interpreter *interpreter, uint64_t line);
 
+#ifdef ENABLE_INTERPRETER_STATS
+// How many times each command has been executed, indexed by cpymo_script_op.
+extern uint64_t cpymo_interpreter_op_stats[cpymo_op_count];
+#endif
+
 #endif
@@ -0,0 +1,113 @@
+﻿#include "cpymo_prelude.h"
+#include "cpymo_name_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stb_ds.h>
+
+struct cpymo_name_cache_slot {
+	char *key;
+	cpymo_name_cache_entry *value;
+};
+
+static void cpymo_name_cache_remove(cpymo_name_cache *c, cpymo_name_cache_entry *e)
+{
+	shdel(c->table, e->key);
+	cpymo_backend_text_free(e->text);
+	free(e->key);
+	free(e);
+}
+
+void cpymo_name_cache_init(cpymo_name_cache *c)
+{
+	c->table = NULL;
+	c->hits = 0;
+	c->misses = 0;
+	c->evictions = 0;
+}
+
+void cpymo_name_cache_free(cpymo_name_cache *c)
+{
+#ifndef NDEBUG
+	printf("[Info] Name cache: %u hits, %u misses, %u evictions.\n",
+		c->hits, c->misses, c->evictions);
+#endif
+
+	// cpymo_say and cpymo_backlog are freed first,
+	// a name still referenced here was never given back.
+	while (shlenu(c->table)) {
+		assert(c->table[shlenu(c->table) - 1].value->refs == 0);
+		cpymo_name_cache_remove(c, c->table[shlenu(c->table) - 1].value);
+	}
+
+	shfree(c->table);
+}
+
+static void cpymo_name_cache_evict_unused(cpymo_name_cache *c)
+{
+	// shdel() moves the last slot into the deleted one,
+	// going backwards every slot is visited once.
+	for (size_t i = shlenu(c->table); i > 0; --i) {
+		cpymo_name_cache_entry *e = c->table[i - 1].value;
+		if (e->refs == 0) {
+			cpymo_name_cache_remove(c, e);
+			c->evictions++;
+		}
+	}
+}
+
+cpymo_name_cache_entry *cpymo_name_cache_get(
+	cpymo_name_cache *c, cpymo_str name, float fontsize)
+{
+	char buf[128];
+	char *key = buf;
+	int len = snprintf(buf, sizeof(buf), "%g/%.*s", fontsize, (int)name.len, name.begin);
+	if (len < 0) return NULL;
+
+	// Names longer than buf are unusual, but still cached.
+	if ((size_t)len >= sizeof(buf)) {
+		key = (char *)malloc((size_t)len + 1);
+		if (key == NULL) return NULL;
+		snprintf(key, (size_t)len + 1, "%g/%.*s", fontsize, (int)name.len, name.begin);
+	}
+
+	struct cpymo_name_cache_slot *slot = shgetp_null(c->table, key);
+	if (slot) {
+		if (key != buf) free(key);
+		c->hits++;
+		return cpymo_name_cache_ref(slot->value);
+	}
+
+	c->misses++;
+	if (shlenu(c->table) >= CPYMO_NAME_CACHE_SIZE)
+		cpymo_name_cache_evict_unused(c);
+
+	cpymo_name_cache_entry *e = 
+		(cpymo_name_cache_entry *)malloc(sizeof(cpymo_name_cache_entry));
+	if (e == NULL) goto FAIL;
+
+	e->refs = 1;
+	e->width = 0;
+	e->key = key;
+	if (key == buf) {
+		e->key = (char *)malloc((size_t)len + 1);
+		if (e->key == NULL) goto FAIL;
+		strcpy(e->key, buf);
+	}
+
+	error_t err = cpymo_backend_text_create(&e->text, &e->width, name, fontsize);
+	if (err != CPYMO_ERR_SUCC) goto FAIL;
+
+	shput(c->table, e->key, e);
+	return e;
+
+FAIL:
+	if (e) {
+		if (e->key != key) free(e->key);
+		free(e);
+	}
+
+	if (key != buf) free(key);
+	return NULL;
+}
@@ -0,0 +1,51 @@
+#ifndef INCLUDE_CPYMO_NAME_CACHE
+#define INCLUDE_CPYMO_NAME_CACHE
+
+#include "cpymo_error.h"
+#include "cpymo_str.h"
+#include <cpymo_backend_text.h>
+#include <assert.h>
+
+// Rendered speaker names shared by cpymo_say and cpymo_backlog.
+// A game has few speakers repeated thousands of times,
+// so a repeated name is not rendered again.
+// Entries are reference counted, unused entries are kept
+// until the cache has more than CPYMO_NAME_CACHE_SIZE names.
+// Only used from the main thread.
+
+#ifndef CPYMO_NAME_CACHE_SIZE
+#define CPYMO_NAME_CACHE_SIZE 32
+#endif
+
+typedef struct cpymo_name_cache_entry {
+	cpymo_backend_text text;
+	float width;
+
+	unsigned refs;
+	char *key;
+} cpymo_name_cache_entry;
+
+struct cpymo_name_cache_slot;
+
+typedef struct {
+	struct cpymo_name_cache_slot *table;
+	unsigned hits, misses, evictions;
+} cpymo_name_cache;
+
+void cpymo_name_cache_init(cpymo_name_cache *);
+void cpymo_name_cache_free(cpymo_name_cache *);
+
+// Returns a new reference to the rendered name,
+// or NULL if it can not be rendered.
+cpymo_name_cache_entry *cpymo_name_cache_get(
+	cpymo_name_cache *, cpymo_str name, float fontsize);
+
+static inline cpymo_name_cache_entry *cpymo_name_cache_ref(cpymo_name_cache_entry *e)
+{ if (e) e->refs++; return e; }
+
+// Entry stays in the cache, it is freed by later cpymo_name_cache_get()
+// when the cache is full, or by cpymo_name_cache_free().
+static inline void cpymo_name_cache_unref(cpymo_name_cache_entry *e)
+{ assert(e == NULL || e->refs > 0); if (e && e->refs) e->refs--; }
+
+#endif
@@ -7,13 +7,92 @@
 #include <endianness.h>
 #include <stb_image.h>
 #include <assert.h>
+#include <ctype.h>
 
-error_t cpymo_package_open(cpymo_package *out_package, const char * path)
+#ifdef ENABLE_PACKAGE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef CPYMO_PACKAGE_CONCURRENT_READ
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+// With CPYMO_PACKAGE_CONCURRENT_READ it reads with pread and never touches
+// the position of the shared stream, elsewhere it falls back to fseek + fread,
+// so every read must come from the same thread.
+static size_t cpymo_package_read_at(
+	FILE *stream, const char *mapped, char *dst, size_t size, size_t offset)
 {
-#ifndef NDEBUG
-	out_package->has_stream_reader = false;
+#ifdef ENABLE_PACKAGE_MMAP
+	if (mapped) {
+		memcpy(dst, mapped + offset, size);
+		return size;
+	}
 #endif
-	
+
+	size_t done = 0;
+
+#ifdef CPYMO_PACKAGE_CONCURRENT_READ
+	const int fd = fileno(stream);
+	while (done < size) {
+		ssize_t r = pread(fd, dst + done, size - done, (off_t)(offset + done));
+		if (r < 0 && errno == EINTR) continue;
+		if (r <= 0) break;
+		done += (size_t)r;
+	}
+#else
+	if (fseek(stream, (long)offset, SEEK_SET) == 0)
+		done = fread(dst, 1, size, stream);
+#endif
+
+	return done;
+}
+
+static uint64_t cpymo_package_hash_name(cpymo_str name)
+{
+	uint64_t hash;
+	cpymo_str_hash_init(&hash);
+	for (size_t i = 0; i < name.len; ++i)
+		cpymo_str_hash_step(&hash, (char)toupper((unsigned char)name.begin[i]));
+	return hash;
+}
+
+static cpymo_str cpymo_package_index_name(const cpymo_package_index *index)
+{
+	cpymo_str name;
+	name.begin = index->file_name;
+	name.len = 0;
+	while (name.len < sizeof(index->file_name) && name.begin[name.len])
+		name.len++;
+	return name;
+}
+
+static error_t cpymo_package_build_name_table(cpymo_package *pkg)
+{
+	uint32_t capacity = 16;
+	while (capacity / 2 < pkg->file_count && capacity < 0x80000000u) capacity *= 2;
+
+	pkg->name_table = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+	if (pkg->name_table == NULL) return CPYMO_ERR_OUT_OF_MEM;
+	pkg->name_table_mask = capacity - 1;
+
+	for (uint32_t i = 0; i < pkg->file_count; ++i) {
+		uint32_t slot = (uint32_t)cpymo_package_hash_name(
+			cpymo_package_index_name(pkg->files + i)) & pkg->name_table_mask;
+
+		while (pkg->name_table[slot])
+			slot = (slot + 1) & pkg->name_table_mask;
+
+		pkg->name_table[slot] = i + 1;
+	}
+
+	return CPYMO_ERR_SUCC;
+}
+
+error_t cpymo_package_open(cpymo_package *out_package, const char * path)
+{
 	if (out_package == NULL) return CPYMO_ERR_INVALID_ARG;
 
 	out_package->stream = fopen(path, "rb");
@@ -33,9 +112,18 @@ error_t cpymo_package_open(cpymo_package *out_package, const char * path)
 		return CPYMO_ERR_BAD_FILE_FORMAT;
 	}
 
+	out_package->name_table = NULL;
+#ifdef ENABLE_PACKAGE_MMAP
+	out_package->mapped = NULL;
+	out_package->mapped_size = 0;
+#endif
+
 	out_package->files = (cpymo_package_index *)malloc(sizeof(cpymo_package_index) * out_package->file_count);
 
-	if (out_package->files == NULL) return CPYMO_ERR_OUT_OF_MEM;
+	if (out_package->files == NULL) {
+		fclose(out_package->stream);
+		return CPYMO_ERR_OUT_OF_MEM;
+	}
 	
 	count =
 		fread(
@@ -55,11 +143,36 @@ error_t cpymo_package_open(cpymo_package *out_package, const char * path)
 		file->file_offset = end_le32toh(file->file_offset);
 	}
 
+	error_t err = cpymo_package_build_name_table(out_package);
+	if (err != CPYMO_ERR_SUCC) {
+		cpymo_package_close(out_package);
+		return err;
+	}
+
+#ifdef ENABLE_PACKAGE_MMAP
+	// If mapping fails, fall back to reading from stream.
+	struct stat st;
+	int fd = fileno(out_package->stream);
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		void *mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) {
+			out_package->mapped = (const char *)mapped;
+			out_package->mapped_size = (size_t)st.st_size;
+		}
+	}
+#endif
+
 	return CPYMO_ERR_SUCC;
 }
 
 void cpymo_package_close(cpymo_package * package)
 {
+#ifdef ENABLE_PACKAGE_MMAP
+	if (package->mapped) 
+		munmap((void *)package->mapped, package->mapped_size);
+#endif
+
+	if (package->name_table) free(package->name_table);
 	free(package->files);
 	fclose(package->stream);
 }
@@ -74,11 +187,19 @@ error_t cpymo_package_find(cpymo_package_index * out_index, const cpymo_package
 		puts("\" is too long!");
 	}
 
-	for (uint32_t i = 0; i < package->file_count; ++i) {
-		if (cpymo_str_equals_str_ignore_case(filename, package->files[i].file_name)) {
-			*out_index = package->files[i];
+	uint32_t slot = 
+		(uint32_t)cpymo_package_hash_name(filename) & package->name_table_mask;
+
+	while (package->name_table[slot]) {
+		const cpymo_package_index *index = 
+			package->files + package->name_table[slot] - 1;
+
+		if (cpymo_str_equals_ignore_case(filename, cpymo_package_index_name(index))) {
+			*out_index = *index;
 			return CPYMO_ERR_SUCC;
 		}
+
+		slot = (slot + 1) & package->name_table_mask;
 	}
 
 	return CPYMO_ERR_NOT_FOUND;
@@ -86,11 +207,20 @@ error_t cpymo_package_find(cpymo_package_index * out_index, const cpymo_package
 
 error_t cpymo_package_read_file_from_index(char *out_buffer, const cpymo_package * package, const cpymo_package_index * index)
 {
-	assert(package->has_stream_reader == false);
-	fseek(package->stream, index->file_offset, SEEK_SET);
-	const size_t count = fread(out_buffer, index->file_length, 1, package->stream);
+	const char *mapped = NULL;
+#ifdef ENABLE_PACKAGE_MMAP
+	if (package->mapped) {
+		if ((size_t)index->file_offset + index->file_length > package->mapped_size)
+			return CPYMO_ERR_BAD_FILE_FORMAT;
+		mapped = package->mapped;
+	}
+#endif
 
-	if (count != 1) return CPYMO_ERR_BAD_FILE_FORMAT;
+	const size_t count = cpymo_package_read_at(
+		package->stream, mapped, out_buffer, 
+		index->file_length, index->file_offset);
+
+	if (count != index->file_length) return CPYMO_ERR_BAD_FILE_FORMAT;
 
 	return CPYMO_ERR_SUCC;
 }
@@ -109,6 +239,52 @@ error_t cpymo_package_read_file(char **out_buffer, size_t *sz, const cpymo_packa
 	return cpymo_package_read_file_from_index(*out_buffer, package, &idx);
 }
 
+error_t cpymo_package_view_from_index(cpymo_package_view *out_view, const cpymo_package *package, const cpymo_package_index *index)
+{
+	out_view->data = NULL;
+	out_view->size = index->file_length;
+	out_view->owned = NULL;
+
+#ifdef ENABLE_PACKAGE_MMAP
+	if (package->mapped) {
+		if ((size_t)index->file_offset + index->file_length > package->mapped_size)
+			return CPYMO_ERR_BAD_FILE_FORMAT;
+
+		out_view->data = package->mapped + index->file_offset;
+		return CPYMO_ERR_SUCC;
+	}
+#endif
+
+	out_view->owned = (char *)malloc(index->file_length);
+	out_view->data = out_view->owned;
+	if (out_view->owned == NULL) return CPYMO_ERR_OUT_OF_MEM;
+
+	error_t err = cpymo_package_read_file_from_index(out_view->owned, package, index);
+	if (err != CPYMO_ERR_SUCC) {
+		cpymo_package_view_free(out_view);
+		return err;
+	}
+
+	return CPYMO_ERR_SUCC;
+}
+
+error_t cpymo_package_view_file(cpymo_package_view *out_view, const cpymo_package *package, cpymo_str filename)
+{
+	cpymo_package_index idx;
+	error_t err = cpymo_package_find(&idx, package, filename);
+	CPYMO_THROW(err);
+
+	return cpymo_package_view_from_index(out_view, package, &idx);
+}
+
+void cpymo_package_view_free(cpymo_package_view *view)
+{
+	if (view->owned) free(view->owned);
+	view->owned = NULL;
+	view->data = NULL;
+	view->size = 0;
+}
+
 #ifdef STREAMING_LOAD_IMAGE
 
 static int cpymo_package_stream_read_image_eof(void *stream_reader)
@@ -132,43 +308,40 @@ static void cpymo_package_stream_reader_image_skip(void *stream_reader, int n)
 error_t cpymo_package_read_image_from_index(void ** pixels, int * w, int * h, int channels, const cpymo_package * pkg, const cpymo_package_index * index)
 {	
 #ifdef STREAMING_LOAD_IMAGE
-	stbi_io_callbacks cbs;
-	cbs.eof = &cpymo_package_stream_read_image_eof;
-	cbs.read = &cpymo_package_stream_reader_image_read;
-	cbs.skip = &cpymo_package_stream_reader_image_skip;
-
-	cpymo_package_stream_reader sr = cpymo_package_stream_reader_create(pkg, index);
-
-	*pixels = stbi_load_from_callbacks(&cbs, &sr, w, h, NULL, channels);
+	if (!cpymo_package_mapped(pkg)) {
+		stbi_io_callbacks cbs;
+		cbs.eof = &cpymo_package_stream_read_image_eof;
+		cbs.read = &cpymo_package_stream_reader_image_read;
+		cbs.skip = &cpymo_package_stream_reader_image_skip;
 
-	cpymo_package_stream_reader_close(&sr);
+		cpymo_package_stream_reader sr = cpymo_package_stream_reader_create(pkg, index);
 
-	if (*pixels == NULL) {
-		return CPYMO_ERR_BAD_FILE_FORMAT;
-	}
+		*pixels = stbi_load_from_callbacks(&cbs, &sr, w, h, NULL, channels);
 
-	return CPYMO_ERR_SUCC;
+		cpymo_package_stream_reader_close(&sr);
 
-#else
-	stbi_uc *file_data = (stbi_uc *)malloc(index->file_length);
-	if (file_data == NULL) return CPYMO_ERR_OUT_OF_MEM;
+		if (*pixels == NULL) {
+			return CPYMO_ERR_BAD_FILE_FORMAT;
+		}
 
-	error_t err = cpymo_package_read_file_from_index((char *)file_data, pkg, index);
-	if (err != CPYMO_ERR_SUCC) {
-		free(file_data);
-		return err;
+		return CPYMO_ERR_SUCC;
 	}
+#endif
+
+	cpymo_package_view file_data;
+	error_t err = cpymo_package_view_from_index(&file_data, pkg, index);
+	CPYMO_THROW(err);
 
 	// Why this method is faster than stream loading in package ???
-	*pixels = stbi_load_from_memory(file_data, index->file_length, w, h, NULL, channels);
-	free(file_data);
+	*pixels = stbi_load_from_memory(
+		(const stbi_uc *)file_data.data, (int)file_data.size, w, h, NULL, channels);
+	cpymo_package_view_free(&file_data);
 	
 	if (*pixels == NULL) {
 		return CPYMO_ERR_BAD_FILE_FORMAT;
 	}
 
 	return CPYMO_ERR_SUCC;
-#endif
 }
 
 error_t cpymo_package_read_image(void ** pixels, int * w, int * h, int channels, const cpymo_package * pkg, cpymo_str filename)
@@ -199,7 +372,6 @@ error_t cpymo_package_stream_reader_seek(size_t seek, cpymo_package_stream_reade
 	}
 
 	r->current = seek;
-	fseek(r->stream, (long)(r->file_offset + r->current), SEEK_SET);
 	
 	return CPYMO_ERR_SUCC;
 }
@@ -211,16 +383,15 @@ size_t cpymo_package_stream_reader_read(char *dst_buf, size_t dst_buf_size, cpym
 
 	if (read_size <= 0) return 0;
 
+	read_size = cpymo_package_read_at(
+		r->stream, r->mapped, dst_buf, read_size, r->file_offset + r->current);
 	r->current += read_size;
 
-	return fread(dst_buf, read_size, 1, r->stream) * read_size;
+	return read_size;
 }
 
 void cpymo_package_stream_reader_close(cpymo_package_stream_reader * r)
 {
-#ifndef NDEBUG
-	r->package->has_stream_reader = false;
-#endif
 }
 
 cpymo_package_stream_reader cpymo_package_stream_reader_create(
@@ -232,11 +403,14 @@ cpymo_package_stream_reader cpymo_package_stream_reader_create(
 	reader.file_length = index->file_length;
 	reader.current = 0;
 	reader.stream = package->stream;
-#ifndef NDEBUG
-	assert(package->has_stream_reader == false);
-	reader.package = (cpymo_package *)package;
+	reader.mapped = NULL;
+
+#ifdef ENABLE_PACKAGE_MMAP
+	if (package->mapped && 
+		(size_t)index->file_offset + index->file_length <= package->mapped_size)
+		reader.mapped = package->mapped;
 #endif
-	cpymo_package_stream_reader_seek(0, &reader);
+
 	return reader;
 }
 
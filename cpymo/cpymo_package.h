@@ -7,6 +7,18 @@
 #include "cpymo_parser.h"
 #include "cpymo_error.h"
 
+#if defined ENABLE_PACKAGE_MMAP && !(defined __unix__ || defined __APPLE__)
+#undef ENABLE_PACKAGE_MMAP
+#endif
+
+// Platforms where cpymo_package_read_at() never moves the shared stream,
+// so a package can be read from several threads at once.
+// Windows has no positional read on the synchronous CRT handle,
+// ReadFile with an OVERLAPPED offset still moves its file pointer.
+#if defined __linux__ || defined __APPLE__ || defined __EMSCRIPTEN__
+#define CPYMO_PACKAGE_CONCURRENT_READ
+#endif
+
 typedef struct {
 	char file_name[32];
 	uint32_t file_offset;
@@ -16,19 +28,49 @@ typedef struct {
 typedef struct {
 	uint32_t file_count;
 	cpymo_package_index *files;
+
+	// Open addressing hash table over case-folded file names,
+	// each slot stores (index in files + 1), 0 means empty.
+	uint32_t *name_table;
+	uint32_t name_table_mask;
+
 	FILE *stream;
 
-#ifndef NDEBUG
-	bool has_stream_reader;
+#ifdef ENABLE_PACKAGE_MMAP
+	// Whole package file mapped read-only, NULL if mapping failed.
+	const char *mapped;
+	size_t mapped_size;
 #endif
 } cpymo_package;
 
+// Read-only file content inside a package.
+// When the package is memory mapped, data points into the mapping 
+// and nothing is copied, otherwise data is owned by the view.
+typedef struct {
+	const char *data;
+	size_t size;
+	char *owned;
+} cpymo_package_view;
+
+static inline bool cpymo_package_mapped(const cpymo_package *package)
+{
+#ifdef ENABLE_PACKAGE_MMAP
+	return package->mapped != NULL;
+#else
+	return false;
+#endif
+}
+
 error_t cpymo_package_open(cpymo_package *out_package, const char *path);
 void cpymo_package_close(cpymo_package *package);
 error_t cpymo_package_find(cpymo_package_index *out_index, const cpymo_package *package, cpymo_str filename);
 error_t cpymo_package_read_file_from_index(char *out_buffer, const cpymo_package *package, const cpymo_package_index *index);
 error_t cpymo_package_read_file(char **out_buffer, size_t *sz, const cpymo_package *package, cpymo_str filename);
 
+error_t cpymo_package_view_from_index(cpymo_package_view *out_view, const cpymo_package *package, const cpymo_package_index *index);
+error_t cpymo_package_view_file(cpymo_package_view *out_view, const cpymo_package *package, cpymo_str filename);
+void cpymo_package_view_free(cpymo_package_view *view);
+
 error_t cpymo_package_read_image_from_index(
 	void **pixels, int *w, int *h, int channels, 
 	const cpymo_package *pkg, const cpymo_package_index *index);
@@ -37,15 +79,15 @@ error_t cpymo_package_read_image(
 	void **pixels, int *w, int *h, int channels,
 	const cpymo_package *pkg, cpymo_str filename);
 
+// Stream readers keep their own offset and read with positional reads,
+// so any number of readers and whole file reads may run concurrently
+// on one package with CPYMO_PACKAGE_CONCURRENT_READ.
 typedef struct {
 	size_t file_offset;
 	size_t file_length;
 	size_t current;
 	FILE *stream;
-
-#ifndef NDEBUG
-	cpymo_package *package;
-#endif
+	const char *mapped;
 } cpymo_package_stream_reader;
 
 cpymo_package_stream_reader cpymo_package_stream_reader_create(
@@ -0,0 +1,484 @@
+﻿#include "cpymo_prelude.h"
+#include "cpymo_prefetch.h"
+
+#ifdef ENABLE_ASSET_PREFETCH
+
+#include "cpymo_assetloader.h"
+#include "cpymo_interpreter.h"
+#include "cpymo_image_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define CPYMO_PREFETCH_NAME_LEN 64
+
+enum {
+	cpymo_prefetch_free_slot,
+	cpymo_prefetch_queued,
+	cpymo_prefetch_decoding,
+	cpymo_prefetch_ready
+};
+
+typedef struct {
+	int state;
+	cpymo_prefetch_type type;
+	char name[CPYMO_PREFETCH_NAME_LEN];
+
+	// Scan generation which last saw this asset in the lookahead window,
+	// entries from older generations will not be used any more.
+	unsigned generation;
+	unsigned order;
+
+	error_t err;
+	void *pixels, *mask;
+	int w, h, mw, mh;
+} cpymo_prefetch_entry;
+
+struct cpymo_prefetch {
+	const cpymo_assetloader *loader;
+
+	cpymo_mutex mutex;
+	cpymo_cond work_cond, done_cond;
+	bool quit;
+
+	cpymo_thread workers[CPYMO_PREFETCH_WORKERS];
+	size_t worker_count;
+
+	cpymo_prefetch_entry entries[CPYMO_PREFETCH_SLOTS];
+	unsigned generation, order;
+
+	size_t lookahead;
+	const cpymo_script *last_script;
+	size_t last_pos;
+
+	cpymo_prefetch_stats stats;
+};
+
+static void cpymo_prefetch_entry_clear(cpymo_prefetch_entry *e)
+{
+	if (e->pixels) free(e->pixels);
+	if (e->mask) free(e->mask);
+	e->pixels = NULL;
+	e->mask = NULL;
+	e->state = cpymo_prefetch_free_slot;
+}
+
+static cpymo_prefetch_entry *cpymo_prefetch_next_job(struct cpymo_prefetch *p)
+{
+	cpymo_prefetch_entry *job = NULL;
+	for (size_t i = 0; i < CPYMO_PREFETCH_SLOTS; ++i) {
+		cpymo_prefetch_entry *e = p->entries + i;
+		if (e->state == cpymo_prefetch_queued && (job == NULL || e->order < job->order))
+			job = e;
+	}
+
+	return job;
+}
+
+static void cpymo_prefetch_worker(void *param)
+{
+	struct cpymo_prefetch *p = (struct cpymo_prefetch *)param;
+
+	cpymo_mutex_lock(&p->mutex);
+	while (true) {
+		cpymo_prefetch_entry *e;
+		while (!p->quit && (e = cpymo_prefetch_next_job(p)) == NULL)
+			cpymo_cond_wait(&p->work_cond, &p->mutex);
+
+		if (p->quit) break;
+
+		// Nobody else touches an entry while it is decoding,
+		// so it's safe to use it without holding the lock.
+		e->state = cpymo_prefetch_decoding;
+		cpymo_mutex_unlock(&p->mutex);
+
+		void *pixels = NULL, *mask = NULL;
+		int w = 0, h = 0, mw = 0, mh = 0;
+		cpymo_str name = cpymo_str_pure(e->name);
+		error_t err;
+		switch (e->type) {
+		case cpymo_prefetch_bg:
+			err = cpymo_assetloader_load_bg_pixels(&pixels, &w, &h, name, p->loader);
+			break;
+		case cpymo_prefetch_chara:
+			err = cpymo_assetloader_load_chara_pixels(
+				&pixels, &w, &h, &mask, &mw, &mh, name, p->loader);
+			break;
+		default:
+			err = cpymo_assetloader_load_system_pixels(
+				&pixels, &w, &h, &mask, &mw, &mh, name, p->loader, true);
+			break;
+		}
+
+		cpymo_mutex_lock(&p->mutex);
+		e->err = err;
+		e->pixels = pixels;
+		e->mask = mask;
+		e->w = w;
+		e->h = h;
+		e->mw = mw;
+		e->mh = mh;
+		e->state = cpymo_prefetch_ready;
+		cpymo_cond_broadcast(&p->done_cond);
+	}
+	cpymo_mutex_unlock(&p->mutex);
+}
+
+error_t cpymo_prefetch_create(struct cpymo_prefetch **out, const cpymo_assetloader *loader)
+{
+	struct cpymo_prefetch *p = (struct cpymo_prefetch *)malloc(sizeof(struct cpymo_prefetch));
+	if (p == NULL) return CPYMO_ERR_OUT_OF_MEM;
+
+	memset(p, 0, sizeof(*p));
+	p->loader = loader;
+	p->lookahead = CPYMO_PREFETCH_LOOKAHEAD;
+	p->last_pos = (size_t)-1;
+
+	error_t err = cpymo_mutex_init(&p->mutex);
+	if (err != CPYMO_ERR_SUCC) {
+		free(p);
+		return err;
+	}
+
+	err = cpymo_cond_init(&p->work_cond);
+	if (err != CPYMO_ERR_SUCC) {
+		cpymo_mutex_free(&p->mutex);
+		free(p);
+		return err;
+	}
+
+	err = cpymo_cond_init(&p->done_cond);
+	if (err != CPYMO_ERR_SUCC) {
+		cpymo_cond_free(&p->work_cond);
+		cpymo_mutex_free(&p->mutex);
+		free(p);
+		return err;
+	}
+
+	// Leave one core for the main thread.
+	size_t workers = cpymo_thread_hardware_concurrency();
+	workers = workers > 1 ? workers - 1 : 1;
+	if (workers > CPYMO_PREFETCH_WORKERS) workers = CPYMO_PREFETCH_WORKERS;
+
+	for (p->worker_count = 0; p->worker_count < workers; p->worker_count++) {
+		err = cpymo_thread_create(
+			&p->workers[p->worker_count], &cpymo_prefetch_worker, p);
+		if (err != CPYMO_ERR_SUCC) break;
+	}
+
+	if (p->worker_count == 0) {
+		cpymo_prefetch_free(p);
+		return err;
+	}
+
+	*out = p;
+	return CPYMO_ERR_SUCC;
+}
+
+void cpymo_prefetch_free(struct cpymo_prefetch *p)
+{
+	if (p == NULL) return;
+
+	cpymo_mutex_lock(&p->mutex);
+	p->quit = true;
+	cpymo_cond_broadcast(&p->work_cond);
+	cpymo_mutex_unlock(&p->mutex);
+
+	for (size_t i = 0; i < p->worker_count; ++i)
+		cpymo_thread_join(p->workers[i]);
+
+	for (size_t i = 0; i < CPYMO_PREFETCH_SLOTS; ++i)
+		cpymo_prefetch_entry_clear(p->entries + i);
+
+#ifndef NDEBUG
+	printf("[Info] Asset prefetch: %u hits, %u misses, %u requested, %u dropped, %u evicted.\n",
+		p->stats.hits, p->stats.misses, p->stats.requested, p->stats.dropped, p->stats.evicted);
+#endif
+
+	cpymo_cond_free(&p->done_cond);
+	cpymo_cond_free(&p->work_cond);
+	cpymo_mutex_free(&p->mutex);
+	free(p);
+}
+
+static cpymo_prefetch_entry *cpymo_prefetch_find(
+	struct cpymo_prefetch *p, cpymo_prefetch_type type, cpymo_str name)
+{
+	for (size_t i = 0; i < CPYMO_PREFETCH_SLOTS; ++i) {
+		cpymo_prefetch_entry *e = p->entries + i;
+		if (e->state != cpymo_prefetch_free_slot
+			&& e->type == type
+			&& cpymo_str_equals_str(name, e->name))
+			return e;
+	}
+
+	return NULL;
+}
+
+static const char *cpymo_prefetch_asset_type(cpymo_prefetch_type type)
+{
+	switch (type) {
+	case cpymo_prefetch_bg: return "bg";
+	case cpymo_prefetch_chara: return "chara";
+	default: return "system";
+	}
+}
+
+void cpymo_prefetch_request(struct cpymo_prefetch *p, cpymo_prefetch_type type, cpymo_str name)
+{
+	if (name.len == 0 || name.len >= CPYMO_PREFETCH_NAME_LEN) return;
+
+	// Already decoded, loading it from the image cache is just a copy.
+	const bool with_mask = 
+		type != cpymo_prefetch_bg && cpymo_gameconfig_is_symbian(p->loader->game_config);
+	if (cpymo_image_cache_contains(
+		p->loader->image_cache, cpymo_prefetch_asset_type(type), name, with_mask)) 
+		return;
+
+	cpymo_mutex_lock(&p->mutex);
+
+	cpymo_prefetch_entry *e = cpymo_prefetch_find(p, type, name);
+	if (e) {
+		e->generation = p->generation;
+		cpymo_mutex_unlock(&p->mutex);
+		return;
+	}
+
+	for (size_t i = 0; i < CPYMO_PREFETCH_SLOTS; ++i) {
+		if (p->entries[i].state == cpymo_prefetch_free_slot) {
+			e = p->entries + i;
+			break;
+		}
+	}
+
+	if (e == NULL) {
+		p->stats.dropped++;
+		cpymo_mutex_unlock(&p->mutex);
+		return;
+	}
+
+	e->state = cpymo_prefetch_queued;
+	e->type = type;
+	cpymo_str_copy(e->name, sizeof(e->name), name);
+	e->generation = p->generation;
+	e->order = p->order++;
+	e->pixels = NULL;
+	e->mask = NULL;
+	p->stats.requested++;
+
+	cpymo_cond_signal(&p->work_cond);
+	cpymo_mutex_unlock(&p->mutex);
+}
+
+bool cpymo_prefetch_take(
+	struct cpymo_prefetch *p, cpymo_prefetch_type type, cpymo_str name,
+	void **pixels, int *w, int *h,
+	void **mask, int *mw, int *mh)
+{
+	if (p == NULL) return false;
+
+	cpymo_mutex_lock(&p->mutex);
+
+	cpymo_prefetch_entry *e = cpymo_prefetch_find(p, type, name);
+	if (e == NULL || e->state == cpymo_prefetch_queued) {
+		if (e) e->state = cpymo_prefetch_free_slot;
+		p->stats.misses++;
+		cpymo_mutex_unlock(&p->mutex);
+		return false;
+	}
+
+	while (e->state == cpymo_prefetch_decoding)
+		cpymo_cond_wait(&p->done_cond, &p->mutex);
+
+	if (e->err != CPYMO_ERR_SUCC) {
+		// Let the caller load it again and report the error.
+		cpymo_prefetch_entry_clear(e);
+		p->stats.misses++;
+		cpymo_mutex_unlock(&p->mutex);
+		return false;
+	}
+
+	*pixels = e->pixels;
+	*w = e->w;
+	*h = e->h;
+	e->pixels = NULL;
+
+	if (mask) {
+		*mask = e->mask;
+		*mw = e->mw;
+		*mh = e->mh;
+		e->mask = NULL;
+	}
+
+	cpymo_prefetch_entry_clear(e);
+	p->stats.hits++;
+	cpymo_mutex_unlock(&p->mutex);
+	return true;
+}
+
+static inline cpymo_str cpymo_prefetch_pop_arg(const cpymo_str **arg, const cpymo_str *arg_end)
+{
+	if (*arg < arg_end) return *(*arg)++;
+
+	cpymo_str empty = { "", 0 };
+	return empty;
+}
+
+#define D(CMD) \
+	else if (ins->op == cpymo_op_##CMD)
+
+#define POP_ARG(X) \
+	cpymo_str X = cpymo_prefetch_pop_arg(&arg, arg_end)
+
+// Returns false when the script flow leaves this line sequence.
+static bool cpymo_prefetch_scan_line(
+	struct cpymo_prefetch *p, const cpymo_script *script, const cpymo_script_instr *ins)
+{
+	const cpymo_str *arg = script->args + ins->first_arg;
+	const cpymo_str *arg_end = arg + ins->argc;
+
+	if (ins->op == cpymo_op_none) return true;
+
+	D(bg) {
+		POP_ARG(name);
+		cpymo_prefetch_request(p, cpymo_prefetch_bg, name);
+	}
+
+	D(scroll) {
+		POP_ARG(name);
+		cpymo_prefetch_request(p, cpymo_prefetch_bg, name);
+	}
+
+	D(chara) {
+		while (true) {
+			POP_ARG(id_or_time);
+			POP_ARG(name);
+			if (name.len == 0) break;
+			if (!cpymo_str_equals_str(name, "NULL"))
+				cpymo_prefetch_request(p, cpymo_prefetch_chara, name);
+			POP_ARG(x);
+			POP_ARG(layer);
+			(void)id_or_time; (void)x; (void)layer;
+		}
+	}
+
+	D(chara_y) {
+		POP_ARG(coord_mode);
+		(void)coord_mode;
+		while (true) {
+			POP_ARG(id_or_time);
+			POP_ARG(name);
+			if (name.len == 0) break;
+			if (!cpymo_str_equals_str(name, "NULL"))
+				cpymo_prefetch_request(p, cpymo_prefetch_chara, name);
+			POP_ARG(x);
+			POP_ARG(y);
+			POP_ARG(layer);
+			(void)id_or_time; (void)x; (void)y; (void)layer;
+		}
+	}
+
+	D(chara_scroll) {
+		POP_ARG(coord_mode);
+		POP_ARG(id);
+		POP_ARG(filename_or_endx);
+		POP_ARG(startx_or_endy);
+		POP_ARG(starty_or_time);
+		POP_ARG(endx);
+		(void)coord_mode; (void)id; (void)startx_or_endy; (void)starty_or_time;
+		if (endx.len)
+			cpymo_prefetch_request(p, cpymo_prefetch_chara, filename_or_endx);
+	}
+
+	D(select_img) {
+		POP_ARG(choices);
+		POP_ARG(name);
+		(void)choices;
+		cpymo_prefetch_request(p, cpymo_prefetch_system, name);
+	}
+
+	D(select_imgs) {
+		POP_ARG(choices_str);
+		int choices = cpymo_str_atoi(choices_str);
+		for (int i = 0; i < choices; ++i) {
+			POP_ARG(name);
+			POP_ARG(x);
+			POP_ARG(y);
+			POP_ARG(v);
+			(void)x; (void)y; (void)v;
+			cpymo_prefetch_request(p, cpymo_prefetch_system, name);
+		}
+	}
+
+#ifndef LOW_FRAME_RATE
+	D(anime_on) {
+		POP_ARG(frames);
+		POP_ARG(name);
+		(void)frames;
+		cpymo_prefetch_request(p, cpymo_prefetch_system, name);
+	}
+#endif
+
+	D(goto) return false;
+	D(change) return false;
+	D(call) return false;
+	D(ret) return false;
+
+	return true;
+}
+
+#undef D
+#undef POP_ARG
+
+void cpymo_prefetch_scan(struct cpymo_prefetch *p, const cpymo_interpreter *interpreter)
+{
+	if (p == NULL || interpreter == NULL) return;
+
+	const cpymo_parser *cur = &interpreter->script_parser;
+	if (interpreter->script == p->last_script && cur->cur_pos == p->last_pos) return;
+
+	p->last_script = interpreter->script;
+	p->last_pos = cur->cur_pos;
+	p->generation++;
+
+	// The current line is scanned only if it has not been executed yet.
+	const cpymo_script *script = interpreter->script;
+	size_t line = cur->cur_line;
+	const cpymo_script_instr *ins = cpymo_script_instr_at(script, line);
+	if (ins && (cur->is_line_end || cur->cur_pos != ins->begin)) line++;
+
+	for (size_t i = 0; i < p->lookahead; ++i) {
+		ins = cpymo_script_instr_at(script, line + i);
+		if (ins == NULL) break;
+		if (!cpymo_prefetch_scan_line(p, script, ins)) break;
+	}
+
+	// Anything not seen in this window belongs to lines already passed 
+	// or to a branch that was not taken.
+	cpymo_mutex_lock(&p->mutex);
+	for (size_t i = 0; i < CPYMO_PREFETCH_SLOTS; ++i) {
+		cpymo_prefetch_entry *e = p->entries + i;
+		if (e->generation == p->generation) continue;
+
+		if (e->state == cpymo_prefetch_queued) 
+			e->state = cpymo_prefetch_free_slot;
+		else if (e->state == cpymo_prefetch_ready) {
+			if (e->err == CPYMO_ERR_SUCC) p->stats.evicted++;
+			cpymo_prefetch_entry_clear(e);
+		}
+	}
+	cpymo_mutex_unlock(&p->mutex);
+}
+
+void cpymo_prefetch_set_lookahead(struct cpymo_prefetch *p, size_t lines)
+{
+	p->lookahead = lines;
+	p->last_script = NULL;
+}
+
+cpymo_prefetch_stats cpymo_prefetch_get_stats(const struct cpymo_prefetch *p)
+{
+	return p->stats;
+}
+
+#endif
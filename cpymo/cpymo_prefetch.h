@@ -0,0 +1,94 @@
+#ifndef INCLUDE_CPYMO_PREFETCH
+#define INCLUDE_CPYMO_PREFETCH
+
+#include "cpymo_error.h"
+#include "cpymo_str.h"
+#include "cpymo_thread.h"
+#include "cpymo_assetloader.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+// Background image prefetch.
+// After every interpreter step the engine scans the next few script lines
+// for commands that will load images (#bg, #chara, #scroll, #select_img...),
+// and worker threads decode those images into pixel buffers ahead of time.
+// The assetloader takes the decoded pixels out of this cache when the
+// command actually runs, so only the backend upload stays on the main thread.
+
+// stb_leakcheck keeps a global list of allocations and is not thread safe.
+#if !defined CPYMO_NO_THREADS && defined CPYMO_PACKAGE_CONCURRENT_READ \
+	&& !defined DISABLE_STB_IMAGE && !defined DISABLE_ASSET_PREFETCH \
+	&& !defined CPYMO_TOOL && !defined LEAKCHECK
+#define ENABLE_ASSET_PREFETCH
+#endif
+
+#ifndef CPYMO_PREFETCH_LOOKAHEAD
+#define CPYMO_PREFETCH_LOOKAHEAD 32
+#endif
+
+#ifndef CPYMO_PREFETCH_SLOTS
+#define CPYMO_PREFETCH_SLOTS 16
+#endif
+
+#ifndef CPYMO_PREFETCH_WORKERS
+#define CPYMO_PREFETCH_WORKERS 2
+#endif
+
+typedef enum {
+	cpymo_prefetch_bg,
+	cpymo_prefetch_chara,
+	cpymo_prefetch_system
+} cpymo_prefetch_type;
+
+typedef struct {
+	// hits: image was already decoded (or being decoded) when requested.
+	// misses: image had to be decoded on the main thread.
+	// dropped: lookahead found an image but every slot was busy.
+	// evicted: a decoded image went unused and was thrown away.
+	unsigned hits, misses, requested, dropped, evicted;
+} cpymo_prefetch_stats;
+
+struct cpymo_prefetch;
+struct cpymo_interpreter;
+
+#ifdef ENABLE_ASSET_PREFETCH
+
+error_t cpymo_prefetch_create(struct cpymo_prefetch **out, const cpymo_assetloader *loader);
+void cpymo_prefetch_free(struct cpymo_prefetch *p);
+
+void cpymo_prefetch_scan(struct cpymo_prefetch *p, const struct cpymo_interpreter *interpreter);
+void cpymo_prefetch_request(struct cpymo_prefetch *p, cpymo_prefetch_type type, cpymo_str name);
+
+// Moves decoded pixels out of the cache. 
+// Returns false if the image was not prefetched, caller must decode it by itself.
+// Blocks if the image is still being decoded.
+bool cpymo_prefetch_take(
+	struct cpymo_prefetch *p, cpymo_prefetch_type type, cpymo_str name,
+	void **pixels, int *w, int *h,
+	void **mask, int *mw, int *mh);
+
+// Lines scanned after every step, CPYMO_PREFETCH_LOOKAHEAD by default,
+// 0 stops prefetching. The engine reads it from CPYMO_PREFETCH_LOOKAHEAD
+// in the environment.
+void cpymo_prefetch_set_lookahead(struct cpymo_prefetch *p, size_t lines);
+cpymo_prefetch_stats cpymo_prefetch_get_stats(const struct cpymo_prefetch *p);
+
+#else
+
+static inline void cpymo_prefetch_free(struct cpymo_prefetch *p) { (void)p; }
+static inline void cpymo_prefetch_scan(struct cpymo_prefetch *p, const struct cpymo_interpreter *i) 
+{ (void)p; (void)i; }
+
+static inline bool cpymo_prefetch_take(
+	struct cpymo_prefetch *p, cpymo_prefetch_type type, cpymo_str name,
+	void **pixels, int *w, int *h,
+	void **mask, int *mw, int *mh)
+{ 
+	(void)p; (void)type; (void)name; (void)pixels; (void)w; (void)h;
+	(void)mask; (void)mw; (void)mh;
+	return false;
+}
+
+#endif
+
+#endif
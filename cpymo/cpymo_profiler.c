@@ -0,0 +1,189 @@
+﻿#include "cpymo_prelude.h"
+#include "cpymo_profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include "cpymo_thread.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+
+#if !defined _WIN32 && !defined CPYMO_NO_THREADS
+#include <pthread.h>
+#endif
+
+typedef struct {
+	const char *name;
+
+	// NULL for timed events, otherwise duration is the value of a counter.
+	const char *series;
+	uint64_t begin, duration;
+	uint32_t frame;
+	uint32_t tid;
+} cpymo_profiler_event;
+
+static struct {
+	bool inited;
+	uint64_t epoch;
+	uint32_t frame;
+	uint64_t written;
+	cpymo_profiler_event events[CPYMO_PROFILER_EVENTS];
+
+#ifndef CPYMO_NO_THREADS
+	cpymo_mutex mutex;
+#endif
+} cpymo_profiler;
+
+static uint64_t cpymo_profiler_clock(void)
+{
+#if defined _WIN32
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (uint64_t)(now.QuadPart / (double)freq.QuadPart * 1000000.0);
+#elif defined __linux__ || defined __APPLE__
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+#else
+	return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+static uint32_t cpymo_profiler_thread_id(void)
+{
+#if defined CPYMO_NO_THREADS
+	return 0;
+#elif defined _WIN32
+	return (uint32_t)GetCurrentThreadId();
+#else
+	return (uint32_t)(uintptr_t)pthread_self();
+#endif
+}
+
+void cpymo_profiler_init(void)
+{
+	if (cpymo_profiler.inited) return;
+
+#ifndef CPYMO_NO_THREADS
+	if (cpymo_mutex_init(&cpymo_profiler.mutex) != CPYMO_ERR_SUCC) {
+		printf("[Warning] Can not create mutex for profiler.\n");
+		return;
+	}
+#endif
+
+	cpymo_profiler.epoch = cpymo_profiler_clock();
+	cpymo_profiler.frame = 0;
+	cpymo_profiler.written = 0;
+	cpymo_profiler.inited = true;
+}
+
+uint32_t cpymo_profiler_next_frame(void)
+{
+	if (!cpymo_profiler.inited) return 0;
+
+#ifndef CPYMO_NO_THREADS
+	cpymo_mutex_lock(&cpymo_profiler.mutex);
+#endif
+
+	const uint32_t frame = ++cpymo_profiler.frame;
+
+#ifndef CPYMO_NO_THREADS
+	cpymo_mutex_unlock(&cpymo_profiler.mutex);
+#endif
+
+	return frame;
+}
+
+uint64_t cpymo_profiler_now(void)
+{
+	return cpymo_profiler_clock();
+}
+
+static void cpymo_profiler_push(
+	const char *name, const char *series, uint64_t begin_us, uint64_t duration)
+{
+	const uint32_t tid = cpymo_profiler_thread_id();
+
+#ifndef CPYMO_NO_THREADS
+	cpymo_mutex_lock(&cpymo_profiler.mutex);
+#endif
+
+	cpymo_profiler_event *e = 
+		&cpymo_profiler.events[cpymo_profiler.written % CPYMO_PROFILER_EVENTS];
+	e->name = name;
+	e->series = series;
+	e->begin = begin_us - cpymo_profiler.epoch;
+	e->duration = duration;
+	e->frame = cpymo_profiler.frame;
+	e->tid = tid;
+	cpymo_profiler.written++;
+
+#ifndef CPYMO_NO_THREADS
+	cpymo_mutex_unlock(&cpymo_profiler.mutex);
+#endif
+}
+
+void cpymo_profiler_record(const char *name, uint64_t begin_us)
+{
+	if (!cpymo_profiler.inited) return;
+
+	const uint64_t end = cpymo_profiler_clock();
+	cpymo_profiler_push(name, NULL, begin_us, end - begin_us);
+}
+
+void cpymo_profiler_counter(const char *name, const char *series, uint64_t value)
+{
+	if (!cpymo_profiler.inited) return;
+	cpymo_profiler_push(name, series, cpymo_profiler_clock(), value);
+}
+
+error_t cpymo_profiler_dump(const char *path)
+{
+	if (!cpymo_profiler.inited) return CPYMO_ERR_SUCC;
+
+	FILE *file = fopen(path, "w");
+	if (file == NULL) return CPYMO_ERR_CAN_NOT_OPEN_FILE;
+
+#ifndef CPYMO_NO_THREADS
+	cpymo_mutex_lock(&cpymo_profiler.mutex);
+#endif
+
+	const uint64_t count = 
+		cpymo_profiler.written < CPYMO_PROFILER_EVENTS ? 
+		cpymo_profiler.written : CPYMO_PROFILER_EVENTS;
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+	for (uint64_t i = cpymo_profiler.written - count; i < cpymo_profiler.written; ++i) {
+		const cpymo_profiler_event *e = &cpymo_profiler.events[i % CPYMO_PROFILER_EVENTS];
+		if (e->series) fprintf(file,
+			"{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,"
+			"\"ts\":%llu,\"args\":{\"%s\":%llu}}%s\n",
+			e->name,
+			(unsigned long long)e->begin,
+			e->series,
+			(unsigned long long)e->duration,
+			i + 1 < cpymo_profiler.written ? "," : "");
+		else fprintf(file, 
+			"{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+			"\"ts\":%llu,\"dur\":%llu,\"args\":{\"frame\":%u}}%s\n",
+			e->name, 
+			(unsigned)e->tid,
+			(unsigned long long)e->begin, 
+			(unsigned long long)e->duration,
+			(unsigned)e->frame,
+			i + 1 < cpymo_profiler.written ? "," : "");
+	}
+	fputs("]}\n", file);
+
+#ifndef CPYMO_NO_THREADS
+	cpymo_mutex_unlock(&cpymo_profiler.mutex);
+#endif
+
+	fclose(file);
+	printf("[Info] Profiler: %llu events written to %s.\n", 
+		(unsigned long long)count, path);
+	return CPYMO_ERR_SUCC;
+}
+
+#endif
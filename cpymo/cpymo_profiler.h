@@ -0,0 +1,53 @@
+#ifndef INCLUDE_CPYMO_PROFILER
+#define INCLUDE_CPYMO_PROFILER
+
+#include "cpymo_error.h"
+#include <stdint.h>
+
+// Frame profiler, only compiled when ENABLE_PROFILER is defined.
+// CPYMO_PROFILE(name, statement) times a statement and records it into
+// a ring buffer, which can be written as Chrome trace_event JSON
+// (open it in chrome://tracing or https://ui.perfetto.dev).
+// Without ENABLE_PROFILER, CPYMO_PROFILE(name, statement) is just the statement.
+// Counters (cache hits, bytes used...) are recorded into the same buffer
+// and shown as graphs under their name.
+
+#ifdef ENABLE_PROFILER
+
+#ifndef CPYMO_PROFILER_EVENTS
+#define CPYMO_PROFILER_EVENTS 65536
+#endif
+
+#ifndef CPYMO_PROFILER_TRACE_FILE
+#define CPYMO_PROFILER_TRACE_FILE "cpymo_trace.json"
+#endif
+
+// The engine records the counters of its caches every this many frames.
+#ifndef CPYMO_PROFILER_COUNTER_FRAMES
+#define CPYMO_PROFILER_COUNTER_FRAMES 60
+#endif
+
+void cpymo_profiler_init(void);
+
+// Returns the number of the new frame.
+uint32_t cpymo_profiler_next_frame(void);
+
+uint64_t cpymo_profiler_now(void);
+void cpymo_profiler_record(const char *name, uint64_t begin_us);
+void cpymo_profiler_counter(const char *name, const char *series, uint64_t value);
+error_t cpymo_profiler_dump(const char *path);
+
+#define CPYMO_PROFILE(NAME, STATEMENT) \
+	do { \
+		const uint64_t cpymo_profile_begin = cpymo_profiler_now(); \
+		STATEMENT; \
+		cpymo_profiler_record(NAME, cpymo_profile_begin); \
+	} while (0)
+
+#else
+
+#define CPYMO_PROFILE(NAME, STATEMENT) do { STATEMENT; } while (0)
+
+#endif
+
+#endif
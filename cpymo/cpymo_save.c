@@ -23,6 +23,8 @@ error_t cpymo_save_write(cpymo_engine * e, unsigned short save_id)
 	FILE *save = NULL;
 	const char * const empty = "";
 
+	cpymo_engine_load_deferred_assets(e);
+
 	{
 		char save_filename[16];
 		cpymo_save_get_filename(save_filename, save_id);
@@ -418,6 +420,7 @@ error_t cpymo_save_load_savedata(cpymo_engine *e, FILE *save)
 			cpymo_str_pure(strbuf),
 			cpymo_str_pure("BG_NOFADE"),
 			0, 0, 0);
+		cpymo_bg_load_deferred(e);
 
 		e->bg.current_bg_x = (float)CAST(int32_t, bg_params[0]);
 		e->bg.current_bg_y = (float)CAST(int32_t, bg_params[1]);
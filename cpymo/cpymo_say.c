@@ -23,7 +23,9 @@
 		if (ERR == CPYMO_ERR_SUCC) SAY->textbox_usable = true; \
 	}
 
-#define RESET_NAME(SAY) SAY->name = NULL;
+#define RESET_NAME(SAY) \
+	cpymo_name_cache_unref(SAY->name); \
+	SAY->name = NULL;
 
 static void cpymo_say_lazy_init(cpymo_say *out, cpymo_assetloader *loader)
 {
@@ -137,7 +139,7 @@ void cpymo_say_draw(const struct cpymo_engine *e)
 
 		if (e->say.name) {
 			float name_x =
-				namebox_w / 2 - (float)e->say.name_width / 2 + namebox_x;
+				namebox_w / 2 - e->say.name->width / 2 + namebox_x;
 
 			if (e->say.namebox) {
 #ifdef DISABLE_IMAGE_SCALING
@@ -161,7 +163,7 @@ void cpymo_say_draw(const struct cpymo_engine *e)
 			}
 
 			cpymo_backend_text_draw(
-				e->say.name,
+				e->say.name->text,
 				name_x, namebox_y + cpymo_gameconfig_font_size(&e->gameconfig),
 				e->gameconfig.textcolor,
 				e->say.current_say_is_already_read ? 
@@ -344,6 +346,7 @@ static error_t cpymo_say_wait_text_read_callback(cpymo_engine *e)
 	else {
 		DISABLE_TEXTBOX(say);
 		say->active = false;
+		cpymo_engine_request_redraw(e);
 	}
 
 	return CPYMO_ERR_SUCC;
@@ -420,12 +423,11 @@ error_t cpymo_say_start(cpymo_engine *e, cpymo_str name, cpymo_str text)
 	RESET_NAME(say);
 
 	cpymo_str_trim(&name);
-	if (name.len > 0) {
-		error_t err = cpymo_backend_text_create(&say->name, &say->name_width, name, fontsize);
-		if (err != CPYMO_ERR_SUCC) say->name = NULL;
-	}
+	if (name.len > 0)
+		say->name = cpymo_name_cache_get(&e->name_cache, name, fontsize);
 
-	cpymo_backlog_record_write_name(&e->backlog, say->name, name);
+	cpymo_backlog_record_write_name(
+		&e->backlog, cpymo_name_cache_ref(say->name), name);
 
 	// Create say message text
 	float msglr_l = (float)e->gameconfig.msglr_l * e->gameconfig.imagesize_w / 540.0f;
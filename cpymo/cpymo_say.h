@@ -4,6 +4,7 @@
 #include "cpymo_textbox.h"
 #include "cpymo_assetloader.h"
 #include "cpymo_key_hold.h"
+#include "cpymo_name_cache.h"
 
 struct cpymo_engine;
 
@@ -19,8 +20,7 @@ typedef struct {
 
 	bool hide_window;
 
-	cpymo_backend_text name;
-	float name_width;
+	cpymo_name_cache_entry *name;
 
 	cpymo_key_hold key_mouse_button;
 
@@ -1,7 +1,298 @@
 #include "cpymo_prelude.h"
 #include "cpymo_script.h"
+#include "cpymo_parser.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stb_ds.h>
+
+static const char *cpymo_script_op_names[] = {
+#define CPYMO_SCRIPT_OP(NAME) #NAME,
+    CPYMO_SCRIPT_COMMANDS(CPYMO_SCRIPT_OP)
+#undef CPYMO_SCRIPT_OP
+};
+
+const char *cpymo_script_op_name(cpymo_script_op op)
+{
+    if (op == cpymo_op_none) return "(none)";
+    else if (op > cpymo_op_unknown && op < cpymo_op_count) 
+        return cpymo_script_op_names[op - cpymo_op_unknown - 1];
+    else return "(unknown)";
+}
+
+static cpymo_script_op cpymo_script_lookup_op(cpymo_str command)
+{
+    if (command.len == 0) return cpymo_op_none;
+
+    size_t lo = 0, hi = sizeof(cpymo_script_op_names) / sizeof(cpymo_script_op_names[0]);
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const char *name = cpymo_script_op_names[mid];
+        int cmp = strncmp(name, command.begin, command.len);
+        if (cmp == 0 && name[command.len] != '\0') cmp = 1;
+
+        if (cmp == 0) return (cpymo_script_op)(cpymo_op_unknown + 1 + mid);
+        else if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return cpymo_op_unknown;
+}
+
+static void cpymo_script_compile_args(cpymo_script *script, cpymo_parser *parser, cpymo_script_instr *ins)
+{
+    while (!parser->is_line_end) {
+        cpymo_str arg = cpymo_parser_curline_pop_commacell(parser);
+        arrput(script->args, arg);
+        ins->argc++;
+    }
+}
+
+static uint64_t cpymo_script_label_hash(cpymo_str label)
+{
+    uint64_t hash;
+    cpymo_str_hash_init(&hash);
+    cpymo_str_hash_append(&hash, label);
+    return hash;
+}
+
+static inline cpymo_str cpymo_script_label_name(const cpymo_script *script, const cpymo_script_instr *ins)
+{
+    if (ins->argc < 1) return cpymo_str_pure("");
+    return script->args[ins->first_arg];
+}
+
+// Returns true and writes target label if this line is #goto or #if ...,goto.
+static bool cpymo_script_goto_target(const cpymo_script *script, const cpymo_script_instr *ins, cpymo_str *target)
+{
+    if (ins->op == cpymo_op_goto && ins->argc >= 1) {
+        *target = script->args[ins->first_arg];
+        return true;
+    }
+    else if (ins->op == cpymo_op_if && ins->sub_op == cpymo_op_goto) {
+        uint32_t i = 0;
+        while (i + 1 < ins->argc && cpymo_str_equals_str(script->args[ins->first_arg + i + 1], "if"))
+            i += 2;
+
+        if (i + 2 >= ins->argc) return false;
+        *target = script->args[ins->first_arg + i + 2];
+        return true;
+    }
+
+    return false;
+}
+
+static void cpymo_script_build_labels(cpymo_script *script)
+{
+    cpymo_script_label *labels = NULL;
+    char label_name[32];
+
+    for (size_t i = 0; i < script->code_len; ++i) {
+        const cpymo_script_instr *ins = script->code + i;
+        if (ins->op != cpymo_op_label) continue;
+
+        cpymo_str name = cpymo_script_label_name(script, ins);
+        uint64_t hash = cpymo_script_label_hash(name);
+        cpymo_script_label *prev = hmgetp_null(labels, hash);
+        if (prev) {
+            if (cpymo_str_equals(cpymo_script_label_name(script, script->code + prev->line), name)) {
+                cpymo_str_copy(label_name, sizeof(label_name), name);
+                printf("[Warning] Duplicated label %s in script %s.\n",
+                    label_name, script->script_name);
+            }
+
+            prev->ambiguous = true;
+        }
+        else {
+            cpymo_script_label label;
+            label.key = hash;
+            label.line = i;
+            label.ambiguous = false;
+            hmputs(labels, label);
+        }
+    }
+
+    script->labels = labels;
+
+    for (size_t i = 0; i < script->code_len; ++i) {
+        cpymo_str target;
+        size_t line;
+        if (cpymo_script_goto_target(script, script->code + i, &target)
+            && target.len
+            && !cpymo_script_find_label(script, target, i, &line)) {
+            cpymo_str_copy(label_name, sizeof(label_name), target);
+            printf("[Warning] Can not find label %s in script %s.\n",
+                label_name, script->script_name);
+        }
+    }
+}
+
+bool cpymo_script_find_label(
+    cpymo_script *script, cpymo_str label, size_t from_line, size_t *out_line)
+{
+    cpymo_script_label *labels = script->labels;
+    cpymo_script_label *found = hmgetp_null(labels, cpymo_script_label_hash(label));
+    script->labels = labels;
+    if (found == NULL) return false;
+
+    if (!found->ambiguous) {
+        if (!cpymo_str_equals(cpymo_script_label_name(script, script->code + found->line), label))
+            return false;
+
+        *out_line = found->line;
+        return true;
+    }
+
+    // Search lines after from_line first, then wrap to the beginning of script.
+    for (size_t n = 0; n < script->code_len; ++n) {
+        size_t i = (from_line + 1 + n) % script->code_len;
+        const cpymo_script_instr *ins = script->code + i;
+        if (ins->op == cpymo_op_label 
+            && cpymo_str_equals(cpymo_script_label_name(script, ins), label)) {
+            *out_line = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void cpymo_script_compile_operand(cpymo_str s, cpymo_script_operand *out)
+{
+    out->name = s;
+    out->var = 0;
+    out->is_constant = cpymo_vars_is_constant(s);
+    out->constant = out->is_constant ? cpymo_str_atoi(s) : 0;
+}
+
+// Accepts the same expressions as PyMO: <left><op><right>,
+// op is one of =, !=, <>, >, >=, <, <=.
+static void cpymo_script_compile_condition(cpymo_str condition, cpymo_script_condition *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->op = cpymo_script_cond_bad;
+
+    cpymo_str left = condition;
+    left.len = 0;
+
+    while (left.len < condition.len) {
+        char ch = left.begin[left.len];
+        if (ch == '>' || ch == '<' || ch == '=' || ch == '!') 
+            break;
+        left.len++;
+    }
+
+    if (left.len >= condition.len) return;
+
+    cpymo_str op;
+    op.begin = left.begin + left.len;
+    op.len = 1;
+
+    if (op.begin[0] == '!') {
+        op.len++;
+        if (op.len + left.len >= condition.len) return;
+        if (op.begin[1] != '=') return;
+    }
+
+    if (op.begin[0] == '>' || op.begin[0] == '<') {
+        if (op.len + 1 + left.len < condition.len) {
+            if (op.begin[1] == '=')
+                op.len++;
+        }
+    }
+
+    if (op.begin[0] == '<') {
+        if (op.len + 1 + left.len < condition.len) {
+            if (op.begin[1] == '>')
+                op.len++;
+        }
+    }
+
+    cpymo_str right;
+    right.begin = op.begin + op.len;
+    right.len = condition.len - op.len - left.len;
+
+    cpymo_str_trim(&left);
+    cpymo_str_trim(&op);
+    cpymo_str_trim(&right);
+
+    if (left.len == 0 || right.len == 0 || op.len == 0) return;
+
+    if (cpymo_str_equals_str(op, "=")) out->op = cpymo_script_cond_eq;
+    else if (cpymo_str_equals_str(op, "!=") || cpymo_str_equals_str(op, "<>")) 
+        out->op = cpymo_script_cond_ne;
+    else if (cpymo_str_equals_str(op, ">")) out->op = cpymo_script_cond_gt;
+    else if (cpymo_str_equals_str(op, ">=")) out->op = cpymo_script_cond_ge;
+    else if (cpymo_str_equals_str(op, "<")) out->op = cpymo_script_cond_lt;
+    else if (cpymo_str_equals_str(op, "<=")) out->op = cpymo_script_cond_le;
+    else return;
+
+    cpymo_script_compile_operand(left, &out->left);
+    cpymo_script_compile_operand(right, &out->right);
+}
+
+// Splits every line in the same way as cpymo_parser_curline_pop_command 
+// and cpymo_parser_curline_pop_commacell would do at runtime.
+static void cpymo_script_compile(cpymo_script *script)
+{
+    cpymo_script_instr *code = NULL;
+    script->args = NULL;
+    script->conditions = NULL;
+
+    cpymo_parser parser;
+    cpymo_parser_init(&parser, script->script_content, script->script_content_len);
+
+    do {
+        cpymo_script_instr ins;
+        memset(&ins, 0, sizeof(ins));
+        ins.begin = parser.cur_pos;
+
+        const char *line_end = (const char *)memchr(
+            script->script_content + ins.begin, '\n', script->script_content_len - ins.begin);
+        ins.end = line_end ? (size_t)(line_end - script->script_content) : script->script_content_len;
+
+        ins.command = cpymo_parser_curline_pop_command(&parser);
+        ins.op = (uint16_t)cpymo_script_lookup_op(ins.command);
+        ins.first_arg = (uint32_t)arrlenu(script->args);
+
+        if (ins.op == cpymo_op_if) {
+            // Nested #if, such as "#if a=1,if b=2,goto L", 
+            // takes a pair of condition and sub command per level.
+            ins.condition = (uint32_t)arrlenu(script->conditions);
+            do {
+                cpymo_str condition = cpymo_parser_curline_pop_commacell(&parser);
+                while (!parser.is_line_end) {
+                    char ch = cpymo_parser_curline_peek(&parser);
+                    if (ch == ' ' || ch == '\t') cpymo_parser_curline_readchar(&parser);
+                    else break;
+                }
+
+                cpymo_str sub_command = cpymo_parser_curline_readuntil_or(&parser, ' ', '\t');
+                cpymo_str_trim(&sub_command);
+                ins.sub_op = (uint16_t)cpymo_script_lookup_op(sub_command);
+
+                cpymo_script_condition cond;
+                cpymo_script_compile_condition(condition, &cond);
+                arrput(script->conditions, cond);
+
+                arrput(script->args, condition);
+                arrput(script->args, sub_command);
+                ins.argc += 2;
+            } while (ins.sub_op == cpymo_op_if && !parser.is_line_end);
+        }
+
+        if (ins.op != cpymo_op_none)
+            cpymo_script_compile_args(script, &parser, &ins);
+
+        arrput(code, ins);
+    } while (cpymo_parser_next_line(&parser));
+
+    script->code = code;
+    script->code_len = arrlenu(code);
+
+    cpymo_script_build_labels(script);
+}
 
 error_t cpymo_script_load(
     cpymo_script **out, 
@@ -26,6 +317,11 @@ error_t cpymo_script_load(
         return err;
     }
 
+    cpymo_script_compile(script);
+    script->cache = NULL;
+    script->refcount = 0;
+    script->last_used = 0;
+
     *out = script;
     return CPYMO_ERR_SUCC;
 }
@@ -54,13 +350,155 @@ error_t cpymo_script_create_bootloader(cpymo_script **out, char *startscript)
 
 	sprintf(script->script_content, script_format, startscript);
     script->script_content_len = strlen(script->script_content);
+    cpymo_script_compile(script);
+    script->cache = NULL;
+    script->refcount = 0;
+    script->last_used = 0;
     *out = script;
     return CPYMO_ERR_SUCC;
 }
 
 void cpymo_script_free(cpymo_script *to_free)
 {
+    arrfree(to_free->code);
+    arrfree(to_free->args);
+    hmfree(to_free->labels);
+    arrfree(to_free->conditions);
     free(to_free->script_content);
     free(to_free);
 }
 
+
+#ifdef ENABLE_SCRIPT_CACHE
+struct cpymo_script_cache {
+    cpymo_script **scripts;
+    uint64_t tick;
+    cpymo_script_cache_stats stats;
+};
+
+// Counts what the compiled tables have allocated, not only what they use.
+static size_t cpymo_script_size(const cpymo_script *s)
+{
+    return sizeof(*s) + strlen(s->script_name) + 1 + s->script_content_len 
+        + arrcap(s->code) * sizeof(s->code[0])
+        + arrcap(s->args) * sizeof(s->args[0])
+        + hmlenu(s->labels) * sizeof(s->labels[0])
+        + arrcap(s->conditions) * sizeof(s->conditions[0]);
+}
+
+error_t cpymo_script_cache_create(struct cpymo_script_cache **out, size_t budget)
+{
+    struct cpymo_script_cache *c = 
+        (struct cpymo_script_cache *)malloc(sizeof(struct cpymo_script_cache));
+    if (c == NULL) return CPYMO_ERR_OUT_OF_MEM;
+
+    memset(c, 0, sizeof(*c));
+    c->scripts = NULL;
+    c->stats.budget = budget;
+
+    *out = c;
+    return CPYMO_ERR_SUCC;
+}
+
+void cpymo_script_cache_free(struct cpymo_script_cache *c)
+{
+    if (c == NULL) return;
+
+#ifndef NDEBUG
+    printf("[Info] Script cache: %u hits, %u misses, %u evictions.\n",
+        c->stats.hits, c->stats.misses, c->stats.evictions);
+#endif
+
+    for (size_t i = 0; i < arrlenu(c->scripts); ++i) {
+        assert(c->scripts[i]->refcount == 0);
+        cpymo_script_free(c->scripts[i]);
+    }
+
+    arrfree(c->scripts);
+    free(c);
+}
+
+cpymo_script_cache_stats cpymo_script_cache_get_stats(const struct cpymo_script_cache *c)
+{
+    return c->stats;
+}
+
+static void cpymo_script_cache_shrink(struct cpymo_script_cache *c)
+{
+    while (c->stats.idle_bytes > c->stats.budget) {
+        ptrdiff_t lru = -1;
+        for (size_t i = 0; i < arrlenu(c->scripts); ++i) {
+            const cpymo_script *s = c->scripts[i];
+            if (s->refcount == 0 && (lru < 0 || s->last_used < c->scripts[lru]->last_used))
+                lru = (ptrdiff_t)i;
+        }
+
+        if (lru < 0) break;
+
+        cpymo_script *s = c->scripts[lru];
+        c->stats.idle_bytes -= cpymo_script_size(s);
+        c->stats.evictions++;
+        arrdel(c->scripts, (size_t)lru);
+        cpymo_script_free(s);
+    }
+}
+#endif
+
+error_t cpymo_script_acquire(
+    cpymo_script **out,
+    cpymo_str script_name,
+    const cpymo_assetloader *l)
+{
+#ifdef ENABLE_SCRIPT_CACHE
+    struct cpymo_script_cache *c = l->script_cache;
+    if (c) {
+        for (size_t i = 0; i < arrlenu(c->scripts); ++i) {
+            cpymo_script *s = c->scripts[i];
+            if (cpymo_str_equals_str(script_name, s->script_name)) {
+                if (s->refcount == 0) 
+                    c->stats.idle_bytes -= cpymo_script_size(s);
+                s->refcount++;
+                c->stats.hits++;
+                *out = s;
+                return CPYMO_ERR_SUCC;
+            }
+        }
+    }
+#endif
+
+    cpymo_script *s = NULL;
+    error_t err = cpymo_script_load(&s, script_name, l);
+    CPYMO_THROW(err);
+
+    s->refcount = 1;
+
+#ifdef ENABLE_SCRIPT_CACHE
+    if (c) {
+        s->cache = c;
+        arrput(c->scripts, s);
+        c->stats.misses++;
+    }
+#endif
+
+    *out = s;
+    return CPYMO_ERR_SUCC;
+}
+
+void cpymo_script_release(cpymo_script *script)
+{
+#ifdef ENABLE_SCRIPT_CACHE
+    struct cpymo_script_cache *c = script->cache;
+    if (c) {
+        assert(script->refcount > 0);
+        if (--script->refcount == 0) {
+            script->last_used = ++c->tick;
+            c->stats.idle_bytes += cpymo_script_size(script);
+            cpymo_script_cache_shrink(c);
+        }
+
+        return;
+    }
+#endif
+
+    cpymo_script_free(script);
+}
@@ -4,13 +4,137 @@
 #include "cpymo_error.h"
 #include "cpymo_str.h"
 #include "cpymo_assetloader.h"
+#include "cpymo_vars.h"
+#include <stdint.h>
+
+// All commands known by the interpreter, sorted by name.
+#define CPYMO_SCRIPT_COMMANDS(X) \
+    X(add) X(album) X(anime_off) X(anime_on) X(bg) X(bgm) X(bgm_stop) \
+    X(call) X(change) X(chara) X(chara_anime) X(chara_cls) X(chara_down) \
+    X(chara_pos) X(chara_quake) X(chara_scroll) X(chara_up) X(chara_y) \
+    X(config) X(date) X(fade_in) X(fade_out) \
+    X(flash) X(goto) X(if) X(label) X(load) X(movie) X(music) X(quake) \
+    X(rand) X(ret) X(say) X(scroll) X(se) X(se_stop) X(sel) X(select_img) \
+    X(select_imgs) X(select_text) X(select_var) X(set) X(sub) X(text) \
+    X(text_off) X(textbox) X(title) X(title_dsp) X(vo) X(wait) X(wait_se) \
+    X(waitkey)
+
+typedef enum {
+    cpymo_op_none,      // Empty line or text without command.
+    cpymo_op_unknown,
+#define CPYMO_SCRIPT_OP(NAME) cpymo_op_##NAME,
+    CPYMO_SCRIPT_COMMANDS(CPYMO_SCRIPT_OP)
+#undef CPYMO_SCRIPT_OP
+    cpymo_op_count
+} cpymo_script_op;
+
+const char *cpymo_script_op_name(cpymo_script_op op);
+
+// One script line compiled at load time.
+// Arguments are already split by ',' and trimmed,
+// #if stores its condition and the name of sub command
+// as the first two arguments, followed by arguments of sub command.
+typedef struct {
+    size_t begin, end;      // Line content is [begin, end), end points to '\n' or end of script.
+    cpymo_str command;
+    uint32_t first_arg, argc;
+    uint16_t op, sub_op;
+    uint32_t condition;     // Index in conditions for #if.
+} cpymo_script_instr;
+
+typedef enum {
+    cpymo_script_cond_bad,
+    cpymo_script_cond_eq,
+    cpymo_script_cond_ne,
+    cpymo_script_cond_gt,
+    cpymo_script_cond_ge,
+    cpymo_script_cond_lt,
+    cpymo_script_cond_le
+} cpymo_script_cond_op;
+
+typedef struct {
+    cpymo_str name;
+    cpymo_val constant;
+    cpymo_var_id var;
+    bool is_constant;
+} cpymo_script_operand;
+
+// Condition of #if parsed at load time,
+// variables of operands are interned when it runs at the first time.
+// Scripts are cached across engines, so ids are interned again
+// when vars_generation is not the generation of the running cpymo_vars.
+typedef struct {
+    cpymo_script_operand left, right;
+    uint8_t op;
+    uint32_t vars_generation;
+} cpymo_script_condition;
+
+// Label table entry, keyed by hash of label name.
+// Labels sharing one hash (duplicated names or collisions) are marked ambiguous,
+// they are resolved by scanning compiled lines in the same order as PyMO does.
+typedef struct {
+    uint64_t key;
+    size_t line;
+    bool ambiguous;
+} cpymo_script_label;
 
 typedef struct {
     char *script_content;
     size_t script_content_len;
+
+    // Indexed by line number, code[i].begin is also the offset where line i starts.
+    cpymo_script_instr *code;
+    size_t code_len;
+    cpymo_str *args;
+    cpymo_script_label *labels;
+    cpymo_script_condition *conditions;
+
+    // Set when the script is kept by a script cache.
+    struct cpymo_script_cache *cache;
+    uint32_t refcount;
+    uint64_t last_used;
+
     char script_name[];
 } cpymo_script;
 
+// Scripts loaded by #change, #call and save loading are kept in a cache
+// owned by the assetloader, together with their compiled lines, labels and conditions.
+// Scripts still in use are never evicted, scripts no longer used stay cached
+// until their total size exceeds the budget, least recently used first.
+
+#if !defined CPYMO_TOOL && !defined DISABLE_SCRIPT_CACHE
+#define ENABLE_SCRIPT_CACHE
+#endif
+
+#ifndef CPYMO_SCRIPT_CACHE_BUDGET
+#define CPYMO_SCRIPT_CACHE_BUDGET (4 * 1024 * 1024)
+#endif
+
+typedef struct {
+    size_t budget, idle_bytes;
+    unsigned hits, misses, evictions;
+} cpymo_script_cache_stats;
+
+struct cpymo_script_cache;
+
+#ifdef ENABLE_SCRIPT_CACHE
+error_t cpymo_script_cache_create(struct cpymo_script_cache **out, size_t budget);
+void cpymo_script_cache_free(struct cpymo_script_cache *c);
+cpymo_script_cache_stats cpymo_script_cache_get_stats(const struct cpymo_script_cache *c);
+#else
+static inline void cpymo_script_cache_free(struct cpymo_script_cache *c) { (void)c; }
+#endif
+
+// Gets script from cache of the assetloader, loads it if not cached.
+// Scripts from cpymo_script_acquire must be given back with cpymo_script_release.
+error_t cpymo_script_acquire(
+    cpymo_script **out,
+    cpymo_str script_name,
+    const cpymo_assetloader *l);
+
+// Frees the script if it is not cached.
+void cpymo_script_release(cpymo_script *script);
+
 error_t cpymo_script_load(
     cpymo_script **out, 
     cpymo_str script_name, 
@@ -21,4 +145,12 @@ error_t cpymo_script_create_bootloader(
     
 void cpymo_script_free(cpymo_script *to_free);
 
+// Finds the line of #label which #goto on from_line jumps to.
+// Returns false if there is no such label.
+bool cpymo_script_find_label(
+    cpymo_script *script, cpymo_str label, size_t from_line, size_t *out_line);
+
+static inline const cpymo_script_instr *cpymo_script_instr_at(const cpymo_script *script, size_t line)
+{ return line < script->code_len ? script->code + line : NULL; }
+
 #endif
@@ -170,6 +170,59 @@ error_t cpymo_select_img_configuare_select_imgs_selection(cpymo_engine *e, cpymo
 	return CPYMO_ERR_SUCC;
 }
 
+static void cpymo_select_img_request_redraw_hint(cpymo_engine *e, const cpymo_select_img *o)
+{
+	float hint_y = 0.0f, hint_w = 0.0f, hint_h = 0.0f;
+	if (o->show_option_background && o->option_background)
+		hint_y = (float)e->gameconfig.imagesize_h / 4.0f - (float)o->option_background_h / 2.0f;
+
+	for (int i = 0; i < 4; ++i) {
+		if (o->hint[i] == NULL) continue;
+		if ((float)o->hint_w[i] > hint_w) hint_w = (float)o->hint_w[i];
+		if ((float)o->hint_h[i] > hint_h) hint_h = (float)o->hint_h[i];
+	}
+
+	cpymo_engine_request_redraw_rect(e, 0, hint_y, hint_w, hint_h);
+}
+
+static void cpymo_select_img_request_redraw_selection(
+	cpymo_engine *e, const cpymo_select_img *o, int sel)
+{
+	const cpymo_select_img_selection *s = &o->selections[sel];
+
+	if (s->image) {
+		cpymo_engine_request_redraw_rect(
+			e,
+			s->x - (float)s->w / 2.0f,
+			s->y - (float)s->h / 2.0f,
+			(float)s->w,
+			(float)s->h);
+	}
+
+	if (s->or_text) {
+		// Selected text is slightly moved and may be covered by sel_highlight.
+		float pad = (float)s->h / 2.0f;
+		cpymo_engine_request_redraw_rect(
+			e,
+			s->x - pad,
+			s->y - (float)s->h - pad,
+			(float)s->w + 2 * pad,
+			(float)s->h + 2 * pad);
+
+		if (o->sel_highlight) {
+			cpymo_engine_request_redraw_rect(
+				e,
+				(float)s->w / 2.0f - (float)o->sel_highlight_w / 2.0f + s->x,
+				(float)s->h / 2.0f - (float)o->sel_highlight_h / 2.0f + s->y - s->h,
+				(float)o->sel_highlight_w,
+				(float)o->sel_highlight_h);
+		}
+	}
+
+	if (o->hint[0] != NULL)
+		cpymo_select_img_request_redraw_hint(e, o);
+}
+
 static bool cpymo_select_img_wait(struct cpymo_engine *e, float dt)
 {
 	if (cpymo_ui_enabled(e)) return true;
@@ -179,7 +232,7 @@ static bool cpymo_select_img_wait(struct cpymo_engine *e, float dt)
 		if (e->select_img.hint_timer >= 1.0f) {
 			e->select_img.hint_timer -= 1.0f;
 			e->select_img.hint_tiktok = !e->select_img.hint_tiktok;
-			cpymo_engine_request_redraw(e);
+			cpymo_select_img_request_redraw_hint(e, &e->select_img);
 		}
 	}
 
@@ -338,12 +391,13 @@ static error_t cpymo_select_img_ok(cpymo_engine *e, int sel, uint64_t hash, cpym
 error_t cpymo_select_img_update(cpymo_engine *e, cpymo_select_img *o, float dt)
 {
 	if (o->selections) {
+		const int last_selection = o->current_selection;
+
 		cpymo_key_pluse_update(&o->key_up, dt, e->input.up);
 		cpymo_key_pluse_update(&o->key_down, dt, e->input.down);
 
 		if (cpymo_key_pluse_output(&o->key_down)) {
 			cpymo_select_img_move(o, 1);
-			cpymo_engine_request_redraw(e);
 
 			CALL_VISUALLY_PLAY_SOUND(SOUND_SELECT);
 			CALL_VISUALLY_IMPAIRED(o->selections[o->current_selection].original_text);
@@ -351,7 +405,6 @@ error_t cpymo_select_img_update(cpymo_engine *e, cpymo_select_img *o, float dt)
 
 		if (cpymo_key_pluse_output(&o->key_up)) {
 			cpymo_select_img_move(o, -1);
-			cpymo_engine_request_redraw(e);
 
 			CALL_VISUALLY_PLAY_SOUND(SOUND_SELECT);
 			CALL_VISUALLY_IMPAIRED(o->selections[o->current_selection].original_text);
@@ -362,7 +415,6 @@ error_t cpymo_select_img_update(cpymo_engine *e, cpymo_select_img *o, float dt)
 				if (cpymo_select_img_mouse_in_selection(o, i, e)) {
 					if (i != o->current_selection) {
 						o->current_selection = i;
-						cpymo_engine_request_redraw(e);
 
 						CALL_VISUALLY_PLAY_SOUND(SOUND_SELECT);
 						CALL_VISUALLY_IMPAIRED(o->selections[o->current_selection].original_text);
@@ -371,6 +423,11 @@ error_t cpymo_select_img_update(cpymo_engine *e, cpymo_select_img *o, float dt)
 			}
 		}
 
+		if (o->current_selection != last_selection) {
+			cpymo_select_img_request_redraw_selection(e, o, last_selection);
+			cpymo_select_img_request_redraw_selection(e, o, o->current_selection);
+		}
+
 		if (CPYMO_INPUT_JUST_RELEASED(e, ok)) {
 			return cpymo_select_img_ok(e, o->current_selection, o->selections[o->current_selection].hash, o);
 		}
@@ -8,11 +8,36 @@
 #include <cpymo_android.h>
 #endif
 
+// Characters of a finished line are merged into one backend text,
+// so drawing a page takes one draw call per line instead of per character.
+// Backends which space characters differently than they lay out a string
+// should define DISABLE_TEXTBOX_LINE_BATCHING.
+#ifndef DISABLE_TEXTBOX_LINE_BATCHING
+#define ENABLE_TEXTBOX_LINE_BATCHING
+#endif
+
 typedef struct cpymo_textbox_line {
     size_t begin_pool_index, pool_slice_size;
     float y;
+
+#ifdef ENABLE_TEXTBOX_LINE_BATCHING
+    cpymo_str text;
+    cpymo_backend_text merged;
+#endif
 } cpymo_textbox_line;
 
+static void cpymo_textbox_line_reset(cpymo_textbox_line *line, size_t begin_pool_index)
+{
+    line->begin_pool_index = begin_pool_index;
+    line->pool_slice_size = 0;
+
+#ifdef ENABLE_TEXTBOX_LINE_BATCHING
+    line->text.begin = NULL;
+    line->text.len = 0;
+    line->merged = NULL;
+#endif
+}
+
 error_t cpymo_textbox_init(
     cpymo_textbox *o, 
     float x, float y, 
@@ -68,8 +93,7 @@ error_t cpymo_textbox_init(
     o->remain_text = text;
     o->backlog = backlog;
 
-    o->lines[0].begin_pool_index = 0;
-    o->lines[0].pool_slice_size = 0;
+    cpymo_textbox_line_reset(o->lines, 0);
     
     for (size_t i = 0; i < o->max_lines; ++i) {
         o->lines[i].y = o->y + o->char_size * (i + 1);
@@ -92,14 +116,64 @@ static void cpymo_textbox_clear_chars_pool_and_lines(cpymo_textbox *tb)
             cpymo_backend_text_free(tb->chars_pool[i]);
     tb->chars_pool_size = 0;
 
-    tb->active_line = 0;
     if (tb->lines) {
-        tb->lines[0].begin_pool_index = 0;
-        tb->lines[0].pool_slice_size = 0;
+#ifdef ENABLE_TEXTBOX_LINE_BATCHING
+        for (size_t i = 0; i <= tb->active_line; ++i)
+            if (tb->lines[i].merged)
+                cpymo_backend_text_free(tb->lines[i].merged);
+#endif
+
+        cpymo_textbox_line_reset(tb->lines, 0);
     }
+
+    tb->active_line = 0;
     tb->typing_x = tb->x;
 }
 
+#ifdef ENABLE_TEXTBOX_LINE_BATCHING
+// Returns true if characters of the line are replaced by a merged text.
+static bool cpymo_textbox_merge_line(cpymo_textbox *tb, size_t line_id)
+{
+    cpymo_textbox_line *line = tb->lines + line_id;
+    if (line->merged || line->pool_slice_size < 2) return false;
+
+    float w = 0;
+    error_t err = cpymo_backend_text_create(
+        &line->merged, &w, line->text, tb->char_size);
+
+    // Keep drawing it character by character.
+    if (err != CPYMO_ERR_SUCC) {
+        line->merged = NULL;
+        return false;
+    }
+
+    for (size_t i = 0; i < line->pool_slice_size; ++i) {
+        cpymo_backend_text *ch = tb->chars_pool + line->begin_pool_index + i;
+        if (*ch) cpymo_backend_text_free(*ch);
+        *ch = NULL;
+    }
+
+    return true;
+}
+
+static void cpymo_textbox_merge_finished_lines(
+    cpymo_engine *e, cpymo_textbox *tb, bool page_finished)
+{
+    size_t lines = tb->active_line;
+    if (page_finished) lines++;
+
+    float pad = tb->char_size / 4;
+    for (size_t i = 0; i < lines; ++i) {
+        // Merged text may put glyphs at slightly different subpixel positions.
+        if (cpymo_textbox_merge_line(tb, i) && e)
+            cpymo_engine_request_redraw_rect(
+                e,
+                tb->x - pad, tb->lines[i].y - tb->char_size - pad,
+                tb->w + 2 * pad, tb->char_size * 1.5f + 2 * pad);
+    }
+}
+#endif
+
 void cpymo_textbox_free(cpymo_textbox *tb, cpymo_backlog *write_to_backlog)
 {
     cpymo_textbox_clear_chars_pool_and_lines(tb);
@@ -148,6 +222,16 @@ void cpymo_textbox_draw(
 
     for (size_t line_id = 0; line_id <= tb->active_line; ++line_id) {
         const cpymo_textbox_line *line = tb->lines + line_id;
+
+#ifdef ENABLE_TEXTBOX_LINE_BATCHING
+        if (line->merged) {
+            cpymo_backend_text_draw(
+                line->merged, tb->chars_x_pool[line->begin_pool_index], line->y, 
+                tb->col, tb->alpha, drawtype);
+            continue;
+        }
+#endif
+
         for (size_t char_id = 0; char_id < line->pool_slice_size; ++char_id) {
             size_t char_index = char_id + line->begin_pool_index;
             assert(char_index < tb->chars_pool_size);
@@ -170,9 +254,9 @@ static bool cpymo_textbox_nextline(cpymo_textbox *tb)
     if (tb->active_line >= tb->max_lines - 1) return false;
     const cpymo_textbox_line *last_line = tb->lines + tb->active_line;
     tb->active_line++;
-    tb->lines[tb->active_line].begin_pool_index = 
-        last_line->begin_pool_index + last_line->pool_slice_size;
-    tb->lines[tb->active_line].pool_slice_size = 0;
+    cpymo_textbox_line_reset(
+        tb->lines + tb->active_line,
+        last_line->begin_pool_index + last_line->pool_slice_size);
     tb->typing_x = tb->x;
 
     if (tb->backlog_buf) {
@@ -260,7 +344,13 @@ static error_t cpymo_textbox_add_char(cpymo_textbox *tb)
 
     tb->chars_x_pool[tb->chars_pool_size] = tb->typing_x;
     tb->chars_pool_size++;
-    tb->lines[tb->active_line].pool_slice_size++;
+
+    cpymo_textbox_line *line = tb->lines + tb->active_line;
+#ifdef ENABLE_TEXTBOX_LINE_BATCHING
+    if (line->pool_slice_size == 0) line->text.begin = ch.begin;
+    line->text.len += ch.len;
+#endif
+    line->pool_slice_size++;
     tb->typing_x += ch_w;
     tb->remain_text = remain_text;
     return CPYMO_ERR_SUCC;
@@ -277,9 +367,42 @@ TEXT_FADEIN_FINISHED:
     return CPYMO_ERR_NO_MORE_CONTENT;
 }
 
+static void cpymo_textbox_request_redraw_new_char(
+    cpymo_engine *e, const cpymo_textbox *tb, size_t chars_before)
+{
+    // The new character is the last one of the active line.
+    if (tb->chars_pool_size == chars_before) return;
+
+    float pad = tb->char_size / 4;
+    float x = tb->chars_x_pool[chars_before];
+    float baseline = tb->lines[tb->active_line].y;
+    cpymo_engine_request_redraw_rect(
+        e, 
+        x - pad, baseline - tb->char_size - pad, 
+        tb->typing_x - x + 2 * pad, tb->char_size * 1.5f + 2 * pad);
+}
+
+static void cpymo_textbox_request_redraw_cursor(
+    cpymo_engine *e, const cpymo_textbox *tb)
+{
+    float pad = tb->char_size / 4;
+    cpymo_engine_request_redraw_rect(
+        e,
+        tb->w + tb->x - tb->char_size - pad,
+        tb->lines[tb->max_lines - 1].y - tb->char_size - pad,
+        tb->char_size + 2 * pad,
+        tb->char_size + 2 * pad);
+}
+
 void cpymo_textbox_finalize(cpymo_textbox *tb)
 {
     while (cpymo_textbox_add_char(tb) == CPYMO_ERR_SUCC);
+
+#ifdef ENABLE_TEXTBOX_LINE_BATCHING
+    // Callers redraw the whole screen after finalize.
+    cpymo_textbox_merge_finished_lines(NULL, tb, true);
+#endif
+
     tb->timer = 0;
     tb->draw_cursor = true;
 }
@@ -312,11 +435,17 @@ bool cpymo_textbox_wait_text_fadein(cpymo_engine *e, float dt, cpymo_textbox *wh
     error_t err = CPYMO_ERR_SUCC;
     while (which_textbox->timer >= speed) {
         which_textbox->timer -= speed;
+        size_t chars_before = which_textbox->chars_pool_size;
         err = cpymo_textbox_add_char(which_textbox);
         if (err != CPYMO_ERR_SUCC) break;
-        cpymo_engine_request_redraw(e);
+        cpymo_textbox_request_redraw_new_char(e, which_textbox, chars_before);
     }
 
+#ifdef ENABLE_TEXTBOX_LINE_BATCHING
+    cpymo_textbox_merge_finished_lines(
+        e, which_textbox, err == CPYMO_ERR_NO_MORE_CONTENT);
+#endif
+
     if (cpymo_input_foward_key_just_released(e)) {
         cpymo_engine_request_redraw(e);
         cpymo_textbox_finalize(which_textbox);
@@ -348,7 +477,7 @@ bool cpymo_textbox_wait_text_reading(cpymo_engine *e, float dt, cpymo_textbox *t
     while (tb->timer >= 0.5f) {
         tb->timer -= 0.5f;
         tb->draw_cursor = !tb->draw_cursor;
-        cpymo_engine_request_redraw(e);
+        cpymo_textbox_request_redraw_cursor(e, tb);
     }
 #endif
 
@@ -0,0 +1,107 @@
+﻿#include "cpymo_prelude.h"
+#include "cpymo_thread.h"
+#include <stdlib.h>
+
+#if !defined CPYMO_NO_THREADS && !defined _WIN32
+#include <unistd.h>
+#endif
+
+#ifndef CPYMO_NO_THREADS
+
+#ifdef _WIN32
+static DWORD WINAPI cpymo_thread_entry(LPVOID param)
+{
+	cpymo_thread t = (cpymo_thread)param;
+	t->proc(t->arg);
+	return 0;
+}
+#else
+static void *cpymo_thread_entry(void *param)
+{
+	cpymo_thread t = (cpymo_thread)param;
+	t->proc(t->arg);
+	return NULL;
+}
+#endif
+
+error_t cpymo_thread_create(cpymo_thread *out, void (*proc)(void *), void *arg)
+{
+	cpymo_thread t = (cpymo_thread)malloc(sizeof(*t));
+	if (t == NULL) return CPYMO_ERR_OUT_OF_MEM;
+
+	t->proc = proc;
+	t->arg = arg;
+
+#ifdef _WIN32
+	t->handle = CreateThread(NULL, 0, &cpymo_thread_entry, t, 0, NULL);
+	if (t->handle == NULL) {
+		free(t);
+		return CPYMO_ERR_UNKNOWN;
+	}
+#else
+	if (pthread_create(&t->handle, NULL, &cpymo_thread_entry, t) != 0) {
+		free(t);
+		return CPYMO_ERR_UNKNOWN;
+	}
+#endif
+
+	*out = t;
+	return CPYMO_ERR_SUCC;
+}
+
+void cpymo_thread_join(cpymo_thread t)
+{
+#ifdef _WIN32
+	WaitForSingleObject(t->handle, INFINITE);
+	CloseHandle(t->handle);
+#else
+	pthread_join(t->handle, NULL);
+#endif
+	free(t);
+}
+
+#ifdef _WIN32
+error_t cpymo_mutex_init(cpymo_mutex *m) { InitializeCriticalSection(m); return CPYMO_ERR_SUCC; }
+void cpymo_mutex_free(cpymo_mutex *m) { DeleteCriticalSection(m); }
+void cpymo_mutex_lock(cpymo_mutex *m) { EnterCriticalSection(m); }
+void cpymo_mutex_unlock(cpymo_mutex *m) { LeaveCriticalSection(m); }
+
+error_t cpymo_cond_init(cpymo_cond *c) { InitializeConditionVariable(c); return CPYMO_ERR_SUCC; }
+void cpymo_cond_free(cpymo_cond *c) { (void)c; }
+void cpymo_cond_wait(cpymo_cond *c, cpymo_mutex *m) { SleepConditionVariableCS(c, m, INFINITE); }
+void cpymo_cond_signal(cpymo_cond *c) { WakeConditionVariable(c); }
+void cpymo_cond_broadcast(cpymo_cond *c) { WakeAllConditionVariable(c); }
+#else
+error_t cpymo_mutex_init(cpymo_mutex *m) 
+{ return pthread_mutex_init(m, NULL) == 0 ? CPYMO_ERR_SUCC : CPYMO_ERR_UNKNOWN; }
+
+void cpymo_mutex_free(cpymo_mutex *m) { pthread_mutex_destroy(m); }
+void cpymo_mutex_lock(cpymo_mutex *m) { pthread_mutex_lock(m); }
+void cpymo_mutex_unlock(cpymo_mutex *m) { pthread_mutex_unlock(m); }
+
+error_t cpymo_cond_init(cpymo_cond *c) 
+{ return pthread_cond_init(c, NULL) == 0 ? CPYMO_ERR_SUCC : CPYMO_ERR_UNKNOWN; }
+
+void cpymo_cond_free(cpymo_cond *c) { pthread_cond_destroy(c); }
+void cpymo_cond_wait(cpymo_cond *c, cpymo_mutex *m) { pthread_cond_wait(c, m); }
+void cpymo_cond_signal(cpymo_cond *c) { pthread_cond_signal(c); }
+void cpymo_cond_broadcast(cpymo_cond *c) { pthread_cond_broadcast(c); }
+#endif
+
+#endif
+
+unsigned cpymo_thread_hardware_concurrency(void)
+{
+#if defined CPYMO_NO_THREADS
+	return 1;
+#elif defined _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (unsigned)info.dwNumberOfProcessors : 1;
+#elif defined _SC_NPROCESSORS_ONLN
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (unsigned)n : 1;
+#else
+	return 1;
+#endif
+}
@@ -0,0 +1,67 @@
+#ifndef INCLUDE_CPYMO_THREAD
+#define INCLUDE_CPYMO_THREAD
+
+#include "cpymo_error.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Minimal threading primitives for the engine's background workers.
+// Platforms without pthreads or Win32 threads get CPYMO_NO_THREADS defined,
+// and every user of this header must fall back to doing the work inline.
+
+#if defined _WIN32
+#include <windows.h>
+typedef struct { HANDLE handle; void (*proc)(void *); void *arg; } *cpymo_thread;
+typedef CRITICAL_SECTION cpymo_mutex;
+typedef CONDITION_VARIABLE cpymo_cond;
+#elif defined __linux__ || defined __APPLE__ || defined __EMSCRIPTEN_PTHREADS__
+#include <pthread.h>
+typedef struct { pthread_t handle; void (*proc)(void *); void *arg; } *cpymo_thread;
+typedef pthread_mutex_t cpymo_mutex;
+typedef pthread_cond_t cpymo_cond;
+#else
+#define CPYMO_NO_THREADS
+#endif
+
+#if defined DISABLE_THREADS && !defined CPYMO_NO_THREADS
+#define CPYMO_NO_THREADS
+#endif
+
+#ifndef CPYMO_NO_THREADS
+
+error_t cpymo_thread_create(cpymo_thread *out, void (*proc)(void *), void *arg);
+void cpymo_thread_join(cpymo_thread thread);
+
+error_t cpymo_mutex_init(cpymo_mutex *mutex);
+void cpymo_mutex_free(cpymo_mutex *mutex);
+void cpymo_mutex_lock(cpymo_mutex *mutex);
+void cpymo_mutex_unlock(cpymo_mutex *mutex);
+
+error_t cpymo_cond_init(cpymo_cond *cond);
+void cpymo_cond_free(cpymo_cond *cond);
+void cpymo_cond_wait(cpymo_cond *cond, cpymo_mutex *mutex);
+void cpymo_cond_signal(cpymo_cond *cond);
+void cpymo_cond_broadcast(cpymo_cond *cond);
+
+#endif
+
+unsigned cpymo_thread_hardware_concurrency(void);
+
+// Acquire/release access to a size_t shared by two threads without a lock,
+// such as the indices of a single-producer single-consumer ring buffer.
+#if defined CPYMO_NO_THREADS
+static inline size_t cpymo_atomic_load_acquire(const volatile size_t *p) { return *p; }
+static inline void cpymo_atomic_store_release(volatile size_t *p, size_t v) { *p = v; }
+#elif defined _WIN32
+static inline size_t cpymo_atomic_load_acquire(const volatile size_t *p)
+{ size_t v = *p; MemoryBarrier(); return v; }
+static inline void cpymo_atomic_store_release(volatile size_t *p, size_t v)
+{ MemoryBarrier(); *p = v; }
+#else
+static inline size_t cpymo_atomic_load_acquire(const volatile size_t *p)
+{ return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void cpymo_atomic_store_release(volatile size_t *p, size_t v)
+{ __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+#endif
+
+#endif
@@ -1,102 +1,182 @@
 ﻿#include "cpymo_prelude.h"
 #include "cpymo_vars.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <ctype.h>
 #include <stb_ds.h>
 
+// Defined variables of one scope, dense so that saves can enumerate them.
 struct cpymo_var {
-    char *key;
+    const char *key;
     cpymo_val value;
+    cpymo_var_id id;
+};
+
+struct cpymo_var_symbol {
+    char *name;
+    size_t name_len;
+    uint64_t hash;
+    int32_t slot;           // Index in locals or globals, -1 if not defined.
+    int32_t next;           // Next symbol with the same hash, -1 if none.
+};
+
+struct cpymo_var_symbol_index {
+    uint64_t key;
+    int32_t value;          // First symbol with this hash.
 };
 
 void cpymo_vars_init(cpymo_vars *out)
 {
-    struct cpymo_var *p = NULL;
-    sh_new_arena(p);
-    out->locals = (void *)p;
-
-    p = NULL;
-    sh_new_arena(p);
-    out->globals = (void *)p;
+    static uint32_t generation = 0;
+    if (++generation == 0) ++generation;
 
+    out->locals = NULL;
+    out->globals = NULL;
+    out->symbols = NULL;
+    out->symbol_index = NULL;
     out->globals_dirty = false;
+    out->generation = generation;
 }
 
 void cpymo_vars_free(cpymo_vars *to_free)
-{    
+{
     struct cpymo_var *p = (struct cpymo_var *)to_free->globals;
-    if (p) shfree(p);
+    arrfree(p);
 
     p = (struct cpymo_var *)to_free->locals;
-    if (p) shfree(p);
+    arrfree(p);
+
+    struct cpymo_var_symbol *symbols = (struct cpymo_var_symbol *)to_free->symbols;
+    for (size_t i = 0; i < arrlenu(symbols); ++i)
+        free(symbols[i].name);
+    arrfree(symbols);
+
+    struct cpymo_var_symbol_index *index = 
+        (struct cpymo_var_symbol_index *)to_free->symbol_index;
+    hmfree(index);
+
+    cpymo_vars_init(to_free);
 }
 
 static inline bool cpymo_vars_is_global(const char *name)
 { return name[0] == 'S'; }
 
-static cpymo_val *cpymo_vars_access_cstr(
-    cpymo_vars *vars, const char *name)
+error_t cpymo_vars_intern(cpymo_vars *vars, cpymo_str name, cpymo_var_id *out)
 {
-    bool is_global = cpymo_vars_is_global(name);
-    struct cpymo_var **var_slot = 
-        (struct cpymo_var **)(is_global ? &vars->globals : &vars->locals);
+    uint64_t hash;
+    cpymo_str_hash_init(&hash);
+    cpymo_str_hash_append(&hash, name);
+
+    struct cpymo_var_symbol *symbols = (struct cpymo_var_symbol *)vars->symbols;
+    struct cpymo_var_symbol_index *index = 
+        (struct cpymo_var_symbol_index *)vars->symbol_index;
+
+    struct cpymo_var_symbol_index *head = hmgetp_null(index, hash);
+    vars->symbol_index = (void *)index;
+
+    int32_t i = head ? head->value : -1;
+    while (i >= 0) {
+        const struct cpymo_var_symbol *sym = symbols + i;
+        if (sym->name_len == name.len && memcmp(sym->name, name.begin, name.len) == 0) {
+            *out = (cpymo_var_id)i;
+            return CPYMO_ERR_SUCC;
+        }
+
+        i = sym->next;
+    }
+
+    struct cpymo_var_symbol sym;
+    sym.name = cpymo_str_copy_malloc(name);
+    if (sym.name == NULL) return CPYMO_ERR_OUT_OF_MEM;
+    sym.name_len = name.len;
+    sym.hash = hash;
+    sym.slot = -1;
+    sym.next = head ? head->value : -1;
+
+    const int32_t id = (int32_t)arrlenu(symbols);
+    arrput(symbols, sym);
+    vars->symbols = (void *)symbols;
+
+    struct cpymo_var_symbol_index kv;
+    kv.key = hash;
+    kv.value = id;
+    hmputs(index, kv);
+    vars->symbol_index = (void *)index;
+
+    *out = (cpymo_var_id)id;
+    return CPYMO_ERR_SUCC;
+}
 
-    struct cpymo_var *hash_table = *var_slot;
-    
-    struct cpymo_var *r = shgetp_null(hash_table, name);
-    *var_slot = hash_table;
+static inline struct cpymo_var **cpymo_vars_scope(
+    cpymo_vars *vars, const struct cpymo_var_symbol *sym)
+{
+    return (struct cpymo_var **)
+        (cpymo_vars_is_global(sym->name) ? &vars->globals : &vars->locals);
+}
 
-    return r ? &r->value : NULL;
+const cpymo_val *cpymo_vars_access_id(cpymo_vars *vars, cpymo_var_id id)
+{
+    const struct cpymo_var_symbol *sym = (struct cpymo_var_symbol *)vars->symbols + id;
+    if (sym->slot < 0) return NULL;
+    return &(*cpymo_vars_scope(vars, sym))[sym->slot].value;
 }
 
-const cpymo_val *cpymo_vars_access(cpymo_vars *vars, cpymo_str name)
+error_t cpymo_vars_set_id(cpymo_vars *vars, cpymo_var_id id, cpymo_val v)
 {
-    char *cstr = cpymo_str_copy_malloc(name);
-    if (cstr == NULL) return NULL;
+    struct cpymo_var_symbol *sym = (struct cpymo_var_symbol *)vars->symbols + id;
+    struct cpymo_var **scope = cpymo_vars_scope(vars, sym);
+
+    if (sym->slot >= 0) {
+        (*scope)[sym->slot].value = v;
+    }
+    else {
+        struct cpymo_var var;
+        var.key = sym->name;
+        var.value = v;
+        var.id = id;
+        sym->slot = (int32_t)arrlenu(*scope);
+        arrput(*scope, var);
+    }
+
+    if (cpymo_vars_is_global(sym->name)) 
+        vars->globals_dirty = true;
 
-    cpymo_val *r = cpymo_vars_access_cstr(vars, cstr);
-    free(cstr);
-    return r;
+    return CPYMO_ERR_SUCC;
 }
 
-void cpymo_vars_clear_locals(cpymo_vars *vars)
+error_t cpymo_vars_add_id(cpymo_vars *vars, cpymo_var_id id, cpymo_val v)
 {
-    struct cpymo_var *v = (struct cpymo_var *)vars->locals;
-    shfree(v);
-
-    v = NULL;
-    sh_new_arena(v);
-    vars->locals = (void *)v;
+    const cpymo_val *p = cpymo_vars_access_id(vars, id);
+    return cpymo_vars_set_id(vars, id, p ? *p + v : v);
 }
 
-static error_t cpymo_vars_set_cstr(
-    cpymo_vars *vars, const char *name, cpymo_val v)
+const cpymo_val *cpymo_vars_access(cpymo_vars *vars, cpymo_str name)
 {
-    bool is_global = cpymo_vars_is_global(name);
-    struct cpymo_var **var_slot = 
-        (struct cpymo_var **)
-        (is_global ? &vars->globals : &vars->locals);
+    cpymo_var_id id;
+    if (cpymo_vars_intern(vars, name, &id) != CPYMO_ERR_SUCC) return NULL;
+    return cpymo_vars_access_id(vars, id);
+}
 
-    struct cpymo_var *hash_table = *var_slot;
-    shput(hash_table, name, v);
-    *var_slot = hash_table;
+void cpymo_vars_clear_locals(cpymo_vars *vars)
+{
+    struct cpymo_var *locals = (struct cpymo_var *)vars->locals;
+    struct cpymo_var_symbol *symbols = (struct cpymo_var_symbol *)vars->symbols;
 
-    if (is_global) 
-        vars->globals_dirty = true;
+    for (size_t i = 0; i < arrlenu(locals); ++i)
+        symbols[locals[i].id].slot = -1;
 
-    return CPYMO_ERR_SUCC;
+    if (locals) arrsetlen(locals, 0);
+    vars->locals = (void *)locals;
 }
 
 error_t cpymo_vars_set(cpymo_vars *vars, cpymo_str name, cpymo_val v)
 {
-    char *name_cstr = cpymo_str_copy_malloc(name);
-    if (name_cstr == NULL) return CPYMO_ERR_OUT_OF_MEM;
-
-    error_t err = cpymo_vars_set_cstr(vars, name_cstr, v);
-    free(name_cstr);
+    cpymo_var_id id;
+    error_t err = cpymo_vars_intern(vars, name, &id);
+    CPYMO_THROW(err);
 
-    return err;
+    return cpymo_vars_set_id(vars, id, v);
 }
 
 cpymo_val cpymo_vars_get(cpymo_vars *vars, cpymo_str name)
@@ -107,21 +187,11 @@ cpymo_val cpymo_vars_get(cpymo_vars *vars, cpymo_str name)
 
 error_t cpymo_vars_add(cpymo_vars *vars, cpymo_str name, cpymo_val v)
 {
-    error_t err = CPYMO_ERR_SUCC;
-    char *name_cstr = cpymo_str_copy_malloc(name);
-    if (name_cstr == NULL) return CPYMO_ERR_OUT_OF_MEM;
-
-    cpymo_val *p = cpymo_vars_access_cstr(vars, name_cstr);
-
-    if (p) *p += v;
-    else err = cpymo_vars_set_cstr(vars, name_cstr, v);
-
-    if (cpymo_vars_is_global(name_cstr))
-        vars->globals_dirty = true;
-
-    free(name_cstr);
+    cpymo_var_id id;
+    error_t err = cpymo_vars_intern(vars, name, &id);
+    CPYMO_THROW(err);
 
-    return err;
+    return cpymo_vars_add_id(vars, id, v);
 }
 
 bool cpymo_vars_is_constant(cpymo_str expr)
@@ -143,11 +213,8 @@ cpymo_val cpymo_vars_eval(cpymo_vars * vars, cpymo_str expr)
 
 size_t cpymo_vars_count(void **var_field)
 {
-    struct cpymo_var **vars = (struct cpymo_var **)var_field;
-    struct cpymo_var *hash_table = *vars;
-    size_t sz = shlenu(hash_table);
-    *vars = hash_table;
-    return sz;
+    struct cpymo_var *vars = *(struct cpymo_var **)var_field;
+    return arrlenu(vars);
 }
 
 const char *cpymo_vars_get_by_index(void *var_field, size_t index, cpymo_val *v)
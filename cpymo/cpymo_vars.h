@@ -5,9 +5,18 @@
 #include "cpymo_parser.h"
 
 typedef int32_t cpymo_val;
+typedef uint32_t cpymo_var_id;
 
 typedef struct {
 	void *locals, *globals;
+
+	// Every variable name ever used is interned once into an id,
+	// ids stay valid until cpymo_vars_free().
+	// Each init gets a new nonzero generation, so ids cached elsewhere
+	// can tell which variables they were interned into.
+	void *symbols, *symbol_index;
+	uint32_t generation;
+
 	bool globals_dirty;
 } cpymo_vars;
 
@@ -16,6 +25,11 @@ void cpymo_vars_free(cpymo_vars *to_free);
 
 const cpymo_val *cpymo_vars_access(cpymo_vars * vars, cpymo_str name);
 
+error_t cpymo_vars_intern(cpymo_vars *vars, cpymo_str name, cpymo_var_id *out);
+const cpymo_val *cpymo_vars_access_id(cpymo_vars *vars, cpymo_var_id id);
+error_t cpymo_vars_set_id(cpymo_vars *vars, cpymo_var_id id, cpymo_val v);
+error_t cpymo_vars_add_id(cpymo_vars *vars, cpymo_var_id id, cpymo_val v);
+
 void cpymo_vars_clear_locals(cpymo_vars *vars);
 
 cpymo_val cpymo_vars_get(cpymo_vars * vars, cpymo_str name);